@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_ADDRESSABLE_PRIORITY_DQUEUE_HPP
+#define SWAY_ADDRESSABLE_PRIORITY_DQUEUE_HPP
+
+#include <sway/minmaxheap.hpp>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace sway {
+
+/*!
+This template class implements a double-ended priority queue whose elements
+can be modified or removed after insertion.
+push returns a handle that identifies the element until it is removed, after
+which the handle may be reused. The positions of the elements in the
+underlying min-max heap are tracked, so that update and erase take
+O(log N) time.
+If no comparer template parameter is specified, the < operator is used.
+*/
+template<class T,
+		 class Compare = std::less<T> >
+class addressable_priority_dqueue {
+public:
+	typedef std::size_t handle_type;
+private:
+	struct node {
+		T value;
+		handle_type handle;
+	};
+	struct node_compare {
+		Compare comp;
+		node_compare(const Compare & _comp) : comp(_comp) {
+		}
+		bool operator()(const node & a, const node & b) {
+			return comp(a.value, b.value);
+		}
+	};
+	struct position_tracker {
+		std::vector<std::size_t> * positions;
+		position_tracker(std::vector<std::size_t> * _positions)
+			: positions(_positions) {
+		}
+		template<class RAI>
+		void operator()(RAI first, RAI i) const {
+			(*positions)[i->handle] = i - first;
+		}
+	};
+	typedef typename std::vector<node>::iterator iterator;
+	std::vector<node> m_heap;
+	// position in m_heap of the element of each handle
+	std::vector<std::size_t> m_positions;
+	// handles of removed elements, available for reuse
+	std::vector<handle_type> m_free;
+	node_compare m_comp;
+	void remove(iterator i) {
+		iterator last = m_heap.end() - 1;
+		m_free.push_back(i->handle);
+		if (i != last) {
+			node value = std::move(*last);
+			update_hole(m_heap.begin(), last, i, value, m_comp,
+						position_tracker(&m_positions));
+		}
+		m_heap.pop_back();
+	}
+	template<class U>
+	handle_type insert(U && obj) {
+		handle_type handle;
+		if (m_free.empty()) {
+			handle = m_positions.size();
+			m_positions.push_back(0);
+		} else {
+			handle = m_free.back();
+			m_free.pop_back();
+		}
+		node value = { std::forward<U>(obj), handle };
+		m_heap.push_back(std::move(value));
+		value = std::move(m_heap.back());
+		update_hole(m_heap.begin(), m_heap.end(), m_heap.end() - 1, value,
+					m_comp, position_tracker(&m_positions));
+		return handle;
+	}
+	iterator bottom_position() {
+		return max_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+	}
+public:
+	/*!
+	Constructs an empty queue.
+	*/
+	addressable_priority_dqueue(const Compare & comp = Compare())
+		: m_comp(comp) {
+	}
+	/*!
+	Adds a new element to the queue and returns its handle.
+	*/
+	handle_type push(const T & obj) {
+		return insert(obj);
+	}
+	/*!
+	Same as above, moving the new element into the queue.
+	*/
+	handle_type push(T && obj) {
+		return insert(std::move(obj));
+	}
+	/*!
+	Same as push, constructing the new element from the arguments.
+	*/
+	template<class... Args>
+	handle_type emplace(Args &&... args) {
+		return insert(T(std::forward<Args>(args)...));
+	}
+	/*!
+	Replaces the value of the element identified by the handle.
+	The new value can have either a higher or a lower priority.
+	*/
+	void update(handle_type handle, const T & obj) {
+		node value = { obj, handle };
+		update_hole(m_heap.begin(), m_heap.end(),
+					m_heap.begin() + m_positions[handle], value,
+					m_comp, position_tracker(&m_positions));
+	}
+	/*!
+	Removes the element identified by the handle.
+	*/
+	void erase(handle_type handle) {
+		remove(m_heap.begin() + m_positions[handle]);
+	}
+	/*!
+	Returns a reference to the element identified by the handle.
+	*/
+	const T & get(handle_type handle) const {
+		return m_heap[m_positions[handle]].value;
+	}
+	/*!
+	Returns a reference to the highest priority element of the queue.
+	*/
+	const T & top() const {
+		return m_heap[0].value;
+	}
+	/*!
+	Returns the handle of the highest priority element of the queue.
+	*/
+	handle_type top_handle() const {
+		return m_heap[0].handle;
+	}
+	/*!
+	Returns a reference to the lowest priority element of the queue.
+	*/
+	const T & bottom() const {
+		return max_minmaxheap(m_heap.begin(), m_heap.end(), m_comp)->value;
+	}
+	/*!
+	Returns the handle of the lowest priority element of the queue.
+	*/
+	handle_type bottom_handle() const {
+		return max_minmaxheap(m_heap.begin(), m_heap.end(), m_comp)->handle;
+	}
+	/*!
+	Removes the highest priority element of the queue.
+	*/
+	void pop_top() {
+		remove(m_heap.begin());
+	}
+	/*!
+	Removes the lowest priority element of the queue.
+	*/
+	void pop_bottom() {
+		remove(bottom_position());
+	}
+	/*!
+	Removes the highest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_top() {
+		T obj(std::move(m_heap[0].value));
+		remove(m_heap.begin());
+		return obj;
+	}
+	/*!
+	Removes the lowest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_bottom() {
+		iterator i = bottom_position();
+		T obj(std::move(i->value));
+		remove(i);
+		return obj;
+	}
+	/*!
+	Returns the number of elements stored in the queue.
+	*/
+	std::size_t size() const {
+		return m_heap.size();
+	}
+	/*!
+	Returns true if the queue has no elements, false otherwise.
+	*/
+	bool empty() const {
+		return m_heap.empty();
+	}
+};
+
+}
+
+#endif
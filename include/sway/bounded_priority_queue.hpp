@@ -25,7 +25,13 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define SWAY_BOUNDED_PRIORITY_QUEUE_HPP
 
 #include <sway/minmaxheap.hpp>
+#include <sway/instrumentation.hpp>
+#include <sway/snapshot.hpp>
+#include <sway/detail/minmaxheap_simd.hpp>
 #include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace sway {
@@ -35,23 +41,107 @@ This template class is a container adapter, implementing a priority queue with
 a bounded the number of items.
 Once the queue is full, the elements with the smallest priority are dropped.
 The implementation is based on the min-max heap implicit data structure.
-If no container template parameter is specified, a vector is used.
+If no container template parameter is specified, a vector is used; the
+container must provide random access iterators, operator[] and a constructor
+taking the number of elements; with inline_vector a small queue does not
+allocate memory, with mapped_vector a snapshot is restored in place (see
+load).
 If no comparer template parameter is specified, the < operator is used.
+The heap algorithms are provided by the Backend template parameter, which
+defaults to the binary min-max heap (see dary_minmaxheap_backend for the
+D-ary alternative).
+The Instrumentation template parameter can record statistics about the
+operations (see counting_instrumentation); by default nothing is recorded.
+Once the queue is full, the position of its bottom element, the admission
+threshold, is cached, so that rejecting an element costs one comparison.
 */
 template<class T,
 		 class Container = std::vector<T>,
-		 class Compare = std::less<T> >
+		 class Compare = std::less<T>,
+		 class Backend = minmaxheap_backend,
+		 class Instrumentation = null_instrumentation>
 class bounded_priority_queue {
 private:
 	std::size_t m_count;
-	std::vector<T> m_heap;
+	Container m_heap;
 	Compare m_comp;
+	Instrumentation m_instr;
+	// position of the bottom element, valid while the queue is full
+	std::size_t m_bottom;
+	typedef typename Instrumentation::scope scope;
+	// the comparisons locating the bottom are bookkeeping of the adapter,
+	// not of the heap operation: they are not reported
+	void update_bottom() {
+		m_bottom = Backend::max(m_heap.begin(), m_heap.begin() + m_count,
+								m_comp) - m_heap.begin();
+	}
+	template<class U>
+	void insert(U && obj) {
+		scope s(m_instr, op_push);
+		if (m_count == m_heap.size()) {
+			if (m_count == 0) {
+				// a queue of maximum size 0 has no bottom to compare with
+				m_instr.on_push(push_rejected);
+				return;
+			}
+			if (m_instr.compare(m_comp)(obj, m_heap[m_bottom])) {
+				Backend::replacemax(m_heap.begin(), m_heap.end(),
+									std::forward<U>(obj),
+									m_instr.compare(m_comp),
+									m_instr.tracker());
+				update_bottom();
+				m_instr.on_push(push_evicted);
+			} else {
+				m_instr.on_push(push_rejected);
+			}
+		} else {
+			m_heap[m_count] = std::forward<U>(obj);
+			++m_count;
+			Backend::push(m_heap.begin(), m_heap.begin() + m_count,
+						  m_instr.compare(m_comp), m_instr.tracker());
+			if (m_count == m_heap.size()) {
+				update_bottom();
+			}
+			m_instr.on_push(push_inserted);
+		}
+	}
+	template<class InputIterator>
+	void push_full(InputIterator first, InputIterator last,
+				   std::false_type) {
+		for (; first != last; ++first) {
+			push(*first);
+		}
+	}
+	/*
+	Compares blocks of elements with the threshold using vector instructions,
+	pushing only the elements ordered before it.
+	*/
+	template<class RAI>
+	void push_full(RAI first, RAI last, std::true_type) {
+		typedef simd_threshold_filter<RAI, Compare> simd;
+		std::size_t n = last - first;
+		if (n == 0 || m_heap.empty()) {
+			return;
+		}
+		const T * values = &*first;
+		std::size_t i = 0;
+		for (; i + simd::width <= n; i += simd::width) {
+			unsigned mask = simd::mask(values + i, m_heap[m_bottom]);
+			while (mask != 0) {
+				// the threshold may have changed: push checks again
+				push(values[i + simd_next_position(mask)]);
+			}
+		}
+		for (; i < n; ++i) {
+			push(values[i]);
+		}
+	}
 public:
 	/*!
 	Constructs an empty bounded priority queue of the given size.
 	*/
 	bounded_priority_queue(std::size_t size, const Compare & comp = Compare())
-		: m_count(0), m_heap(size), m_comp(comp) {
+		: m_count(0), m_heap(size), m_comp(comp), m_bottom(0) {
 	}
 	/*!
 	Constructs a bounded priority queue containing the items of the
@@ -60,11 +150,9 @@ public:
 	*/
 	bounded_priority_queue(const Container & container,
 						 const Compare & comp = Compare())
-		: m_count(0), m_heap(container.size()), m_comp(comp) {
-		typename Container::const_iterator itr;
-		for (itr = container.begin(); itr != container.end(); ++itr) {
-			push(*itr);
-		}
+		: m_count(0), m_heap(container.size()), m_comp(comp),
+		  m_bottom(0) {
+		push(container.begin(), container.end());
 	}
 	/*!
 	Constructs a bounded priority queue containing some of the items of the
@@ -75,11 +163,8 @@ public:
 	bounded_priority_queue(std::size_t size,
 						 const Container & container,
 						 const Compare & comp = Compare())
-		: m_count(0), m_heap(size), m_comp(comp) {
-		typename Container::const_iterator itr;
-		for (itr = container.begin(); itr != container.end(); ++itr) {
-			push(*itr);
-		}
+		: m_count(0), m_heap(size), m_comp(comp), m_bottom(0) {
+		push(container.begin(), container.end());
 	}
 	/*!
 	Tries to add a new element to the queue.
@@ -90,46 +175,111 @@ public:
 	is inserted.
 	*/
 	void push(const T & obj) {
-		if (m_count == m_heap.size()) {
-			if (m_comp(obj, bottom())) {
-				popmax_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
-				*m_heap.rbegin() = obj;
-				push_minmaxheap(m_heap.begin(),
+		insert(obj);
+	}
+	/*!
+	Same as above, moving the new element into the queue.
+	*/
+	void push(T && obj) {
+		insert(std::move(obj));
+	}
+	/*!
+	Same as push, constructing the new element from the arguments.
+	*/
+	template<class... Args>
+	void emplace(Args &&... args) {
+		insert(T(std::forward<Args>(args)...));
+	}
+	/*!
+	Tries to add the elements in the range [first,last) to the queue.
+	The elements that fit in the free space of the queue are inserted at
+	once, the remaining ones are compared with the bottom element and pushed
+	one by one. If the range is contiguous, holds 32/64 bits integers, float
+	or double values, the comparator is std::less or std::greater and the
+	target supports SSE4.1 or AVX/AVX2, the comparisons with the bottom
+	element are made on blocks of 4 or 8 elements at a time, so that
+	rejecting an element costs a fraction of a vector comparison.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void push(InputIterator first, InputIterator last) {
+		std::size_t count = m_count;
+		for (; first != last && m_count < m_heap.size(); ++first) {
+			m_heap[m_count] = *first;
+			++m_count;
+		}
+		{
+			scope s(m_instr, op_push_range);
+			Backend::push_range(m_heap.begin(),
+								m_heap.begin() + count,
 								m_heap.begin() + m_count,
-								m_comp);
+								m_instr.compare(m_comp),
+								m_instr.tracker());
+			if (m_count == m_heap.size() && m_count != count) {
+				update_bottom();
 			}
-		} else {
-			m_heap[m_count] = obj;
-			++m_count;
-			push_minmaxheap(m_heap.begin(), m_heap.begin() + m_count, m_comp);
 		}
-
+		// instrumented comparators are not vectorized
+		push_full(first, last, std::integral_constant<bool,
+			simd_threshold_filter<InputIterator, Compare>::enabled &&
+			std::is_same<Instrumentation, null_instrumentation>::value>());
 	}
 	/*!
 	Returns a reference to the highest priority element of the queue.
 	*/
 	const T & top() const {
-		return *(min_minmaxheap(m_heap.begin(), m_heap.end(), m_comp));
+		return *(Backend::min(m_heap.begin(), m_heap.begin() + m_count,
+							  m_comp));
 	}
 	/*!
 	Returns a reference to the lowest priority element of the queue.
 	*/
 	const T & bottom() const {
-        return *(max_minmaxheap(m_heap.begin(), m_heap.end(), m_comp));
+		if (m_count < m_heap.size()) {
+			return *(Backend::max(m_heap.begin(), m_heap.begin() + m_count,
+								  m_comp));
+		}
+		return m_heap[m_bottom];
 	}
 	/*!
 	Removes the highest priority element of the queue.
 	*/
 	void pop_top() {
-		popmin_minmaxheap(m_heap.begin(), m_heap.begin() + m_count, m_comp);
+		scope s(m_instr, op_pop_top);
+		Backend::popmin(m_heap.begin(), m_heap.begin() + m_count,
+					   m_instr.compare(m_comp), m_instr.tracker());
 		--m_count;
 	}
 	/*!
 	Removes the lowest priority element of the queue.
 	*/
 	void pop_bottom() {
-		popmax_minmaxheap(m_heap.begin(), m_heap.begin() + m_count, m_comp);
+		scope s(m_instr, op_pop_bottom);
+		Backend::popmax(m_heap.begin(), m_heap.begin() + m_count,
+					   m_instr.compare(m_comp), m_instr.tracker());
+		--m_count;
+	}
+	/*!
+	Removes the highest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_top() {
+		scope s(m_instr, op_pop_top);
+		Backend::popmin(m_heap.begin(), m_heap.begin() + m_count,
+					   m_instr.compare(m_comp), m_instr.tracker());
+		--m_count;
+		return std::move(m_heap[m_count]);
+	}
+	/*!
+	Removes the lowest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_bottom() {
+		scope s(m_instr, op_pop_bottom);
+		Backend::popmax(m_heap.begin(), m_heap.begin() + m_count,
+					   m_instr.compare(m_comp), m_instr.tracker());
 		--m_count;
+		return std::move(m_heap[m_count]);
 	}
 	/*!
 	Returns the number of elements stored in the queue.
@@ -149,6 +299,37 @@ public:
 	bool empty() const {
 		return m_count == 0;
 	}
+	/*!
+	Writes the heap array to a snapshot file at path, with a header holding
+	the number of elements, the maximum size, the size of the elements and
+	a checksum. The elements must be trivially copyable; the file is
+	replaced atomically.
+	*/
+	void save(const std::string & path) const {
+		detail::save_snapshot(path, m_heap.begin(), m_heap.begin() + m_count,
+							  m_heap.size());
+	}
+	/*!
+	Replaces the elements and the maximum size of the queue with those of
+	the snapshot at path, which must have been saved by a queue with the
+	same Compare and Backend: the array is already a heap and is not
+	rebuilt. The elements are read into the container with stdio or, if
+	it is a mapped_vector, the file is mapped and used in place (see
+	restore_bounded_snapshot). Throws snapshot_error if the file is not a
+	valid snapshot of elements of this size, leaving the queue unchanged.
+	*/
+	void load(const std::string & path) {
+		m_count = restore_bounded_snapshot(m_heap, path);
+		if (m_count != 0 && m_count == m_heap.size()) {
+			update_bottom();
+		}
+	}
+	/*!
+	Returns the instrumentation policy, to read the statistics it recorded.
+	*/
+	const Instrumentation & instrumentation() const {
+		return m_instr;
+	}
 };
 
 }
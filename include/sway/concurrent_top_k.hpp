@@ -0,0 +1,204 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_CONCURRENT_TOP_K_HPP
+#define SWAY_CONCURRENT_TOP_K_HPP
+
+#include <sway/bounded_priority_queue.hpp>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace sway {
+
+/*!
+This template class collects the k highest priority elements pushed by
+several threads.
+Each thread pushes into its own shard, a bounded_priority_queue of size k
+aligned to a cache line. The shards share an admission threshold: once a
+shard is full, its lowest priority element bounds the global top-k, and it
+is published if it has a higher priority than the current threshold. Every
+shard keeps a private copy of the threshold, refreshed when the generation
+counter of the collector changes, and rejects the elements that do not have
+a higher priority without any synchronization. Publishing and refreshing
+take a mutex, but happen O(k log(N/k)) times per shard on random streams.
+collect merges the shards into the exact global top-k.
+If no comparer template parameter is specified, the < operator is used.
+*/
+template<class T,
+		 class Compare = std::less<T>,
+		 class Backend = minmaxheap_backend>
+class concurrent_top_k {
+public:
+	static const std::size_t cache_line_size = 64;
+	typedef bounded_priority_queue<T, std::vector<T>, Compare, Backend>
+		queue_type;
+	/*!
+	The part of the collector fed by one thread. A shard must not be used by
+	more than one thread at a time.
+	*/
+	class alignas(cache_line_size) shard {
+	private:
+		friend class concurrent_top_k;
+		concurrent_top_k * m_owner;
+		queue_type m_queue;
+		Compare m_comp;
+		// private copy of the threshold, valid if m_bounded is true
+		T m_threshold;
+		bool m_bounded;
+		std::size_t m_generation;
+		shard(concurrent_top_k * owner)
+			: m_owner(owner), m_queue(owner->m_k, owner->m_comp),
+			  m_comp(owner->m_comp), m_threshold(), m_bounded(false),
+			  m_generation(0) {
+		}
+		void refresh() {
+			std::lock_guard<std::mutex> lock(m_owner->m_mutex);
+			m_threshold = m_owner->m_threshold;
+			m_bounded = m_owner->m_bounded;
+			m_generation = m_owner->m_generation.load(
+				std::memory_order_relaxed);
+		}
+		void publish(const T & bound) {
+			std::lock_guard<std::mutex> lock(m_owner->m_mutex);
+			if (!m_owner->m_bounded || m_comp(bound, m_owner->m_threshold)) {
+				m_owner->m_threshold = bound;
+				m_owner->m_bounded = true;
+				m_owner->m_generation.fetch_add(1, std::memory_order_relaxed);
+			}
+			m_threshold = m_owner->m_threshold;
+			m_bounded = true;
+			m_generation = m_owner->m_generation.load(
+				std::memory_order_relaxed);
+		}
+	public:
+		/*!
+		Tries to add a new element to the shard. It is rejected if it does not
+		have a higher priority than the threshold.
+		*/
+		void push(const T & obj) {
+			// the counter only signals a change, the mutex orders the
+			// accesses to the threshold
+			if (m_owner->m_generation.load(std::memory_order_relaxed)
+				!= m_generation) {
+				refresh();
+			}
+			if (m_bounded && !m_comp(obj, m_threshold)) {
+				return;
+			}
+			m_queue.push(obj);
+			if (m_queue.size() == m_owner->m_k) {
+				const T & bottom = m_queue.bottom();
+				if (!m_bounded || m_comp(bottom, m_threshold)) {
+					publish(bottom);
+				}
+			}
+		}
+		/*!
+		Tries to add the elements in the range [first,last) to the shard.
+		*/
+		template<class InputIterator, class = typename std::enable_if<
+			!std::is_integral<InputIterator>::value>::type>
+		void push(InputIterator first, InputIterator last) {
+			for (; first != last; ++first) {
+				push(*first);
+			}
+		}
+		/*!
+		Returns the number of elements held by the shard.
+		*/
+		std::size_t size() const {
+			return m_queue.size();
+		}
+	};
+private:
+	std::size_t m_k;
+	Compare m_comp;
+	std::vector<shard> m_shards;
+	// written when a shard publishes a new threshold, read by every push
+	alignas(cache_line_size) std::atomic<std::size_t> m_generation;
+	std::mutex m_mutex;
+	T m_threshold;
+	bool m_bounded;
+public:
+	/*!
+	Constructs a collector of the k highest priority elements, with the given
+	number of shards (typically one per thread). k must be positive.
+	*/
+	concurrent_top_k(std::size_t k, std::size_t shards,
+					 const Compare & comp = Compare())
+		: m_k(k), m_comp(comp), m_generation(0), m_threshold(),
+		  m_bounded(false) {
+		m_shards.reserve(shards);
+		for (std::size_t i = 0; i < shards; ++i) {
+			m_shards.push_back(shard(this));
+		}
+	}
+	/*!
+	Returns the i-th shard.
+	*/
+	shard & get_shard(std::size_t i) {
+		return m_shards[i];
+	}
+	/*!
+	Returns the number of shards.
+	*/
+	std::size_t shards() const {
+		return m_shards.size();
+	}
+	/*!
+	Returns the number of elements collected, k.
+	*/
+	std::size_t capacity() const {
+		return m_k;
+	}
+	/*!
+	Returns the k highest priority elements pushed into the shards (or all of
+	them, if fewer were pushed), from the highest priority one.
+	Must not be called while elements are being pushed.
+	*/
+	std::vector<T> collect() const {
+		queue_type merged(m_k, m_comp);
+		for (std::size_t i = 0; i < m_shards.size(); ++i) {
+			queue_type queue(m_shards[i].m_queue);
+			while (!queue.empty()) {
+				merged.push(queue.top());
+				queue.pop_top();
+			}
+		}
+		std::vector<T> result;
+		result.reserve(merged.size());
+		while (!merged.empty()) {
+			result.push_back(merged.top());
+			merged.pop_top();
+		}
+		return result;
+	}
+};
+
+}
+
+#endif
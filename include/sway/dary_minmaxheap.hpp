@@ -0,0 +1,333 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_DARY_MIN_MAX_HEAP_HPP
+#define SWAY_DARY_MIN_MAX_HEAP_HPP
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <sway/detail/dary_minmaxheap.hpp>
+
+namespace sway {
+
+/*!
+Rearranges the values in the range [first,last) as a min-max heap with D
+children per node.
+*/
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void make_dary_minmaxheap(RAI first, RAI last, Compare comp,
+						  Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	if (last - first >= 2) {
+		diff_t offset = (last - first - 2) / D;
+		// the level is looked up once, then tracked while walking backwards
+		std::size_t level = get_dary_level<D>(first, first + offset);
+		diff_t level_first = 0;
+		for (std::size_t l = 0; l < level; ++l) {
+			level_first = level_first * D + 1;
+		}
+		for (RAI i = first + offset; ; --i) {
+			if (i - first < level_first) {
+				--level;
+				level_first = (level_first - 1) / D;
+			}
+			trickle_down_dary<D>(first, last, i, level % 2 == 0, comp, track);
+			if (i == first) {
+				break;
+			}
+		}
+	}
+}
+
+template<unsigned D, class RAI>
+void make_dary_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	make_dary_minmaxheap<D>(first, last, std::less<value_t>());
+}
+
+/*! Returns an iterator pointing to the largest element. */
+template<unsigned D, class RAI, class Compare>
+RAI max_dary_minmaxheap(RAI first, RAI last, Compare comp) {
+	if (last - first < 2) {
+		return first;
+	}
+	return get_dary_best(first + 1,
+						 first + std::min<typename std::iterator_traits<RAI>::
+							 difference_type>(D + 1, last - first),
+						 reverse_compare<Compare>(comp));
+}
+
+template<unsigned D, class RAI>
+RAI max_dary_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	return max_dary_minmaxheap<D>(first, last, std::less<value_t>());
+}
+
+/*! Returns an iterator pointing to the smallest element. */
+template<unsigned D, class RAI, class Compare>
+RAI min_dary_minmaxheap(RAI first, RAI last, Compare comp) {
+	return first;
+}
+
+template<unsigned D, class RAI>
+RAI min_dary_minmaxheap(RAI first, RAI last) {
+	return first;
+}
+
+/*!
+Moves the smallest value in the min-max heap to the end of the sequence,
+shortening the actual min-max heap range by one position.
+*/
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void popmin_dary_minmaxheap(RAI first, RAI last, Compare comp,
+							Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (last - first < 2) {
+		return;
+	}
+	value_t value = std::move(*(last - 1));
+	*(last - 1) = std::move(*first);
+	trickle_down_dary_hole<D>(first, last - 1, first, value, comp, track);
+}
+
+template<unsigned D, class RAI>
+void popmin_dary_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmin_dary_minmaxheap<D>(first, last, std::less<value_t>());
+}
+
+/*!
+Moves the largest value in the min-max heap to the end of the sequence,
+shortening the actual min-max heap range by one position.
+*/
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void popmax_dary_minmaxheap(RAI first, RAI last, Compare comp,
+							Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (last - first < 2) {
+		return;
+	}
+	RAI max = max_dary_minmaxheap<D>(first, last, comp);
+	if (max == last - 1) {
+		// the largest element is already in place
+		return;
+	}
+	value_t value = std::move(*(last - 1));
+	*(last - 1) = std::move(*max);
+	trickle_down_dary_hole<D>(first, last - 1, max, value,
+							  reverse_compare<Compare>(comp), track);
+}
+
+template<unsigned D, class RAI>
+void popmax_dary_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmax_dary_minmaxheap<D>(first, last, std::less<value_t>());
+}
+
+/*!
+Replaces the smallest value of the non-empty min-max heap [first,last) with
+obj, sifting it down once.
+*/
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void replacemin_dary_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj,
+	Compare comp,
+	Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	value_t value(std::move(obj));
+	trickle_down_dary_hole<D>(first, last, first, value, comp, track);
+}
+
+template<unsigned D, class RAI>
+void replacemin_dary_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	replacemin_dary_minmaxheap<D>(first, last, std::move(obj),
+								  std::less<value_t>());
+}
+
+/*!
+Replaces the largest value of the non-empty min-max heap [first,last) with
+obj, sifting it once.
+*/
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void replacemax_dary_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj,
+	Compare comp,
+	Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	value_t value(std::move(obj));
+	RAI max = max_dary_minmaxheap<D>(first, last, comp);
+	if (max == first) {
+		*first = std::move(value);
+		track(first, first);
+		return;
+	}
+	if (comp(value, *first)) {
+		// obj becomes the smallest value, the old one sinks from the max level
+		using std::swap;
+		swap(value, *first);
+		track(first, first);
+	}
+	trickle_down_dary_hole<D>(first, last, max, value,
+							  reverse_compare<Compare>(comp), track);
+}
+
+template<unsigned D, class RAI>
+void replacemax_dary_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	replacemax_dary_minmaxheap<D>(first, last, std::move(obj),
+								  std::less<value_t>());
+}
+
+/*!
+Given a min-max heap on the range [first,last), moves the element in the
+last-1 position to its correct position.
+*/
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void push_dary_minmaxheap(RAI first, RAI last, Compare comp,
+						  Tracker track = Tracker()) {
+	bubble_up_dary<D>(first, last, last - 1, comp, track);
+}
+
+template<unsigned D, class RAI>
+void push_dary_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	push_dary_minmaxheap<D>(first, last, std::less<value_t>());
+}
+
+/*!
+Given a min-max heap on the range [first,middle), makes [first,last) a
+min-max heap by inserting the elements in [middle,last), as
+push_range_minmaxheap does for the binary heap.
+*/
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void push_range_dary_minmaxheap(RAI first, RAI middle, RAI last,
+								Compare comp, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t count = middle - first;
+	diff_t added = last - middle;
+	if (added == 0) {
+		return;
+	}
+	if (count == 0) {
+		make_dary_minmaxheap<D>(first, last, comp, track);
+		return;
+	}
+	std::size_t levels = get_dary_level<D>(first, last - 1) + 1;
+	if (static_cast<std::size_t>(added) <= levels) {
+		for (RAI i = middle + 1; i <= last; ++i) {
+			push_dary_minmaxheap<D>(first, i, comp, track);
+		}
+		return;
+	}
+	diff_t lo = (count - 1) / D;
+	diff_t hi = (count + added - 2) / D;
+	for (;;) {
+		for (diff_t k = hi; k >= lo; --k) {
+			RAI i = first + k;
+			trickle_down_dary<D>(first, last, i,
+								 get_dary_level<D>(first, i) % 2 == 0, comp,
+								 track);
+		}
+		if (lo == 0) {
+			break;
+		}
+		hi = std::min<diff_t>((hi - 1) / D, lo - 1);
+		lo = (lo - 1) / D;
+	}
+}
+
+template<unsigned D, class RAI>
+void push_range_dary_minmaxheap(RAI first, RAI middle, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	push_range_dary_minmaxheap<D>(first, middle, last, std::less<value_t>());
+}
+
+/*!
+Heap backend of the container adapters, forwarding to the D-ary min-max heap
+algorithms above.
+*/
+template<unsigned D>
+struct dary_minmaxheap_backend {
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void make(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
+		make_dary_minmaxheap<D>(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void push(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
+		push_dary_minmaxheap<D>(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void push_range(RAI first, RAI middle, RAI last, Compare comp,
+						   Tracker track = Tracker()) {
+		push_range_dary_minmaxheap<D>(first, middle, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmin(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmin_dary_minmaxheap<D>(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmax(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmax_dary_minmaxheap<D>(first, last, comp, track);
+	}
+	template<class RAI, class T, class Compare, class Tracker = null_tracker>
+	static void replacemin(RAI first, RAI last, T && obj, Compare comp,
+						   Tracker track = Tracker()) {
+		replacemin_dary_minmaxheap<D>(first, last, std::forward<T>(obj),
+									  comp, track);
+	}
+	template<class RAI, class T, class Compare, class Tracker = null_tracker>
+	static void replacemax(RAI first, RAI last, T && obj, Compare comp,
+						   Tracker track = Tracker()) {
+		replacemax_dary_minmaxheap<D>(first, last, std::forward<T>(obj),
+									  comp, track);
+	}
+	template<class RAI, class Compare>
+	static RAI min(RAI first, RAI last, Compare comp) {
+		return min_dary_minmaxheap<D>(first, last, comp);
+	}
+	template<class RAI, class Compare>
+	static RAI max(RAI first, RAI last, Compare comp) {
+		return max_dary_minmaxheap<D>(first, last, comp);
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,224 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Generalization of the min-max heap to D children per node:
+the levels still alternate between min and max levels, and the children of
+the node at offset k are at offsets D*k+1, ..., D*k+D. With D = 4 or 8 the
+tree is two or three times shallower than the binary one, and the children of
+a node are contiguous, though not aligned to cache line boundaries: a group
+of children may straddle two lines.
+*/
+
+#ifndef SWAY_DETAIL_DARY_MIN_MAX_HEAP_HPP
+#define SWAY_DETAIL_DARY_MIN_MAX_HEAP_HPP
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+#include <sway/detail/minmaxheap.hpp>
+
+namespace sway {
+
+template<unsigned D, class RAI>
+std::size_t get_dary_level(RAI first, RAI i) {
+	std::size_t k = static_cast<std::size_t>(i - first);
+	std::size_t level = 0;
+	while (k > 0) {
+		k = (k - 1) / D;
+		++level;
+	}
+	return level;
+}
+
+template<unsigned D, class RAI>
+RAI get_dary_parent(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t diff = i - first;
+	if (diff < 1) {
+		return last;
+	}
+	return first + (diff - 1) / D;
+}
+
+template<unsigned D, class RAI>
+RAI get_dary_grand_parent(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t diff = i - first;
+	if (diff < static_cast<diff_t>(D + 1)) {
+		return last;
+	}
+	return first + ((diff - 1) / D - 1) / D;
+}
+
+/*
+Returns the first best element in [first,last) according to better.
+*/
+template<class RAI, class Better>
+RAI get_dary_best(RAI first, RAI last, Better better) {
+	RAI best = first;
+	for (++first; first < last; ++first) {
+		if (better(*first, *best)) {
+			best = first;
+		}
+	}
+	return best;
+}
+
+/*
+Returns the best child or grandchild of i according to better, or last if i
+has no children. A child that has children of its own cannot be better than
+them, as it lies on a level of the opposite kind: only the grandchildren and
+the children without children have to be inspected.
+*/
+template<unsigned D, class RAI, class Better>
+RAI get_dary_best_child_or_grandchild(RAI first, RAI last, RAI i,
+									  Better better) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t count = last - first;
+	diff_t child = (i - first) * D + 1;
+	if (child >= count) {
+		return last;
+	}
+	diff_t child_end = std::min<diff_t>(child + D, count);
+	diff_t grandchild = child * D + 1;
+	if (grandchild >= count) {
+		return get_dary_best(first + child, first + child_end, better);
+	}
+	diff_t grandchild_end = std::min<diff_t>(grandchild + D * D, count);
+	RAI best = get_dary_best(first + grandchild, first + grandchild_end,
+							 better);
+	// the children after this one have no children
+	diff_t childless = (count - 2) / D + 1;
+	for (diff_t c = std::max(child, childless); c < child_end; ++c) {
+		if (better(*(first + c), *best)) {
+			best = first + c;
+		}
+	}
+	return best;
+}
+
+/*
+The trickle down and bubble up routines below move a hole through the tree,
+as their binary counterparts in detail/minmaxheap.hpp: Better is the
+comparator for min levels and its reverse for max levels, and track is
+called after each write.
+*/
+
+template<unsigned D, class RAI, class T, class Better,
+		 class Tracker = null_tracker>
+void trickle_down_dary_hole(RAI first, RAI last, RAI hole, T & value,
+							Better better, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	for (;;) {
+		RAI m = get_dary_best_child_or_grandchild<D>(first, last, hole, better);
+		if (m == last || !better(*m, value)) {
+			break;
+		}
+		bool grandchild = m - first > (hole - first) * static_cast<diff_t>(D) +
+			static_cast<diff_t>(D);
+		*hole = std::move(*m);
+		track(first, hole);
+		hole = m;
+		if (!grandchild) {
+			break;
+		}
+		RAI parent = get_dary_parent<D>(first, last, hole);
+		if (better(*parent, value)) {
+			using std::swap;
+			swap(*parent, value);
+			track(first, parent);
+		}
+	}
+	*hole = std::move(value);
+	track(first, hole);
+}
+
+template<unsigned D, class RAI, class T, class Better,
+		 class Tracker = null_tracker>
+RAI bubble_up_dary_hole(RAI first, RAI last, RAI hole, T & value,
+						Better better, Tracker track = Tracker()) {
+	RAI gp = get_dary_grand_parent<D>(first, last, hole);
+	while (gp != last && better(value, *gp)) {
+		*hole = std::move(*gp);
+		track(first, hole);
+		hole = gp;
+		gp = get_dary_grand_parent<D>(first, last, hole);
+	}
+	return hole;
+}
+
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void trickle_down_dary(RAI first, RAI last, RAI i, bool min_level,
+					   Compare comp, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if ((i - first) * D + 1 < last - first) {
+		value_t value = std::move(*i);
+		if (min_level) {
+			trickle_down_dary_hole<D>(first, last, i, value, comp, track);
+		} else {
+			trickle_down_dary_hole<D>(first, last, i, value,
+									  reverse_compare<Compare>(comp), track);
+		}
+	}
+}
+
+template<unsigned D, class RAI, class Compare, class Tracker = null_tracker>
+void bubble_up_dary(RAI first, RAI last, RAI i, Compare comp,
+					Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	RAI parent = get_dary_parent<D>(first, last, i);
+	if (parent == last) {
+		return;
+	}
+	value_t value = std::move(*i);
+	RAI hole = i;
+	reverse_compare<Compare> rcomp(comp);
+	if (get_dary_level<D>(first, i) % 2 == 0) {
+		if (comp(*parent, value)) {
+			*hole = std::move(*parent);
+			track(first, hole);
+			hole = bubble_up_dary_hole<D>(first, last, parent, value, rcomp,
+										  track);
+		} else {
+			hole = bubble_up_dary_hole<D>(first, last, hole, value, comp,
+										  track);
+		}
+	} else {
+		if (comp(value, *parent)) {
+			*hole = std::move(*parent);
+			track(first, hole);
+			hole = bubble_up_dary_hole<D>(first, last, parent, value, comp,
+										  track);
+		} else {
+			hole = bubble_up_dary_hole<D>(first, last, hole, value, rcomp,
+										  track);
+		}
+	}
+	*hole = std::move(value);
+	track(first, hole);
+}
+
+}
+
+#endif
@@ -0,0 +1,237 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Sorted runs of elements stored in temporary files, used by the external
+priority_dqueue: a run is read from both ends one block at a time.
+*/
+
+#ifndef SWAY_DETAIL_EXTERNAL_RUN_HPP
+#define SWAY_DETAIL_EXTERNAL_RUN_HPP
+
+#include <sway/detail/file_io.hpp>
+#include <cstddef>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace sway {
+
+/*!
+Thrown by external_priority_dqueue when a temporary file cannot be created,
+written or read.
+*/
+class external_storage_error : public std::runtime_error {
+public:
+	external_storage_error(const std::string & msg) : std::runtime_error(msg) {
+	}
+};
+
+/*!
+Blocks transferred by an external_priority_dqueue.
+*/
+struct external_io_stats {
+	boost::uint64_t blocks_read;
+	boost::uint64_t blocks_written;
+	external_io_stats() : blocks_read(0), blocks_written(0) {
+	}
+};
+
+namespace detail {
+
+/*
+Opens a new temporary file in the directory, or in the default temporary
+directory if empty, deleted when closed (see create_temporary_file).
+*/
+inline file_ptr open_temporary_file(const std::string & directory) {
+	std::FILE * f = create_temporary_file(directory);
+	if (!f) {
+		throw external_storage_error(
+			"Temporary file could not be created in \"" + directory + "\".");
+	}
+	// the runs are read and written in whole blocks: no stdio buffering
+	std::setvbuf(f, 0, _IONBF, 0);
+	return file_ptr(f);
+}
+
+/*
+Elements [first,last) of data: a block of a run loaded in memory.
+*/
+template<class T>
+struct run_block {
+	std::vector<T> data;
+	std::size_t first;
+	std::size_t last;
+	run_block() : first(0), last(0) {
+	}
+	bool empty() const {
+		return first == last;
+	}
+};
+
+/*
+A run of elements sorted by Compare, stored in a file. The elements not
+yet removed are those of the front block, then the unread ones in the file
+[m_next_front,m_next_back), then those of the back block. A block is
+refilled from the file when it becomes empty, so the smallest element is
+in the front block, unless the whole run fits in the back block, and
+the largest in the back block, unless the whole run fits in the front one.
+*/
+template<class T>
+class external_run {
+private:
+	file_ptr m_file;
+	std::size_t m_block;
+	std::size_t m_next_front;
+	std::size_t m_next_back;
+	run_block<T> m_front;
+	run_block<T> m_back;
+	std::size_t m_size;
+	unsigned m_level;
+	void read(std::size_t first, std::size_t count, run_block<T> & b,
+			  external_io_stats & io) {
+		b.data.resize(count);
+		if (!seek_file(m_file.get(),
+					   static_cast<boost::uint64_t>(first) * sizeof(T)) ||
+			std::fread(&b.data[0], sizeof(T), count, m_file.get()) != count) {
+			throw external_storage_error("Run could not be read.");
+		}
+		b.first = 0;
+		b.last = count;
+		++io.blocks_read;
+	}
+	void refill_front(external_io_stats & io) {
+		std::size_t count = std::min(m_block, m_next_back - m_next_front);
+		if (count != 0) {
+			read(m_next_front, count, m_front, io);
+			m_next_front += count;
+		}
+	}
+	void refill_back(external_io_stats & io) {
+		std::size_t count = std::min(m_block, m_next_back - m_next_front);
+		if (count != 0) {
+			read(m_next_back - count, count, m_back, io);
+			m_next_back -= count;
+		}
+	}
+public:
+	/*
+	Takes over a file holding size sorted elements, and reads its first and
+	last blocks.
+	*/
+	external_run(file_ptr && file, std::size_t size, std::size_t block,
+				 unsigned level, external_io_stats & io)
+		: m_file(std::move(file)), m_block(block), m_next_front(0),
+		  m_next_back(size), m_size(size), m_level(level) {
+		refill_front(io);
+		refill_back(io);
+	}
+	const T & min() const {
+		return m_front.empty() ? m_back.data[m_back.first]
+			: m_front.data[m_front.first];
+	}
+	const T & max() const {
+		return m_back.empty() ? m_front.data[m_front.last - 1]
+			: m_back.data[m_back.last - 1];
+	}
+	void pop_min(external_io_stats & io) {
+		--m_size;
+		if (m_front.empty()) {
+			++m_back.first;
+		} else if (++m_front.first == m_front.last) {
+			refill_front(io);
+		}
+	}
+	void pop_max(external_io_stats & io) {
+		--m_size;
+		if (m_back.empty()) {
+			--m_front.last;
+		} else if (--m_back.last == m_back.first) {
+			refill_back(io);
+		}
+	}
+	std::size_t size() const {
+		return m_size;
+	}
+	unsigned level() const {
+		return m_level;
+	}
+};
+
+/*
+Writes sorted elements to a new temporary file, one block at a time.
+*/
+template<class T>
+class run_writer {
+private:
+	file_ptr m_file;
+	std::size_t m_block;
+	std::vector<T> m_buffer;
+	std::size_t m_size;
+	external_io_stats & m_io;
+	void flush() {
+		if (std::fwrite(&m_buffer[0], sizeof(T), m_buffer.size(),
+						m_file.get()) != m_buffer.size()) {
+			throw external_storage_error("Run could not be written.");
+		}
+		m_buffer.clear();
+		++m_io.blocks_written;
+	}
+public:
+	run_writer(const std::string & directory, std::size_t block,
+			   external_io_stats & io)
+		: m_file(open_temporary_file(directory)), m_block(block), m_size(0),
+		  m_io(io) {
+		m_buffer.reserve(block);
+	}
+	void append(const T & obj) {
+		m_buffer.push_back(obj);
+		++m_size;
+		if (m_buffer.size() == m_block) {
+			flush();
+		}
+	}
+	/*
+	Writes the last block and returns the run of the elements written.
+	*/
+	external_run<T> finish(unsigned level) {
+		if (!m_buffer.empty()) {
+			flush();
+		}
+		if (std::fflush(m_file.get()) != 0) {
+			throw external_storage_error("Run could not be written.");
+		}
+		return external_run<T>(std::move(m_file), m_size, m_block, level,
+							   m_io);
+	}
+};
+
+}
+
+}
+
+#endif
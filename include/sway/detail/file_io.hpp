@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Portable helpers for the files of the snapshots and of the external runs:
+the POSIX calls are only made where SWAY_HAS_POSIX is defined.
+*/
+
+#ifndef SWAY_DETAIL_FILE_IO_HPP
+#define SWAY_DETAIL_FILE_IO_HPP
+
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <string>
+#include <boost/cstdint.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SWAY_HAS_POSIX 1
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#elif defined(_MSC_VER)
+#include <atomic>
+#include <process.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+namespace sway {
+
+namespace detail {
+
+struct file_closer {
+	void operator()(std::FILE * f) const {
+		std::fclose(f);
+	}
+};
+
+typedef std::unique_ptr<std::FILE, file_closer> file_ptr;
+
+/*
+Moves to the byte offset from the beginning of the file; returns false if
+the offset does not fit the file offsets of this platform or the seek
+fails. std::fseek is only used where nothing wider is known, as its long
+offset is 32 bits wide on some platforms.
+*/
+inline bool seek_file(std::FILE * f, boost::uint64_t offset) {
+#if defined(SWAY_HAS_POSIX)
+	if (offset > static_cast<boost::uint64_t>(
+			std::numeric_limits<off_t>::max())) {
+		return false;
+	}
+	return ::fseeko(f, static_cast<off_t>(offset), SEEK_SET) == 0;
+#elif defined(_MSC_VER)
+	if (offset > static_cast<boost::uint64_t>(
+			std::numeric_limits<__int64>::max())) {
+		return false;
+	}
+	return ::_fseeki64(f, static_cast<__int64>(offset), SEEK_SET) == 0;
+#else
+	if (offset > static_cast<boost::uint64_t>(
+			std::numeric_limits<long>::max())) {
+		return false;
+	}
+	return std::fseek(f, static_cast<long>(offset), SEEK_SET) == 0;
+#endif
+}
+
+/*
+Stores the length of the file in bytes in size; returns false on failure.
+The file position is left unchanged.
+*/
+inline bool get_file_size(std::FILE * f, boost::uint64_t & size) {
+#if defined(SWAY_HAS_POSIX)
+	struct stat st;
+	if (::fstat(::fileno(f), &st) != 0 || st.st_size < 0) {
+		return false;
+	}
+	size = static_cast<boost::uint64_t>(st.st_size);
+	return true;
+#elif defined(_MSC_VER)
+	struct _stat64 st;
+	if (::_fstat64(::_fileno(f), &st) != 0 || st.st_size < 0) {
+		return false;
+	}
+	size = static_cast<boost::uint64_t>(st.st_size);
+	return true;
+#else
+	long position = std::ftell(f);
+	if (position < 0 || std::fseek(f, 0, SEEK_END) != 0) {
+		return false;
+	}
+	long end = std::ftell(f);
+	if (end < 0 || std::fseek(f, position, SEEK_SET) != 0) {
+		return false;
+	}
+	size = static_cast<boost::uint64_t>(end);
+	return true;
+#endif
+}
+
+/*
+Flushes the file and, where possible, forces its data to the disk.
+*/
+inline bool sync_file(std::FILE * f) {
+	if (std::fflush(f) != 0) {
+		return false;
+	}
+#if defined(SWAY_HAS_POSIX)
+	return ::fsync(::fileno(f)) == 0;
+#else
+	return true;
+#endif
+}
+
+/*
+Creates a new temporary file in the directory, or in the default temporary
+directory if empty; returns null on failure. The file is deleted when
+closed: on POSIX it is unlinked at once, so even if the process dies; with
+Visual C++ it is opened for deletion on close; elsewhere the directory is
+ignored and std::tmpfile is used.
+*/
+inline std::FILE * create_temporary_file(const std::string & directory) {
+	if (directory.empty()) {
+		return std::tmpfile();
+	}
+#if defined(SWAY_HAS_POSIX)
+	std::string name = directory + "/sway-XXXXXX";
+	int fd = ::mkstemp(&name[0]);
+	if (fd == -1) {
+		return 0;
+	}
+	::unlink(name.c_str());
+	std::FILE * f = ::fdopen(fd, "w+b");
+	if (!f) {
+		::close(fd);
+	}
+	return f;
+#elif defined(_MSC_VER)
+	static std::atomic<unsigned long> counter(0);
+	for (int attempt = 0; attempt < 100; ++attempt) {
+		char name[64];
+		std::snprintf(name, sizeof(name), "/sway-%d-%lu", ::_getpid(),
+					  ++counter);
+		// x: fails if the file exists, T: short lived, D: deleted on close
+		std::FILE * f = std::fopen((directory + name).c_str(), "w+bxTD");
+		if (f) {
+			return f;
+		}
+	}
+	return 0;
+#else
+	return std::tmpfile();
+#endif
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Interval heap: the elements are grouped in pairs, node k holding the
+interval [first[2k], first[2k+1]] (the last node may hold a single element),
+and the interval of each node contains the intervals of its children, nodes
+2k+1 and 2k+2. The smallest element is first[0], the largest first[1].
+Removing an end walks a single path of nodes, with one comparison between
+the two children and one with the other end of the node on each level.
+As the min-max heap routines, those below call track(first, i) after
+writing an element to position i.
+*/
+
+#ifndef SWAY_DETAIL_INTERVAL_HEAP_HPP
+#define SWAY_DETAIL_INTERVAL_HEAP_HPP
+
+#include <iterator>
+#include <utility>
+#include <sway/detail/minmaxheap.hpp>
+
+namespace sway {
+
+/*
+Position of the upper end of node k in a heap of count elements: the lower
+end if the node holds a single element.
+*/
+template<class Diff>
+Diff get_interval_high(Diff k, Diff count) {
+	return 2 * k + 1 < count ? 2 * k + 1 : 2 * k;
+}
+
+/*
+Moves the hole at the lower end of node k down to the position of value,
+promoting the smallest lower end of the children. On each node value is
+swapped with the upper end if larger, so that the interval stays ordered.
+*/
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+void trickle_down_interval_min(RAI first, RAI last,
+	typename std::iterator_traits<RAI>::difference_type k, T & value,
+	Compare comp, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t count = last - first;
+	for (;;) {
+		if (2 * k + 1 < count && comp(first[2 * k + 1], value)) {
+			using std::swap;
+			swap(first[2 * k + 1], value);
+			track(first, first + (2 * k + 1));
+		}
+		diff_t child = 2 * k + 1;
+		if (2 * child >= count) {
+			break;
+		}
+		if (2 * child + 2 < count && comp(first[2 * child + 2],
+										  first[2 * child])) {
+			++child;
+		}
+		if (!comp(first[2 * child], value)) {
+			break;
+		}
+		first[2 * k] = std::move(first[2 * child]);
+		track(first, first + 2 * k);
+		k = child;
+	}
+	first[2 * k] = std::move(value);
+	track(first, first + 2 * k);
+}
+
+/*
+Moves the hole at the upper end of node k down to the position of value,
+promoting the largest upper end of the children. On each node value is
+swapped with the lower end if smaller. Node k must hold two elements.
+*/
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+void trickle_down_interval_max(RAI first, RAI last,
+	typename std::iterator_traits<RAI>::difference_type k, T & value,
+	Compare comp, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t count = last - first;
+	for (;;) {
+		if (comp(value, first[2 * k])) {
+			using std::swap;
+			swap(first[2 * k], value);
+			track(first, first + 2 * k);
+		}
+		diff_t child = 2 * k + 1;
+		if (2 * child >= count) {
+			break;
+		}
+		diff_t high = get_interval_high(child, count);
+		if (2 * child + 2 < count) {
+			diff_t other = get_interval_high(child + 1, count);
+			if (comp(first[high], first[other])) {
+				++child;
+				high = other;
+			}
+		}
+		if (!comp(value, first[high])) {
+			break;
+		}
+		first[2 * k + 1] = std::move(first[high]);
+		track(first, first + (2 * k + 1));
+		if (high == 2 * child) {
+			// a node with a single element has no children
+			first[high] = std::move(value);
+			track(first, first + high);
+			return;
+		}
+		k = child;
+	}
+	first[2 * k + 1] = std::move(value);
+	track(first, first + (2 * k + 1));
+}
+
+/*
+Moves value up from the hole at position i, along the lower ends of the
+ancestors of its node, while it is smaller than them.
+*/
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+void bubble_up_interval_min(RAI first,
+	typename std::iterator_traits<RAI>::difference_type i, T & value,
+	Compare comp, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t k = i / 2;
+	while (k > 0) {
+		diff_t parent = (k - 1) / 2;
+		if (!comp(value, first[2 * parent])) {
+			break;
+		}
+		first[i] = std::move(first[2 * parent]);
+		track(first, first + i);
+		i = 2 * parent;
+		k = parent;
+	}
+	first[i] = std::move(value);
+	track(first, first + i);
+}
+
+/*
+Moves value up from the hole at position i, along the upper ends of the
+ancestors of its node, while it is larger than them.
+*/
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+void bubble_up_interval_max(RAI first,
+	typename std::iterator_traits<RAI>::difference_type i, T & value,
+	Compare comp, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t k = i / 2;
+	while (k > 0) {
+		diff_t parent = (k - 1) / 2;
+		if (!comp(first[2 * parent + 1], value)) {
+			break;
+		}
+		first[i] = std::move(first[2 * parent + 1]);
+		track(first, first + i);
+		i = 2 * parent + 1;
+		k = parent;
+	}
+	first[i] = std::move(value);
+	track(first, first + i);
+}
+
+}
+
+#endif
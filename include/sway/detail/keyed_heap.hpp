@@ -0,0 +1,162 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Building blocks of the keyed adapters, which keep a compact heap of keys
+and payload indices, and the payloads in a separate stable array.
+*/
+
+#ifndef SWAY_DETAIL_KEYED_HEAP_HPP
+#define SWAY_DETAIL_KEYED_HEAP_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace sway {
+
+namespace detail {
+
+/*
+Type of the key extracted from a T by KeyOf.
+*/
+template<class T, class KeyOf>
+struct key_type_of {
+	typedef typename std::decay<
+		decltype(std::declval<KeyOf &>()(std::declval<const T &>()))>::type
+		type;
+};
+
+/*
+Element of the heap of a keyed adapter: the key of a payload and the index
+of the payload in its slot_array.
+*/
+template<class Key>
+struct keyed_entry {
+	Key key;
+	boost::uint32_t index;
+};
+
+/*
+Orders the keyed entries by key.
+*/
+template<class Compare>
+struct keyed_entry_compare {
+	Compare comp;
+	keyed_entry_compare(const Compare & _comp) : comp(_comp) {
+	}
+	template<class Key>
+	bool operator()(const keyed_entry<Key> & a,
+					const keyed_entry<Key> & b) {
+		return comp(a.key, b.key);
+	}
+};
+
+/*
+Array of objects addressed by 32 bits indices, which stay valid until the
+object is erased: the objects are stored in chunks of fixed size that are
+never moved, and the erased slots are reused. The slot_array does not know
+which slots are in use: its owner must erase the objects before destroying
+it.
+*/
+template<class T>
+class slot_array {
+private:
+	static const std::size_t chunk_bits = 10;
+	static const std::size_t chunk_size = std::size_t(1) << chunk_bits;
+	union slot {
+		boost::uint32_t next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+	std::vector<std::unique_ptr<slot[]> > m_chunks;
+	// number of slots ever used, the ones after are not in the free list
+	std::size_t m_used;
+	// first free slot, or none
+	boost::uint32_t m_free;
+	static const boost::uint32_t none = ~boost::uint32_t(0);
+	slot & at(boost::uint32_t i) {
+		return m_chunks[i >> chunk_bits][i & (chunk_size - 1)];
+	}
+	const slot & at(boost::uint32_t i) const {
+		return m_chunks[i >> chunk_bits][i & (chunk_size - 1)];
+	}
+	boost::uint32_t acquire() {
+		if (m_free != none) {
+			boost::uint32_t i = m_free;
+			m_free = at(i).next;
+			return i;
+		}
+		if (m_used == m_chunks.size() * chunk_size) {
+			m_chunks.push_back(std::unique_ptr<slot[]>(new slot[chunk_size]));
+		}
+		return static_cast<boost::uint32_t>(m_used++);
+	}
+	void release(boost::uint32_t i) {
+		at(i).next = m_free;
+		m_free = i;
+	}
+public:
+	slot_array() : m_used(0), m_free(none) {
+	}
+	slot_array(const slot_array &) = delete;
+	slot_array & operator=(const slot_array &) = delete;
+	/*
+	Constructs an object from the arguments and returns its index.
+	*/
+	template<class... Args>
+	boost::uint32_t insert(Args &&... args) {
+		boost::uint32_t i = acquire();
+		try {
+			new (at(i).storage) T(std::forward<Args>(args)...);
+		} catch (...) {
+			release(i);
+			throw;
+		}
+		return i;
+	}
+	void erase(boost::uint32_t i) {
+		(*this)[i].~T();
+		release(i);
+	}
+	T & operator[](boost::uint32_t i) {
+		return *reinterpret_cast<T *>(at(i).storage);
+	}
+	const T & operator[](boost::uint32_t i) const {
+		return *reinterpret_cast<const T *>(at(i).storage);
+	}
+	void swap(slot_array & other) {
+		m_chunks.swap(other.m_chunks);
+		std::swap(m_used, other.m_used);
+		std::swap(m_free, other.m_free);
+	}
+};
+
+}
+
+}
+
+#endif
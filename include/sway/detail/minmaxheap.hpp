@@ -33,7 +33,11 @@ Based on the research paper:
 #define SWAY_DETAIL_MIN_MAX_HEAP_HPP
 
 #include <algorithm>
+#include <functional>
+#include <iterator>
+#include <utility>
 #include <sway/ilog2.hpp>
+#include <sway/detail/minmaxheap_simd.hpp>
 
 namespace sway {
 
@@ -86,37 +90,32 @@ RAI get_grand_parent(RAI first, RAI last, RAI i) {
 	return first + (diff-3)/4;
 }
 
-template<class RAI>
-RAI get_smallest_child_or_grandchild(RAI first, RAI last, RAI i) {
-	/* If there are no children, return last */
-	RAI smallest = last;
-	RAI left = get_left_child(first, last, i);
-	if (left < last) {
-		smallest = left;
-		RAI leftLeft = get_left_child(first, last, left);
-		RAI leftRight = get_right_child(first, last, left);
-		if (leftLeft < last && *leftLeft < *smallest) {
-			smallest = leftLeft;
-		}
-		if (leftRight < last && *leftRight < *smallest) {
-			smallest = leftRight;
-		}
+/*!
+Adapts a comparison functor to the reverse ordering.
+*/
+template<class Compare>
+struct reverse_compare {
+	Compare comp;
+	reverse_compare(const Compare & _comp) : comp(_comp) {
 	}
-	RAI right = get_right_child(first, last, i);
-	if (right < last) {
-		if (*right < *smallest) {
-			smallest = right;
-		}
-		RAI rightLeft = get_left_child(first, last, right);
-		RAI rightRight = get_right_child(first, last, right);
-		if (rightLeft < last && *rightLeft < *smallest) {
-			smallest = rightLeft;
-		}
-		if (rightRight < last && *rightRight < *smallest) {
-			smallest = rightRight;
-		}
+	template<class T>
+	bool operator()(const T & a, const T & b) {
+		return comp(b, a);
 	}
-	return smallest;
+};
+
+/*
+Maps a scan position, as returned by simd_children, to the corresponding
+child or grandchild of the node at offset k.
+*/
+template<class RAI>
+RAI get_scan_position(RAI first,
+					  typename std::iterator_traits<RAI>::difference_type k,
+					  int position) {
+	// positions 1, 2, 4 and 5 are grandchildren
+	static const int delta[6] = { 0, 0, 1, 1, 2, 3 };
+	return first + ((0x36 >> position) & 1 ? 4 * k + 3 : 2 * k + 1) +
+		delta[position];
 }
 
 template<class RAI, class Compare>
@@ -124,6 +123,19 @@ RAI get_smallest_child_or_grandchild(RAI first,
 									 RAI last,
 									 RAI i,
 									 Compare comp) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	typedef simd_children<RAI, Compare> simd;
+	if (simd::enabled) {
+		diff_t k = i - first;
+		if (4 * k + 7 <= last - first) {
+			int position = simd::smallest(&*(first + 2 * k + 1),
+										  &*(first + 4 * k + 3));
+			// -1 with a NaN: the scalar scan below decides
+			if (position >= 0) {
+				return get_scan_position(first, k, position);
+			}
+		}
+	}
 	/* If there are no children, return last */
 	RAI smallest = last;
 	RAI left = get_left_child(first, last, i);
@@ -156,40 +168,27 @@ RAI get_smallest_child_or_grandchild(RAI first,
 }
 
 template<class RAI>
-RAI get_largest_child_or_grandchild(RAI first, RAI last, RAI i) {
-	/* If there are no children return last */
-	RAI largest = last;
-	RAI left = get_left_child(first, last, i);
-	if (left < last) {
-		largest = left;
-		RAI leftLeft = get_left_child(first, last, left);
-		RAI leftRight = get_right_child(first, last, left);
-		if (leftLeft < last && *leftLeft > *largest) {
-			largest = leftLeft;
-		}
-		if (leftRight < last && *leftRight > *largest) {
-			largest = leftRight;
-		}
-	}
-	RAI right = get_right_child(first, last, i);
-	if (right < last) {
-		if (*right > *largest) {
-			largest = right;
-		}
-		RAI rightLeft = get_left_child(first, last, right);
-		RAI rightRight = get_right_child(first, last, right);
-		if (rightLeft < last && *rightLeft > *largest) {
-			largest = rightLeft;
-		}
-		if (rightRight < last && *rightRight > *largest) {
-			largest = rightRight;
-		}
-	}
-	return largest;
+RAI get_smallest_child_or_grandchild(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	return get_smallest_child_or_grandchild(first, last, i,
+											std::less<value_t>());
 }
 
 template<class RAI, class Compare>
 RAI get_largest_child_or_grandchild(RAI first, RAI last, RAI i, Compare comp) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	typedef simd_children<RAI, Compare> simd;
+	if (simd::enabled) {
+		diff_t k = i - first;
+		if (4 * k + 7 <= last - first) {
+			int position = simd::largest(&*(first + 2 * k + 1),
+										 &*(first + 4 * k + 3));
+			// -1 with a NaN: the scalar scan below decides
+			if (position >= 0) {
+				return get_scan_position(first, k, position);
+			}
+		}
+	}
 	/* If there are no children return last */
 	RAI largest = last;
 	RAI left = get_left_child(first, last, i);
@@ -222,181 +221,378 @@ RAI get_largest_child_or_grandchild(RAI first, RAI last, RAI i, Compare comp) {
 }
 
 template<class RAI>
-void trickle_down_min(RAI first, RAI last, RAI i) {
-	if (get_left_child(first, last, i) < last) {
-		RAI m = get_smallest_child_or_grandchild(first, last, i);
-		if (get_grand_parent(first, last, m) == i) {
-			if (*m < *i) {
-				std::iter_swap(m, i);
-				RAI parent = get_parent(first, last, m);
-				if (*m > *parent) {
-					std::iter_swap(m, parent);
-				}
-				trickle_down_min(first, last, m);
-			}
-		} else {
-			if (*m < *i) {
-				std::iter_swap(m, i);
-			}
+RAI get_largest_child_or_grandchild(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	return get_largest_child_or_grandchild(first, last, i,
+										   std::less<value_t>());
+}
+
+/*
+The *_hole routines do not swap the sifted element with the ones it passes.
+The element is held in value while a hole, initially at the given position,
+travels through the tree: every element it crosses is moved exactly once, and
+value is moved into the final position of the hole before returning.
+They call track(first, i) after writing an element to position i, so that
+callers can keep track of where each element is; the default tracker does
+nothing.
+If the comparator throws, value is moved into the hole where it stands, so
+that the range keeps all of its elements, although not necessarily as a heap.
+*/
+
+struct null_tracker {
+	template<class RAI>
+	void operator()(RAI first, RAI i) const {
+	}
+};
+
+/*
+Fills the hole with the held value when the scope is left by an exception.
+It refers to the hole iterator of the routine, which keeps it up to date as
+the hole travels; fill writes value on the normal path, release hands the
+hole over to another routine.
+*/
+template<class RAI, class T, class Tracker>
+class hole_guard {
+private:
+	RAI m_first;
+	RAI & m_hole;
+	T * m_value;
+	Tracker & m_track;
+public:
+	hole_guard(RAI first, RAI & hole, T & value, Tracker & track)
+		: m_first(first), m_hole(hole), m_value(&value), m_track(track) {
+	}
+	hole_guard(const hole_guard &) = delete;
+	hole_guard & operator=(const hole_guard &) = delete;
+	~hole_guard() {
+		if (m_value) {
+			fill();
 		}
 	}
-}
+	void fill() {
+		T & value = *m_value;
+		m_value = 0;
+		*m_hole = std::move(value);
+		m_track(m_first, m_hole);
+	}
+	void release() {
+		m_value = 0;
+	}
+};
 
-template<class RAI, class Compare>
-void trickle_down_min(RAI first, RAI last, RAI i, Compare comp) {
-	if (get_left_child(first, last, i) < last) {
-		RAI m = get_smallest_child_or_grandchild(first, last, i, comp);
-		if (get_grand_parent(first, last, m) == i) {
-			if (comp(*m, *i)) {
-				std::iter_swap(m, i);
-				RAI parent = get_parent(first, last, m);
-				if (comp(*parent, *m)) {
-					std::iter_swap(m, parent);
-				}
-				trickle_down_min(first, last, m, comp);
-			}
-		} else {
-			if (comp(*m, *i)) {
-				std::iter_swap(m, i);
-			}
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+void trickle_down_min_hole(RAI first, RAI last, RAI hole, T & value,
+						   Compare comp, Tracker track = Tracker()) {
+	hole_guard<RAI, T, Tracker> guard(first, hole, value, track);
+	while (get_left_child(first, last, hole) < last) {
+		RAI m = get_smallest_child_or_grandchild(first, last, hole, comp);
+		if (!comp(*m, value)) {
+			break;
+		}
+		// m is a grandchild if it lies past the right child of the hole
+		bool grandchild = get_right_child(first, last, hole) < m;
+		*hole = std::move(*m);
+		track(first, hole);
+		hole = m;
+		if (!grandchild) {
+			break;
+		}
+		RAI parent = get_parent(first, last, hole);
+		if (comp(*parent, value)) {
+			using std::swap;
+			swap(*parent, value);
+			track(first, parent);
 		}
 	}
+	guard.fill();
 }
 
-template<class RAI>
-void trickle_down_max(RAI first, RAI last, RAI i) {
-	if (get_left_child(first, last,i) < last) {
-		RAI m = get_largest_child_or_grandchild(first, last, i);
-		if (get_grand_parent(first, last, m) == i) {
-			if (*m > *i) {
-				std::iter_swap(m, i);
-				RAI parent = get_parent(first, last, m);
-				if (*m < *parent) {
-					std::iter_swap(m, parent);
-				}
-				trickle_down_max(first, last, m);
-			}
-		} else {
-			if (*m > *i) {
-				std::iter_swap(m, i);
-			}
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+void trickle_down_max_hole(RAI first, RAI last, RAI hole, T & value,
+						   Compare comp, Tracker track = Tracker()) {
+	hole_guard<RAI, T, Tracker> guard(first, hole, value, track);
+	while (get_left_child(first, last, hole) < last) {
+		RAI m = get_largest_child_or_grandchild(first, last, hole, comp);
+		if (!comp(value, *m)) {
+			break;
+		}
+		// m is a grandchild if it lies past the right child of the hole
+		bool grandchild = get_right_child(first, last, hole) < m;
+		*hole = std::move(*m);
+		track(first, hole);
+		hole = m;
+		if (!grandchild) {
+			break;
+		}
+		RAI parent = get_parent(first, last, hole);
+		if (comp(value, *parent)) {
+			using std::swap;
+			swap(*parent, value);
+			track(first, parent);
 		}
 	}
+	guard.fill();
 }
 
-template<class RAI, class Compare>
-void trickle_down_max(RAI first, RAI last, RAI i, Compare comp) {
-	if (get_left_child(first, last,i) < last) {
-		RAI m = get_largest_child_or_grandchild(first, last, i, comp);
-		if (get_grand_parent(first, last, m) == i) {
-			if (comp(*i, *m)) {
-				std::iter_swap(m, i);
-				RAI parent = get_parent(first, last, m);
-				if (comp(*m, *parent)) {
-					std::iter_swap(m, parent);
-				}
-				trickle_down_max(first, last, m, comp);
-			}
-		} else {
-			if (comp(*i, *m)) {
-				std::iter_swap(m, i);
-			}
-		}
+template<class RAI, class Compare, class Tracker = null_tracker>
+void trickle_down_min(RAI first, RAI last, RAI i, Compare comp,
+					  Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (get_left_child(first, last, i) < last) {
+		value_t value = std::move(*i);
+		trickle_down_min_hole(first, last, i, value, comp, track);
 	}
 }
 
 template<class RAI>
-void trickle_down(RAI first, RAI last, RAI i) {
-	if (get_level(first, last, i) % 2 == 0) {
-		trickle_down_min(first, last, i);
-	} else {
-		trickle_down_max(first, last, i);
+void trickle_down_min(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	trickle_down_min(first, last, i, std::less<value_t>());
+}
+
+template<class RAI, class Compare, class Tracker = null_tracker>
+void trickle_down_max(RAI first, RAI last, RAI i, Compare comp,
+					  Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (get_left_child(first, last, i) < last) {
+		value_t value = std::move(*i);
+		trickle_down_max_hole(first, last, i, value, comp, track);
 	}
 }
 
-template<class RAI, class Compare>
-void trickle_down(RAI first, RAI last, RAI i, Compare comp) {
+template<class RAI>
+void trickle_down_max(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	trickle_down_max(first, last, i, std::less<value_t>());
+}
+
+template<class RAI, class Compare, class Tracker = null_tracker>
+void trickle_down(RAI first, RAI last, RAI i, Compare comp,
+				  Tracker track = Tracker()) {
 	if (get_level(first, last, i) % 2 == 0) {
-		trickle_down_min(first, last, i, comp);
+		trickle_down_min(first, last, i, comp, track);
 	} else {
-		trickle_down_max(first, last, i, comp);
+		trickle_down_max(first, last, i, comp, track);
 	}
 }
 
 template<class RAI>
-void bubble_up_min(RAI first, RAI last, RAI i) {
-	RAI gp = get_grand_parent(first, last, i);
-	if (gp != last && *i < *gp) {
-		std::iter_swap(i, gp);
-		bubble_up_min(first, last, gp);
+void trickle_down(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	trickle_down(first, last, i, std::less<value_t>());
+}
+
+/*
+The bubble_up_*_hole routines return the final position of the hole, leaving
+it to the caller to move value into it.
+*/
+
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+RAI bubble_up_min_hole(RAI first, RAI last, RAI hole, T & value,
+					   Compare comp, Tracker track = Tracker()) {
+	hole_guard<RAI, T, Tracker> guard(first, hole, value, track);
+	RAI gp = get_grand_parent(first, last, hole);
+	while (gp != last && comp(value, *gp)) {
+		*hole = std::move(*gp);
+		track(first, hole);
+		hole = gp;
+		gp = get_grand_parent(first, last, hole);
 	}
+	guard.release();
+	return hole;
 }
 
-template<class RAI, class Compare>
-void bubble_up_min(RAI first, RAI last, RAI i, Compare comp) {
-	RAI gp = get_grand_parent(first, last, i);
-	if (gp != last && comp(*i, *gp)) {
-		std::iter_swap(i, gp);
-		bubble_up_min(first, last, gp, comp);
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+RAI bubble_up_max_hole(RAI first, RAI last, RAI hole, T & value,
+					   Compare comp, Tracker track = Tracker()) {
+	hole_guard<RAI, T, Tracker> guard(first, hole, value, track);
+	RAI gp = get_grand_parent(first, last, hole);
+	while (gp != last && comp(*gp, value)) {
+		*hole = std::move(*gp);
+		track(first, hole);
+		hole = gp;
+		gp = get_grand_parent(first, last, hole);
 	}
+	guard.release();
+	return hole;
+}
+
+template<class RAI, class Compare, class Tracker = null_tracker>
+void bubble_up_min(RAI first, RAI last, RAI i, Compare comp,
+				   Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	value_t value = std::move(*i);
+	RAI hole = bubble_up_min_hole(first, last, i, value, comp, track);
+	*hole = std::move(value);
+	track(first, hole);
+}
+
+template<class RAI>
+void bubble_up_min(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	bubble_up_min(first, last, i, std::less<value_t>());
+}
+
+template<class RAI, class Compare, class Tracker = null_tracker>
+void bubble_up_max(RAI first, RAI last, RAI i, Compare comp,
+				   Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	value_t value = std::move(*i);
+	RAI hole = bubble_up_max_hole(first, last, i, value, comp, track);
+	*hole = std::move(value);
+	track(first, hole);
 }
 
 template<class RAI>
 void bubble_up_max(RAI first, RAI last, RAI i) {
-	RAI gp = get_grand_parent(first, last, i);
-	if (gp != last && *i > *gp) {
-		std::iter_swap(i, gp);
-		bubble_up_max(first, last, gp);
-	}
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	bubble_up_max(first, last, i, std::less<value_t>());
 }
 
-template<class RAI, class Compare>
-void bubble_up_max(RAI first, RAI last, RAI i, Compare comp) {
-	RAI gp = get_grand_parent(first, last, i);
-	if (gp != last && comp(*gp, *i)) {
-		std::iter_swap(i, gp);
-		bubble_up_max(first, last, gp, comp);
+/*
+Moves the hole at position hole up to where value belongs, checking the
+parent first and then climbing the min or max levels. Returns the final
+position of the hole.
+*/
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+RAI bubble_up_hole(RAI first, RAI last, RAI hole, T & value, Compare comp,
+				   Tracker track = Tracker()) {
+	RAI parent = get_parent(first, last, hole);
+	if (parent == last) {
+		return hole;
+	}
+	hole_guard<RAI, T, Tracker> guard(first, hole, value, track);
+	bool min_level = get_level(first, last, hole) % 2 == 0;
+	if (min_level ? comp(*parent, value) : comp(value, *parent)) {
+		*hole = std::move(*parent);
+		track(first, hole);
+		hole = parent;
+		min_level = !min_level;
+	}
+	// the climb below guards the hole from here
+	guard.release();
+	if (min_level) {
+		return bubble_up_min_hole(first, last, hole, value, comp, track);
+	} else {
+		return bubble_up_max_hole(first, last, hole, value, comp, track);
 	}
 }
 
+template<class RAI, class Compare, class Tracker = null_tracker>
+void bubble_up(RAI first, RAI last, RAI i, Compare comp,
+			   Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (get_parent(first, last, i) == last) {
+		return;
+	}
+	value_t value = std::move(*i);
+	RAI hole = bubble_up_hole(first, last, i, value, comp, track);
+	*hole = std::move(value);
+	track(first, hole);
+}
 
 template<class RAI>
 void bubble_up(RAI first, RAI last, RAI i) {
-	RAI parent = get_parent(first, last, i);
-	if (get_level(first, last, i) % 2 == 0) {
-		if (parent != last && *i > *parent) {
-			std::iter_swap(i, parent);
-			bubble_up_max(first, last, parent);
-		} else {
-			bubble_up_min(first, last, i);
-		}
-	} else {
-		if (parent != last && *i < *parent) {
-			std::iter_swap(i, parent);
-			bubble_up_min(first, last, parent);
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	bubble_up(first, last, i, std::less<value_t>());
+}
+
+/*
+Moves the hole at position hole down to a leaf, following the best child or
+grandchild according to better (the comparator on min levels, its reverse
+on max levels) without comparing against value, which will fill the hole.
+Used by the bottom-up removals, which then bubble the value up from the
+leaf: the value usually belongs near the bottom, so this saves most of the
+comparisons against it. Returns the final position of the hole.
+*/
+template<class RAI, class T, class Better, class Tracker = null_tracker>
+RAI trickle_down_bottom_up_hole(RAI first, RAI last, RAI hole, T & value,
+								Better better, Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	hole_guard<RAI, T, Tracker> guard(first, hole, value, track);
+	diff_t count = last - first;
+	for (;;) {
+		diff_t k = hole - first;
+		RAI m;
+		if (4 * k + 6 < count) {
+			// all four grandchildren exist, hence both children have children
+			// and cannot be better than them
+			RAI g = first + (4 * k + 3);
+			RAI a = better(*(g + 1), *g) ? g + 1 : g;
+			RAI b = better(*(g + 3), *(g + 2)) ? g + 3 : g + 2;
+			m = better(*b, *a) ? b : a;
 		} else {
-			bubble_up_max(first, last, i);
+			m = get_smallest_child_or_grandchild(first, last, hole, better);
+			if (m == last) {
+				break;
+			}
+			if (m - first <= 2 * k + 2) {
+				RAI c = get_left_child(first, last, m);
+				if (c == last) {
+					*hole = std::move(*m);
+					track(first, hole);
+					hole = m;
+					break;
+				}
+				// a child with children is only selected when it is equal to
+				// all of its descendants: move on to one of them
+				m = c;
+			}
 		}
+		*hole = std::move(*m);
+		track(first, hole);
+		hole = m;
 	}
+	guard.release();
+	return hole;
 }
 
-template<class RAI, class Compare>
-void bubble_up(RAI first, RAI last, RAI i, Compare comp) {
-	RAI parent = get_parent(first, last, i);
-	if (get_level(first, last, i) % 2 == 0) {
-		if (parent != last && comp(*parent, *i)) {
-			std::iter_swap(i, parent);
-			bubble_up_max(first, last, parent, comp);
+/*
+Moves value, which replaces the element at position hole, to its correct
+position. If value does not fit between the parent and the grandparent of
+the hole, it belongs to the levels of the parent: it climbs them, while the
+parent is moved into the hole and sifted down its subtree. Otherwise value
+either climbs the levels of the hole or trickles down from it.
+*/
+template<class RAI, class T, class Compare, class Tracker = null_tracker>
+void update_hole(RAI first, RAI last, RAI hole, T & value, Compare comp,
+				 Tracker track = Tracker()) {
+	bool min_level = get_level(first, last, hole) % 2 == 0;
+	RAI parent = get_parent(first, last, hole);
+	hole_guard<RAI, T, Tracker> guard(first, hole, value, track);
+	if (parent != last &&
+		(min_level ? comp(*parent, value) : comp(value, *parent))) {
+		T moved = std::move(*parent);
+		guard.release();
+		// while value climbs from the parent, moved waits for the hole
+		hole_guard<RAI, T, Tracker> moved_guard(first, hole, moved, track);
+		RAI up = min_level ?
+			bubble_up_max_hole(first, last, parent, value, comp, track) :
+			bubble_up_min_hole(first, last, parent, value, comp, track);
+		*up = std::move(value);
+		track(first, up);
+		moved_guard.release();
+		if (min_level) {
+			trickle_down_min_hole(first, last, hole, moved, comp, track);
 		} else {
-			bubble_up_min(first, last, i, comp);
+			trickle_down_max_hole(first, last, hole, moved, comp, track);
 		}
+		return;
+	}
+	RAI gp = get_grand_parent(first, last, hole);
+	bool climb = gp != last &&
+		(min_level ? comp(value, *gp) : comp(*gp, value));
+	guard.release();
+	if (climb) {
+		RAI up = min_level ?
+			bubble_up_min_hole(first, last, hole, value, comp, track) :
+			bubble_up_max_hole(first, last, hole, value, comp, track);
+		*up = std::move(value);
+		track(first, up);
+	} else if (min_level) {
+		trickle_down_min_hole(first, last, hole, value, comp, track);
 	} else {
-		if (parent != last && comp(*i, *parent)) {
-			std::iter_swap(i, parent);
-			bubble_up_min(first, last, parent, comp);
-		} else {
-			bubble_up_max(first, last, i, comp);
-		}
+		trickle_down_max_hole(first, last, hole, value, comp, track);
 	}
 }
 
@@ -0,0 +1,380 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_DETAIL_MIN_MAX_HEAP_SIMD_HPP
+#define SWAY_DETAIL_MIN_MAX_HEAP_SIMD_HPP
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#if !defined(SWAY_NO_SIMD) && \
+	(defined(__SSE4_1__) || defined(__AVX__) || defined(__AVX2__))
+#include <immintrin.h>
+#endif
+
+namespace sway {
+
+/*!
+Finds the first smallest (Max = false) or largest (Max = true) among the
+children and grandchildren of a node, when all of them exist. The two
+children and the four grandchildren are contiguous: the result is the
+position in the scan order of the scalar code (left child, its children,
+right child, its children), from 0 to 5, so that ties are broken the same
+way, or -1 if the values cannot be ordered (NaN), in which case the caller
+must use the scalar code.
+The specializations below use SSE4.1, AVX and AVX2 when the compiler targets
+them: the generic version is never called, as enabled is false.
+*/
+template<class T, bool Max>
+struct simd_select6 {
+	static const bool enabled = false;
+	static int index(const T * children, const T * grandchildren) {
+		return 0;
+	}
+};
+
+/*!
+Compares a block of width values with a threshold: bit i of the result is set
+if block[i] is smaller (Greater = false) or larger (Greater = true) than the
+threshold. The specializations below use SSE4.1, AVX and AVX2, with the
+widest vectors the target supports.
+*/
+template<class T, bool Greater>
+struct simd_filter {
+	static const bool enabled = false;
+	static const std::size_t width = 1;
+	static unsigned mask(const T * block, T threshold) {
+		return 0;
+	}
+};
+
+/*!
+Returns the position of the lowest set bit of a non-zero mask, clearing it.
+*/
+inline unsigned simd_next_position(unsigned & mask) {
+#if defined(__GNUC__) || defined(__clang__)
+	unsigned i = __builtin_ctz(mask);
+#else
+	unsigned i = 0;
+	while (!((mask >> i) & 1)) {
+		++i;
+	}
+#endif
+	mask &= mask - 1;
+	return i;
+}
+
+#if !defined(SWAY_NO_SIMD)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SWAY_SIMD_CTZ(mask) __builtin_ctz(mask)
+#endif
+
+/*
+Interleaves the equality masks of the children (bits 0-1) and of the
+grandchildren (bits 0-3) in scan order and returns the first set position,
+or -1 if no bit is set: with a NaN among floating point values the
+reduction may equal none of them.
+*/
+inline int simd_scan_position(int children_mask, int grandchildren_mask) {
+	int mask = (children_mask & 1) |
+			   ((grandchildren_mask & 3) << 1) |
+			   ((children_mask & 2) << 2) |
+			   ((grandchildren_mask & 12) << 2);
+	return mask != 0 ? SWAY_SIMD_CTZ(mask) : -1;
+}
+
+#if defined(__SSE4_1__) && defined(SWAY_SIMD_CTZ)
+
+template<bool Max>
+struct simd_select6<int32_t, Max> {
+	static const bool enabled = true;
+	static __m128i reduce(__m128i a, __m128i b) {
+		return Max ? _mm_max_epi32(a, b) : _mm_min_epi32(a, b);
+	}
+	static int index(const int32_t * children, const int32_t * grandchildren) {
+		__m128i g = _mm_loadu_si128(
+			reinterpret_cast<const __m128i *>(grandchildren));
+		__m128i c = _mm_loadl_epi64(
+			reinterpret_cast<const __m128i *>(children));
+		__m128i m = reduce(g, _mm_shuffle_epi32(g, 0x4E));
+		m = reduce(m, _mm_shuffle_epi32(m, 0xB1));
+		__m128i mc = reduce(c, _mm_shuffle_epi32(c, 0xE1));
+		m = reduce(m, _mm_shuffle_epi32(mc, 0x00));
+		return simd_scan_position(
+			_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(c, m))),
+			_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(g, m))));
+	}
+};
+
+template<bool Max>
+struct simd_select6<float, Max> {
+	static const bool enabled = true;
+	static __m128 reduce(__m128 a, __m128 b) {
+		return Max ? _mm_max_ps(a, b) : _mm_min_ps(a, b);
+	}
+	static int index(const float * children, const float * grandchildren) {
+		__m128 g = _mm_loadu_ps(grandchildren);
+		// the two children: unaligned 64 bits load, as for int32_t
+		__m128 c = _mm_castsi128_ps(_mm_loadl_epi64(
+			reinterpret_cast<const __m128i *>(children)));
+		__m128 m = reduce(g, _mm_shuffle_ps(g, g, 0x4E));
+		m = reduce(m, _mm_shuffle_ps(m, m, 0xB1));
+		__m128 mc = reduce(c, _mm_shuffle_ps(c, c, 0xE1));
+		m = reduce(m, _mm_shuffle_ps(mc, mc, 0x00));
+		return simd_scan_position(_mm_movemask_ps(_mm_cmpeq_ps(c, m)),
+								  _mm_movemask_ps(_mm_cmpeq_ps(g, m)));
+	}
+};
+
+#endif
+
+#if defined(__AVX__) && defined(SWAY_SIMD_CTZ)
+
+template<bool Max>
+struct simd_select6<double, Max> {
+	static const bool enabled = true;
+	static __m256d reduce(__m256d a, __m256d b) {
+		return Max ? _mm256_max_pd(a, b) : _mm256_min_pd(a, b);
+	}
+	static int index(const double * children, const double * grandchildren) {
+		__m256d g = _mm256_loadu_pd(grandchildren);
+		__m128d c = _mm_loadu_pd(children);
+		__m256d m = reduce(g, _mm256_permute2f128_pd(g, g, 0x01));
+		m = reduce(m, _mm256_permute_pd(m, 0x5));
+		__m128d mc = Max ? _mm_max_pd(c, _mm_permute_pd(c, 0x1))
+						 : _mm_min_pd(c, _mm_permute_pd(c, 0x1));
+		m = reduce(m, _mm256_insertf128_pd(_mm256_castpd128_pd256(mc), mc, 1));
+		return simd_scan_position(
+			_mm_movemask_pd(_mm_cmpeq_pd(c, _mm256_castpd256_pd128(m))),
+			_mm256_movemask_pd(_mm256_cmp_pd(g, m, _CMP_EQ_OQ)));
+	}
+};
+
+#endif
+
+#if defined(__AVX2__) && defined(SWAY_SIMD_CTZ)
+
+template<bool Max>
+struct simd_select6<int64_t, Max> {
+	static const bool enabled = true;
+	static __m256i reduce(__m256i a, __m256i b) {
+		// AVX2 has no 64 bits min/max: blend on the comparison instead
+		__m256i a_greater = _mm256_cmpgt_epi64(a, b);
+		return Max ? _mm256_blendv_epi8(b, a, a_greater)
+				   : _mm256_blendv_epi8(a, b, a_greater);
+	}
+	static int index(const int64_t * children, const int64_t * grandchildren) {
+		__m256i g = _mm256_loadu_si256(
+			reinterpret_cast<const __m256i *>(grandchildren));
+		// both children, twice
+		__m256i c = _mm256_broadcastsi128_si256(
+			_mm_loadu_si128(reinterpret_cast<const __m128i *>(children)));
+		__m256i m = reduce(g, _mm256_permute4x64_epi64(g, 0x4E));
+		m = reduce(m, _mm256_shuffle_epi32(m, 0x4E));
+		m = reduce(m, reduce(c, _mm256_shuffle_epi32(c, 0x4E)));
+		return simd_scan_position(
+			_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(c, m))),
+			_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(g, m))));
+	}
+};
+
+#endif
+
+#if defined(__AVX2__)
+
+template<bool Greater>
+struct simd_filter<int32_t, Greater> {
+	static const bool enabled = true;
+	static const std::size_t width = 8;
+	static unsigned mask(const int32_t * block, int32_t threshold) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+		__m256i t = _mm256_set1_epi32(threshold);
+		__m256i m = Greater ? _mm256_cmpgt_epi32(v, t)
+							: _mm256_cmpgt_epi32(t, v);
+		return _mm256_movemask_ps(_mm256_castsi256_ps(m));
+	}
+};
+
+template<bool Greater>
+struct simd_filter<int64_t, Greater> {
+	static const bool enabled = true;
+	static const std::size_t width = 4;
+	static unsigned mask(const int64_t * block, int64_t threshold) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block));
+		__m256i t = _mm256_set1_epi64x(threshold);
+		__m256i m = Greater ? _mm256_cmpgt_epi64(v, t)
+							: _mm256_cmpgt_epi64(t, v);
+		return _mm256_movemask_pd(_mm256_castsi256_pd(m));
+	}
+};
+
+#elif defined(__SSE4_1__)
+
+template<bool Greater>
+struct simd_filter<int32_t, Greater> {
+	static const bool enabled = true;
+	static const std::size_t width = 4;
+	static unsigned mask(const int32_t * block, int32_t threshold) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block));
+		__m128i t = _mm_set1_epi32(threshold);
+		__m128i m = Greater ? _mm_cmpgt_epi32(v, t) : _mm_cmpgt_epi32(t, v);
+		return _mm_movemask_ps(_mm_castsi128_ps(m));
+	}
+};
+
+#endif
+
+#if defined(__AVX__)
+
+template<bool Greater>
+struct simd_filter<float, Greater> {
+	static const bool enabled = true;
+	static const std::size_t width = 8;
+	static unsigned mask(const float * block, float threshold) {
+		__m256 v = _mm256_loadu_ps(block);
+		__m256 t = _mm256_set1_ps(threshold);
+		return _mm256_movemask_ps(
+			_mm256_cmp_ps(v, t, Greater ? _CMP_GT_OQ : _CMP_LT_OQ));
+	}
+};
+
+template<bool Greater>
+struct simd_filter<double, Greater> {
+	static const bool enabled = true;
+	static const std::size_t width = 4;
+	static unsigned mask(const double * block, double threshold) {
+		__m256d v = _mm256_loadu_pd(block);
+		__m256d t = _mm256_set1_pd(threshold);
+		return _mm256_movemask_pd(
+			_mm256_cmp_pd(v, t, Greater ? _CMP_GT_OQ : _CMP_LT_OQ));
+	}
+};
+
+#elif defined(__SSE4_1__)
+
+template<bool Greater>
+struct simd_filter<float, Greater> {
+	static const bool enabled = true;
+	static const std::size_t width = 4;
+	static unsigned mask(const float * block, float threshold) {
+		__m128 v = _mm_loadu_ps(block);
+		__m128 t = _mm_set1_ps(threshold);
+		return _mm_movemask_ps(Greater ? _mm_cmpgt_ps(v, t)
+									   : _mm_cmplt_ps(v, t));
+	}
+};
+
+#endif
+
+#endif
+
+/*!
+Tells whether Compare is a plain less-than (direction 1) or greater-than
+(direction -1) on T, for which the order of the values is known.
+*/
+template<class T, class Compare>
+struct simd_compare_direction {
+	static const int value = 0;
+};
+
+template<class T>
+struct simd_compare_direction<T, std::less<T> > {
+	static const int value = 1;
+};
+
+template<class T>
+struct simd_compare_direction<T, std::greater<T> > {
+	static const int value = -1;
+};
+
+/*!
+Tells whether the iterator points to contiguous storage: a pointer or a
+vector iterator.
+*/
+template<class Iterator>
+struct simd_contiguous {
+	typedef typename std::iterator_traits<Iterator>::value_type value_t;
+	static const bool value =
+		std::is_same<Iterator, value_t *>::value ||
+		std::is_same<Iterator, const value_t *>::value ||
+		std::is_same<Iterator,
+			typename std::vector<value_t>::iterator>::value ||
+		std::is_same<Iterator,
+			typename std::vector<value_t>::const_iterator>::value;
+};
+
+/*!
+Selects among the children and grandchildren of a node with a vector
+instruction sequence, when the iterator points to contiguous storage, the
+values are 32/64 bits integers or floating point numbers, the comparator is
+std::less or std::greater and the target supports the needed instruction set.
+*/
+template<class RAI, class Compare>
+struct simd_children {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	static const bool contiguous = simd_contiguous<RAI>::value;
+	static const int direction = simd_compare_direction<value_t, Compare>::value;
+	static const bool enabled = contiguous && direction != 0 &&
+		simd_select6<value_t, false>::enabled;
+	/*! Scan position of the first smallest according to Compare, or -1. */
+	static int smallest(const value_t * children,
+						const value_t * grandchildren) {
+		return simd_select6<value_t, (direction < 0)>::index(children,
+															  grandchildren);
+	}
+	/*! Scan position of the first largest according to Compare, or -1. */
+	static int largest(const value_t * children,
+					   const value_t * grandchildren) {
+		return simd_select6<value_t, (direction > 0)>::index(children,
+															  grandchildren);
+	}
+};
+
+
+/*!
+Filters the values of a range against a threshold with simd_filter, when the
+iterator points to contiguous storage, the comparator is std::less or
+std::greater and the target supports the needed instruction set. Bit i of
+mask is set if block[i] is ordered before the threshold by Compare.
+*/
+template<class Iterator, class Compare>
+struct simd_threshold_filter {
+	typedef typename std::iterator_traits<Iterator>::value_type value_t;
+	static const int direction = simd_compare_direction<value_t, Compare>::value;
+	typedef simd_filter<value_t, (direction < 0)> filter;
+	static const bool enabled = simd_contiguous<Iterator>::value &&
+		direction != 0 && filter::enabled;
+	static const std::size_t width = filter::width;
+	static unsigned mask(const value_t * block, const value_t & threshold) {
+		return filter::mask(block, threshold);
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_DETAIL_NODE_POOL_HPP
+#define SWAY_DETAIL_NODE_POOL_HPP
+
+#include <cstddef>
+#include <utility>
+
+namespace sway {
+
+namespace detail {
+
+/*
+Allocates the memory of objects of type Node from blocks of growing size,
+keeping the released ones in a free list for reuse. The memory of a block is
+returned only when the pool is destroyed. Two pools can be merged in constant
+time, so that the nodes of a structure melded into another can be released
+to the pool of the latter.
+*/
+template<class Node>
+class node_pool {
+private:
+	union slot {
+		slot * next;
+		alignas(Node) unsigned char storage[sizeof(Node)];
+	};
+	struct block {
+		block * next;
+		slot * slots;
+	};
+	static const std::size_t first_block_size = 16;
+	static const std::size_t max_block_size = 4096;
+	block * m_blocks;
+	block * m_last_block;
+	slot * m_free;
+	slot * m_last_free;
+	std::size_t m_block_size;
+	void grow() {
+		block * b = new block;
+		try {
+			b->slots = new slot[m_block_size];
+		} catch (...) {
+			delete b;
+			throw;
+		}
+		b->next = m_blocks;
+		m_blocks = b;
+		if (m_last_block == 0) {
+			m_last_block = b;
+		}
+		for (std::size_t i = 0; i + 1 < m_block_size; ++i) {
+			b->slots[i].next = &b->slots[i + 1];
+		}
+		// the free list is empty when the pool grows
+		b->slots[m_block_size - 1].next = 0;
+		m_free = b->slots;
+		m_last_free = &b->slots[m_block_size - 1];
+		if (m_block_size < max_block_size) {
+			m_block_size *= 2;
+		}
+	}
+	void reset() {
+		m_blocks = 0;
+		m_last_block = 0;
+		m_free = 0;
+		m_last_free = 0;
+		m_block_size = first_block_size;
+	}
+public:
+	node_pool() {
+		reset();
+	}
+	node_pool(const node_pool &) = delete;
+	node_pool & operator=(const node_pool &) = delete;
+	~node_pool() {
+		while (m_blocks != 0) {
+			block * b = m_blocks;
+			m_blocks = b->next;
+			delete[] b->slots;
+			delete b;
+		}
+	}
+	/*
+	Returns uninitialized memory for a Node.
+	*/
+	void * allocate() {
+		if (m_free == 0) {
+			grow();
+		}
+		slot * s = m_free;
+		m_free = s->next;
+		if (m_free == 0) {
+			m_last_free = 0;
+		}
+		return s;
+	}
+	/*
+	Releases the memory of a Node, already destroyed, to the free list.
+	*/
+	void deallocate(void * p) {
+		slot * s = static_cast<slot *>(p);
+		s->next = m_free;
+		m_free = s;
+		if (m_last_free == 0) {
+			m_last_free = s;
+		}
+	}
+	/*
+	Takes over the blocks and the free list of other, which is left empty.
+	*/
+	void splice(node_pool & other) {
+		if (other.m_blocks != 0) {
+			other.m_last_block->next = m_blocks;
+			m_blocks = other.m_blocks;
+			if (m_last_block == 0) {
+				m_last_block = other.m_last_block;
+			}
+		}
+		if (other.m_free != 0) {
+			other.m_last_free->next = m_free;
+			m_free = other.m_free;
+			if (m_last_free == 0) {
+				m_last_free = other.m_last_free;
+			}
+		}
+		if (m_block_size < other.m_block_size) {
+			m_block_size = other.m_block_size;
+		}
+		other.reset();
+	}
+	void swap(node_pool & other) {
+		std::swap(m_blocks, other.m_blocks);
+		std::swap(m_last_block, other.m_last_block);
+		std::swap(m_free, other.m_free);
+		std::swap(m_last_free, other.m_last_free);
+		std::swap(m_block_size, other.m_block_size);
+	}
+};
+
+}
+
+}
+
+#endif
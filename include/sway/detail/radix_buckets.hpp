@@ -0,0 +1,177 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Bucket structure of the radix priority_dqueue: a counter for each key of a
+bounded universe and a hierarchy of bitmaps over the non-empty keys.
+*/
+
+#ifndef SWAY_DETAIL_RADIX_BUCKETS_HPP
+#define SWAY_DETAIL_RADIX_BUCKETS_HPP
+
+#include <sway/ilog2.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace sway {
+
+namespace detail {
+
+/*
+Multiset of the keys in [0,2^Bits). The keys are counted in buckets, one
+per key, and a bit is set in level 0 for each non-empty bucket; a bit of
+level l+1 is set for each non-zero word of level l, up to a single word.
+With 64 bits words there are ceil(Bits/6) levels: an insertion or an
+erasure updates the levels only while a word becomes non-zero or zero,
+and the smallest or largest key is found descending the levels with one
+bit scan each. The smallest and largest keys are cached.
+*/
+template<unsigned Bits>
+class radix_buckets {
+private:
+	typedef boost::uint64_t word_t;
+	static const unsigned levels = (Bits + 5) / 6;
+	std::vector<boost::uint32_t> m_counts;
+	// the words of all the levels, level 0 first
+	std::vector<word_t> m_words;
+	std::size_t m_offset[levels];
+	std::size_t m_size;
+	std::size_t m_min;
+	std::size_t m_max;
+	static word_t bit(std::size_t i) {
+		return word_t(1) << (i & 63);
+	}
+	void set(std::size_t key) {
+		for (unsigned l = 0; l < levels; ++l) {
+			word_t & w = m_words[m_offset[l] + (key >> 6)];
+			bool was_empty = w == 0;
+			w |= bit(key);
+			if (!was_empty) {
+				return;
+			}
+			key >>= 6;
+		}
+	}
+	void reset(std::size_t key) {
+		for (unsigned l = 0; l < levels; ++l) {
+			word_t & w = m_words[m_offset[l] + (key >> 6)];
+			w &= ~bit(key);
+			if (w != 0) {
+				return;
+			}
+			key >>= 6;
+		}
+	}
+	std::size_t find_min() const {
+		std::size_t key = 0;
+		for (unsigned l = levels; l-- > 0; ) {
+			word_t w = m_words[m_offset[l] + key];
+			key = (key << 6) + ilog2<boost::uint64_t>(w & (0 - w));
+		}
+		return key;
+	}
+	std::size_t find_max() const {
+		std::size_t key = 0;
+		for (unsigned l = levels; l-- > 0; ) {
+			word_t w = m_words[m_offset[l] + key];
+			key = (key << 6) + ilog2<boost::uint64_t>(w);
+		}
+		return key;
+	}
+public:
+	static const std::size_t universe = std::size_t(1) << Bits;
+	radix_buckets() : m_counts(universe), m_size(0), m_min(0), m_max(0) {
+		std::size_t words = universe;
+		std::size_t total = 0;
+		for (unsigned l = 0; l < levels; ++l) {
+			words = (words + 63) / 64;
+			m_offset[l] = total;
+			total += words;
+		}
+		m_words.resize(total);
+	}
+	void insert(std::size_t key) {
+		if (m_counts[key]++ == 0) {
+			set(key);
+		}
+		if (m_size++ == 0) {
+			m_min = m_max = key;
+		} else {
+			m_min = std::min(m_min, key);
+			m_max = std::max(m_max, key);
+		}
+	}
+	/*
+	Erases one occurrence of the key, which must be in the multiset.
+	*/
+	void erase(std::size_t key) {
+		--m_size;
+		if (--m_counts[key] != 0) {
+			return;
+		}
+		reset(key);
+		if (m_size == 0) {
+			return;
+		}
+		if (key == m_min) {
+			m_min = find_min();
+		}
+		if (key == m_max) {
+			m_max = find_max();
+		}
+	}
+	void clear() {
+		if (m_size < universe / 64) {
+			// cheaper than clearing all the buckets
+			while (m_size != 0) {
+				m_size -= m_counts[m_min];
+				m_counts[m_min] = 0;
+				reset(m_min);
+				if (m_size != 0) {
+					m_min = find_min();
+				}
+			}
+		} else {
+			std::fill(m_counts.begin(), m_counts.end(), 0);
+			std::fill(m_words.begin(), m_words.end(), 0);
+			m_size = 0;
+		}
+	}
+	std::size_t min() const {
+		return m_min;
+	}
+	std::size_t max() const {
+		return m_max;
+	}
+	std::size_t size() const {
+		return m_size;
+	}
+};
+
+}
+
+}
+
+#endif
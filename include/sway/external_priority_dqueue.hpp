@@ -0,0 +1,303 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_EXTERNAL_PRIORITY_DQUEUE_HPP
+#define SWAY_EXTERNAL_PRIORITY_DQUEUE_HPP
+
+#include <sway/minmaxheap.hpp>
+#include <sway/detail/external_run.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sway {
+
+/*!
+Double-ended priority queue for more elements than fit in memory.
+The most recently pushed elements are kept in memory, in a min-max heap of
+up to memory elements. When it is full, it is sorted and written to a
+temporary file as a run; when merge_fanout runs of the same level exist,
+they are merged into one run of the next level, so that each element is
+written O(log(N/memory)/log(merge_fanout)) times, always sequentially.
+Each run keeps its first and last block of block elements in memory:
+pop_top and pop_bottom take the best end among the heap and the runs, and
+read the next block of a run when one is consumed, so that the elements
+are read sequentially from both ends of the runs.
+The queue uses about memory + (2 * runs + 1) * block elements of memory,
+where runs is at most merge_fanout per level. The temporary files are
+created in the given directory, or in the default temporary directory if
+empty, and are deleted when the runs are consumed or the queue destroyed.
+The elements must be trivially copyable and default constructible; if no
+comparer template parameter is specified, the < operator is used.
+If a temporary file cannot be created, written or read,
+external_storage_error is thrown; if that happens while merging runs, the
+elements of the runs being merged are lost and the queue must be cleared.
+The queue can be moved but not copied.
+*/
+template<class T,
+		 class Compare = std::less<T> >
+class external_priority_dqueue {
+	static_assert(std::is_trivially_copyable<T>::value,
+				  "external_priority_dqueue needs trivially copyable elements");
+public:
+	static const unsigned merge_fanout = 8;
+private:
+	typedef detail::external_run<T> run;
+	// index of the heap as the source of an end
+	static const std::size_t in_memory = ~std::size_t(0);
+	std::vector<T> m_heap;
+	std::vector<run> m_runs;
+	std::size_t m_memory;
+	std::size_t m_block;
+	std::string m_directory;
+	std::size_t m_size;
+	Compare m_comp;
+	external_io_stats m_io;
+	std::size_t top_source() const {
+		std::size_t best = in_memory;
+		const T * value = m_heap.empty() ? 0 : &m_heap[0];
+		for (std::size_t i = 0; i < m_runs.size(); ++i) {
+			if (!value || m_comp(m_runs[i].min(), *value)) {
+				best = i;
+				value = &m_runs[i].min();
+			}
+		}
+		return best;
+	}
+	std::size_t bottom_source() const {
+		std::size_t best = in_memory;
+		const T * value = m_heap.empty() ? 0
+			: &*max_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+		for (std::size_t i = 0; i < m_runs.size(); ++i) {
+			if (!value || m_comp(*value, m_runs[i].max())) {
+				best = i;
+				value = &m_runs[i].max();
+			}
+		}
+		return best;
+	}
+	void remove_if_empty(std::size_t i) {
+		if (m_runs[i].size() == 0) {
+			std::swap(m_runs[i], m_runs.back());
+			m_runs.pop_back();
+		}
+	}
+	/*
+	Writes the heap as a run of level 0, then merges the levels that reached
+	merge_fanout runs.
+	*/
+	void spill() {
+		std::sort(m_heap.begin(), m_heap.end(), m_comp);
+		try {
+			detail::run_writer<T> writer(m_directory, m_block, m_io);
+			for (std::size_t i = 0; i < m_heap.size(); ++i) {
+				writer.append(m_heap[i]);
+			}
+			m_runs.push_back(writer.finish(0));
+		} catch (...) {
+			make_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+			throw;
+		}
+		m_heap.clear();
+		for (unsigned level = 0; merge(level); ++level) {
+		}
+	}
+	/*
+	Merges the runs of the level into one of the next level, if there are
+	merge_fanout of them; returns true if it did.
+	*/
+	bool merge(unsigned level) {
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < m_runs.size(); ++i) {
+			count += m_runs[i].level() == level;
+		}
+		if (count < merge_fanout) {
+			return false;
+		}
+		typename std::vector<run>::iterator split =
+			std::partition(m_runs.begin(), m_runs.end(),
+						   [level](const run & r) { return r.level() != level; });
+		std::vector<run> inputs(std::make_move_iterator(split),
+								std::make_move_iterator(m_runs.end()));
+		m_runs.erase(split, m_runs.end());
+		detail::run_writer<T> writer(m_directory, m_block, m_io);
+		while (!inputs.empty()) {
+			std::size_t best = 0;
+			for (std::size_t i = 1; i < inputs.size(); ++i) {
+				if (m_comp(inputs[i].min(), inputs[best].min())) {
+					best = i;
+				}
+			}
+			writer.append(inputs[best].min());
+			inputs[best].pop_min(m_io);
+			if (inputs[best].size() == 0) {
+				std::swap(inputs[best], inputs.back());
+				inputs.pop_back();
+			}
+		}
+		m_runs.push_back(writer.finish(level + 1));
+		return true;
+	}
+public:
+	/*!
+	Constructs an empty queue keeping up to memory pushed elements in memory
+	and transferring block elements at a time to the temporary files, which
+	are created in directory.
+	*/
+	external_priority_dqueue(std::size_t memory, std::size_t block,
+							 const std::string & directory = std::string(),
+							 const Compare & comp = Compare())
+		: m_memory(std::max<std::size_t>(memory, 1)),
+		  m_block(std::max<std::size_t>(block, 1)), m_directory(directory),
+		  m_size(0), m_comp(comp) {
+		m_heap.reserve(m_memory);
+	}
+	external_priority_dqueue(external_priority_dqueue && other) = default;
+	external_priority_dqueue & operator=(external_priority_dqueue && other)
+		= default;
+	/*!
+	Adds a new element to the queue.
+	*/
+	void push(const T & obj) {
+		if (m_heap.size() == m_memory) {
+			spill();
+		}
+		m_heap.push_back(obj);
+		push_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+		++m_size;
+	}
+	/*!
+	Adds the elements in the range [first,last) to the queue.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void push(InputIterator first, InputIterator last) {
+		for (; first != last; ++first) {
+			push(*first);
+		}
+	}
+	/*!
+	Returns a reference to the highest priority element of the queue, valid
+	until the queue is modified.
+	*/
+	const T & top() const {
+		std::size_t i = top_source();
+		return i == in_memory ? m_heap[0] : m_runs[i].min();
+	}
+	/*!
+	Returns a reference to the lowest priority element of the queue, valid
+	until the queue is modified.
+	*/
+	const T & bottom() const {
+		std::size_t i = bottom_source();
+		return i == in_memory
+			? *max_minmaxheap(m_heap.begin(), m_heap.end(), m_comp)
+			: m_runs[i].max();
+	}
+	/*!
+	Removes the highest priority element of the queue.
+	*/
+	void pop_top() {
+		std::size_t i = top_source();
+		if (i == in_memory) {
+			popmin_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+			m_heap.pop_back();
+		} else {
+			m_runs[i].pop_min(m_io);
+			remove_if_empty(i);
+		}
+		--m_size;
+	}
+	/*!
+	Removes the lowest priority element of the queue.
+	*/
+	void pop_bottom() {
+		std::size_t i = bottom_source();
+		if (i == in_memory) {
+			popmax_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+			m_heap.pop_back();
+		} else {
+			m_runs[i].pop_max(m_io);
+			remove_if_empty(i);
+		}
+		--m_size;
+	}
+	/*!
+	Removes the highest priority element of the queue and returns it.
+	*/
+	T extract_top() {
+		T obj = top();
+		pop_top();
+		return obj;
+	}
+	/*!
+	Removes the lowest priority element of the queue and returns it.
+	*/
+	T extract_bottom() {
+		T obj = bottom();
+		pop_bottom();
+		return obj;
+	}
+	/*!
+	Removes all the elements, deleting the temporary files.
+	*/
+	void clear() {
+		m_heap.clear();
+		m_runs.clear();
+		m_size = 0;
+	}
+	/*!
+	Returns the number of elements stored in the queue.
+	*/
+	std::size_t size() const {
+		return m_size;
+	}
+	/*!
+	Returns true if the queue has no elements, false otherwise.
+	*/
+	bool empty() const {
+		return m_size == 0;
+	}
+	/*!
+	Returns the number of runs stored in temporary files.
+	*/
+	std::size_t runs() const {
+		return m_runs.size();
+	}
+	/*!
+	Returns the number of blocks read from and written to the temporary
+	files so far.
+	*/
+	const external_io_stats & io_stats() const {
+		return m_io;
+	}
+};
+
+}
+
+#endif
@@ -8,10 +8,26 @@
 
 namespace sway {
 
+/*!
+Returns the integer logarithm in base 2 of x, that is the position of its
+most significant set bit. By convention, the result for 0 is 0.
+When the compiler exposes a count-leading-zeros builtin, it is used (a single
+lzcnt/bsr instruction on x86), otherwise ilog2_portable is used.
+*/
 template<class T>
-T ilog2(T x);
+constexpr T ilog2(T x);
 
-static const uint8_t ilog2_lookup[256] = {
+/*!
+Table based implementation of ilog2, used where no intrinsic is available.
+*/
+template<class T>
+constexpr T ilog2_portable(T x);
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SWAY_HAS_BUILTIN_CLZ 1
+#endif
+
+static constexpr uint8_t ilog2_lookup[256] = {
 	0, 0, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 3, 3, 
 	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 
 	5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 
@@ -30,29 +46,27 @@ static const uint8_t ilog2_lookup[256] = {
 	7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7 };
 
 template<>
-inline uint8_t ilog2(uint8_t x) {
-    return ilog2_lookup[x];
+constexpr uint8_t ilog2_portable(uint8_t x) {
+	return ilog2_lookup[x];
 }
 
 template<>
-inline uint16_t ilog2(uint16_t x) {
-	register uint16_t tmp;
-	if ((tmp = x >> 8)) return 8 + ilog2_lookup[tmp];
-    return ilog2_lookup[x];
+constexpr uint16_t ilog2_portable(uint16_t x) {
+	return (x >> 8) ? 8 + ilog2_lookup[x >> 8] : ilog2_lookup[x];
 }
 
 template<>
-inline uint32_t ilog2(uint32_t x) {
-	register uint32_t tmp;
+constexpr uint32_t ilog2_portable(uint32_t x) {
+	uint32_t tmp = 0;
 	if ((tmp = x >> 24)) return 24 + ilog2_lookup[tmp];
 	if ((tmp = x >> 16)) return 16 + ilog2_lookup[tmp];
 	if ((tmp = x >> 8)) return 8 + ilog2_lookup[tmp];
-    return ilog2_lookup[x];
+	return ilog2_lookup[x];
 }
 
 template<>
-inline uint64_t ilog2(uint64_t x) {
-	register uint64_t tmp;
+constexpr uint64_t ilog2_portable(uint64_t x) {
+	uint64_t tmp = 0;
 	if ((tmp = x >> 56)) return 56 + ilog2_lookup[tmp];
 	if ((tmp = x >> 48)) return 48 + ilog2_lookup[tmp];
 	if ((tmp = x >> 40)) return 40 + ilog2_lookup[tmp];
@@ -60,9 +74,58 @@ inline uint64_t ilog2(uint64_t x) {
 	if ((tmp = x >> 24)) return 24 + ilog2_lookup[tmp];
 	if ((tmp = x >> 16)) return 16 + ilog2_lookup[tmp];
 	if ((tmp = x >> 8)) return 8 + ilog2_lookup[tmp];
-    return ilog2_lookup[x];
+	return ilog2_lookup[x];
+}
+
+#ifdef SWAY_HAS_BUILTIN_CLZ
+
+// the builtins are undefined for 0: or-ing 1 does not change the result for
+// any other value and maps 0 to 0, as in the portable implementation
+
+template<>
+constexpr uint8_t ilog2(uint8_t x) {
+	return static_cast<uint8_t>(31 - __builtin_clz(x | 1u));
+}
+
+template<>
+constexpr uint16_t ilog2(uint16_t x) {
+	return static_cast<uint16_t>(31 - __builtin_clz(x | 1u));
+}
+
+template<>
+constexpr uint32_t ilog2(uint32_t x) {
+	return 31 - __builtin_clz(x | 1u);
+}
+
+template<>
+constexpr uint64_t ilog2(uint64_t x) {
+	return 63 - __builtin_clzll(x | 1ull);
+}
+
+#else
+
+template<>
+constexpr uint8_t ilog2(uint8_t x) {
+	return ilog2_portable(x);
+}
+
+template<>
+constexpr uint16_t ilog2(uint16_t x) {
+	return ilog2_portable(x);
 }
 
+template<>
+constexpr uint32_t ilog2(uint32_t x) {
+	return ilog2_portable(x);
+}
+
+template<>
+constexpr uint64_t ilog2(uint64_t x) {
+	return ilog2_portable(x);
+}
+
+#endif
+
 }
 
 #endif
@@ -0,0 +1,251 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_INLINE_VECTOR_HPP
+#define SWAY_INLINE_VECTOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace sway {
+
+/*!
+This template class is a sequence container with the interface of a vector
+and a fixed capacity N, storing its elements inside the object itself: it
+never allocates memory. It can be used as the Container of the container
+adapters, so that a small queue lives on the stack or inside its owner.
+Growing beyond the capacity throws std::length_error.
+The iterators are plain pointers, so the vectorized paths of the heap
+algorithms apply to it as to std::vector.
+*/
+template<class T, std::size_t N>
+class inline_vector {
+public:
+	typedef T value_type;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef T * pointer;
+	typedef const T * const_pointer;
+	typedef T * iterator;
+	typedef const T * const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+private:
+	static_assert(N > 0, "inline_vector needs a positive capacity");
+	std::size_t m_size;
+	alignas(T) unsigned char m_storage[N * sizeof(T)];
+	void check_capacity(std::size_t size) const {
+		if (size > N) {
+			throw std::length_error("inline_vector capacity exceeded");
+		}
+	}
+public:
+	/*!
+	Constructs an empty vector.
+	*/
+	inline_vector() : m_size(0) {
+	}
+	/*!
+	Constructs a vector of count value-initialized elements.
+	*/
+	explicit inline_vector(size_type count) : m_size(0) {
+		resize(count);
+	}
+	/*!
+	Constructs a vector of count copies of value.
+	*/
+	inline_vector(size_type count, const T & value) : m_size(0) {
+		resize(count, value);
+	}
+	/*!
+	Constructs a vector with the elements of the range [first,last).
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	inline_vector(InputIterator first, InputIterator last) : m_size(0) {
+		insert(end(), first, last);
+	}
+	inline_vector(const inline_vector & other) : m_size(0) {
+		insert(end(), other.begin(), other.end());
+	}
+	inline_vector(inline_vector && other) : m_size(0) {
+		for (iterator i = other.begin(); i != other.end(); ++i) {
+			push_back(std::move(*i));
+		}
+	}
+	~inline_vector() {
+		clear();
+	}
+	inline_vector & operator=(const inline_vector & other) {
+		if (this != &other) {
+			clear();
+			insert(end(), other.begin(), other.end());
+		}
+		return *this;
+	}
+	inline_vector & operator=(inline_vector && other) {
+		if (this != &other) {
+			clear();
+			for (iterator i = other.begin(); i != other.end(); ++i) {
+				push_back(std::move(*i));
+			}
+		}
+		return *this;
+	}
+
+	iterator begin() {
+		return data();
+	}
+	const_iterator begin() const {
+		return data();
+	}
+	iterator end() {
+		return data() + m_size;
+	}
+	const_iterator end() const {
+		return data() + m_size;
+	}
+	reverse_iterator rbegin() {
+		return reverse_iterator(end());
+	}
+	const_reverse_iterator rbegin() const {
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend() {
+		return reverse_iterator(begin());
+	}
+	const_reverse_iterator rend() const {
+		return const_reverse_iterator(begin());
+	}
+
+	T * data() {
+		return reinterpret_cast<T *>(m_storage);
+	}
+	const T * data() const {
+		return reinterpret_cast<const T *>(m_storage);
+	}
+	reference operator[](size_type i) {
+		return data()[i];
+	}
+	const_reference operator[](size_type i) const {
+		return data()[i];
+	}
+	reference front() {
+		return data()[0];
+	}
+	const_reference front() const {
+		return data()[0];
+	}
+	reference back() {
+		return data()[m_size - 1];
+	}
+	const_reference back() const {
+		return data()[m_size - 1];
+	}
+
+	size_type size() const {
+		return m_size;
+	}
+	bool empty() const {
+		return m_size == 0;
+	}
+	static size_type capacity() {
+		return N;
+	}
+	static size_type max_size() {
+		return N;
+	}
+	void reserve(size_type count) {
+		check_capacity(count);
+	}
+
+	void push_back(const T & value) {
+		check_capacity(m_size + 1);
+		new (data() + m_size) T(value);
+		++m_size;
+	}
+	void push_back(T && value) {
+		check_capacity(m_size + 1);
+		new (data() + m_size) T(std::move(value));
+		++m_size;
+	}
+	template<class... Args>
+	reference emplace_back(Args &&... args) {
+		check_capacity(m_size + 1);
+		new (data() + m_size) T(std::forward<Args>(args)...);
+		return data()[m_size++];
+	}
+	void pop_back() {
+		--m_size;
+		data()[m_size].~T();
+	}
+	/*!
+	Inserts the elements of the range [first,last) before pos.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	iterator insert(const_iterator pos, InputIterator first,
+					InputIterator last) {
+		size_type offset = pos - begin();
+		size_type size = m_size;
+		for (; first != last; ++first) {
+			push_back(*first);
+		}
+		std::rotate(begin() + offset, begin() + size, end());
+		return begin() + offset;
+	}
+	void resize(size_type count) {
+		check_capacity(count);
+		while (m_size > count) {
+			pop_back();
+		}
+		for (; m_size < count; ++m_size) {
+			new (data() + m_size) T();
+		}
+	}
+	void resize(size_type count, const T & value) {
+		check_capacity(count);
+		while (m_size > count) {
+			pop_back();
+		}
+		for (; m_size < count; ++m_size) {
+			new (data() + m_size) T(value);
+		}
+	}
+	void clear() {
+		while (m_size > 0) {
+			pop_back();
+		}
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,211 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_INSTRUMENTATION_HPP
+#define SWAY_INSTRUMENTATION_HPP
+
+#include <sway/ilog2.hpp>
+#include <sway/detail/minmaxheap.hpp>
+#include <algorithm>
+#include <chrono>
+#include <boost/cstdint.hpp>
+
+namespace sway {
+
+/*!
+Operations of the container adapters reported to the instrumentation
+policies.
+*/
+enum heap_operation {
+	op_push,
+	op_push_range,
+	op_pop_top,
+	op_pop_bottom,
+	op_replace_top,
+	op_replace_bottom,
+	op_make,
+	heap_operations
+};
+
+/*!
+Outcomes of a push on a bounded_priority_queue: the element is inserted in
+a free slot, evicts the bottom element, or is rejected.
+*/
+enum push_outcome {
+	push_inserted,
+	push_evicted,
+	push_rejected,
+	push_outcomes
+};
+
+/*!
+Default instrumentation policy of the container adapters.
+An instrumentation policy wraps every operation of an adapter in a scope,
+provides the comparator and the position tracker passed to the heap
+algorithms, and is told the outcome of each bounded push. This one records
+nothing: the comparator is passed through and the tracker is null_tracker,
+so the adapters compile to the same code as without instrumentation.
+*/
+struct null_instrumentation {
+	struct scope {
+		scope(null_instrumentation &, heap_operation) {
+		}
+	};
+	template<class Compare>
+	Compare & compare(Compare & comp) {
+		return comp;
+	}
+	null_tracker tracker() {
+		return null_tracker();
+	}
+	void on_push(push_outcome) {
+	}
+};
+
+/*!
+Instrumentation policy counting, for each operation, the calls, the
+comparisons, the elements moved and the levels of the heap crossed.
+The levels are those of a binary tree laid out in the array, floor(log2(i+1))
+for position i: with the D-ary backends they are about log2(D) times the
+levels of the D-ary tree.
+If Latency is true, it also keeps a histogram of the latencies of each
+operation: bucket b counts the calls that took between 2^b and 2^(b+1)-1
+nanoseconds.
+The comparator is wrapped, so the vectorized selection of the children is
+not used and the comparisons counted are those of the scalar code.
+*/
+template<bool Latency = false>
+class counting_instrumentation {
+public:
+	static const std::size_t latency_buckets = 32;
+	struct operation_stats {
+		boost::uint64_t calls;
+		boost::uint64_t comparisons;
+		boost::uint64_t moves;
+		boost::uint64_t levels;
+		boost::uint64_t latency[latency_buckets];
+	};
+	template<class Compare>
+	class counting_compare {
+	private:
+		Compare m_comp;
+		boost::uint64_t * m_count;
+	public:
+		counting_compare(const Compare & comp, boost::uint64_t * count)
+			: m_comp(comp), m_count(count) {
+		}
+		template<class T1, class T2>
+		bool operator()(const T1 & a, const T2 & b) {
+			++*m_count;
+			return m_comp(a, b);
+		}
+	};
+	class tracker_type {
+	private:
+		counting_instrumentation * m_instr;
+	public:
+		tracker_type(counting_instrumentation * instr) : m_instr(instr) {
+		}
+		template<class RAI>
+		void operator()(RAI first, RAI i) const {
+			m_instr->moved(static_cast<std::size_t>(i - first));
+		}
+	};
+	class scope {
+	private:
+		counting_instrumentation & m_instr;
+		std::chrono::steady_clock::time_point m_start;
+	public:
+		scope(counting_instrumentation & instr, heap_operation op)
+			: m_instr(instr) {
+			m_instr.m_current = op;
+			m_instr.m_min_level = ~static_cast<std::size_t>(0);
+			m_instr.m_max_level = 0;
+			++m_instr.m_stats[op].calls;
+			if (Latency) {
+				m_start = std::chrono::steady_clock::now();
+			}
+		}
+		~scope() {
+			operation_stats & stats = m_instr.m_stats[m_instr.m_current];
+			if (m_instr.m_max_level >= m_instr.m_min_level) {
+				stats.levels += m_instr.m_max_level - m_instr.m_min_level;
+			}
+			if (Latency) {
+				boost::uint64_t ns = static_cast<boost::uint64_t>(
+					std::chrono::duration_cast<std::chrono::nanoseconds>(
+						std::chrono::steady_clock::now() - m_start).count());
+				std::size_t bucket = ilog2(ns);
+				++stats.latency[std::min(bucket, latency_buckets - 1)];
+			}
+		}
+	};
+private:
+	operation_stats m_stats[heap_operations];
+	boost::uint64_t m_outcomes[push_outcomes];
+	heap_operation m_current;
+	// levels of the positions written by the current operation
+	std::size_t m_min_level;
+	std::size_t m_max_level;
+	void moved(std::size_t position) {
+		++m_stats[m_current].moves;
+		std::size_t level = ilog2(position + 1);
+		m_min_level = std::min(m_min_level, level);
+		m_max_level = std::max(m_max_level, level);
+	}
+public:
+	counting_instrumentation() {
+		reset();
+	}
+	template<class Compare>
+	counting_compare<Compare> compare(const Compare & comp) {
+		return counting_compare<Compare>(comp,
+										 &m_stats[m_current].comparisons);
+	}
+	tracker_type tracker() {
+		return tracker_type(this);
+	}
+	void on_push(push_outcome outcome) {
+		++m_outcomes[outcome];
+	}
+	/*! Returns the counters of the given operation. */
+	const operation_stats & stats(heap_operation op) const {
+		return m_stats[op];
+	}
+	/*! Returns how many bounded pushes had the given outcome. */
+	boost::uint64_t outcomes(push_outcome outcome) const {
+		return m_outcomes[outcome];
+	}
+	/*! Sets all the counters to zero. */
+	void reset() {
+		std::fill(m_stats, m_stats + heap_operations, operation_stats());
+		std::fill(m_outcomes, m_outcomes + push_outcomes, 0);
+		m_current = op_push;
+		m_min_level = ~static_cast<std::size_t>(0);
+		m_max_level = 0;
+	}
+};
+
+}
+
+#endif
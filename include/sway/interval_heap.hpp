@@ -0,0 +1,309 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_INTERVAL_HEAP_HPP
+#define SWAY_INTERVAL_HEAP_HPP
+
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <sway/detail/minmaxheap.hpp>
+#include <sway/detail/interval_heap.hpp>
+
+namespace sway {
+
+/*!
+Rearranges the values in the range [first,last) as an interval heap,
+complexity O(N).
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void make_interval_heap(RAI first, RAI last, Compare comp,
+						Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	diff_t count = last - first;
+	if (count < 2) {
+		return;
+	}
+	for (diff_t k = (count - 1) / 2; k >= 0; --k) {
+		value_t value = std::move(first[2 * k]);
+		trickle_down_interval_min(first, last, k, value, comp, track);
+		if (4 * k + 2 < count) {
+			// the upper end may now be smaller than those of the children
+			value = std::move(first[2 * k + 1]);
+			trickle_down_interval_max(first, last, k, value, comp, track);
+		}
+	}
+}
+
+template<class RAI>
+void make_interval_heap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	make_interval_heap(first, last, std::less<value_t>());
+}
+
+/*! Returns an iterator pointing to the smallest element. */
+template<class RAI, class Compare>
+RAI min_interval_heap(RAI first, RAI last, Compare comp) {
+	return first;
+}
+
+template<class RAI>
+RAI min_interval_heap(RAI first, RAI last) {
+	return first;
+}
+
+/*! Returns an iterator pointing to the largest element. */
+template<class RAI, class Compare>
+RAI max_interval_heap(RAI first, RAI last, Compare comp) {
+	return last - first < 2 ? first : first + 1;
+}
+
+template<class RAI>
+RAI max_interval_heap(RAI first, RAI last) {
+	return last - first < 2 ? first : first + 1;
+}
+
+/*!
+Given an interval heap on the range [first,last-1), moves the element in the
+last-1 position to its correct position.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void push_interval_heap(RAI first, RAI last, Compare comp,
+						Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	diff_t i = last - first - 1;
+	if (i < 1) {
+		return;
+	}
+	value_t value = std::move(first[i]);
+	if (i % 2 == 1) {
+		// completes the interval of the last node
+		if (comp(value, first[i - 1])) {
+			first[i] = std::move(first[i - 1]);
+			track(first, first + i);
+			bubble_up_interval_min(first, i - 1, value, comp, track);
+		} else {
+			bubble_up_interval_max(first, i, value, comp, track);
+		}
+		return;
+	}
+	diff_t parent = (i / 2 - 1) / 2;
+	if (comp(value, first[2 * parent])) {
+		first[i] = std::move(first[2 * parent]);
+		track(first, first + i);
+		bubble_up_interval_min(first, 2 * parent, value, comp, track);
+	} else if (comp(first[2 * parent + 1], value)) {
+		first[i] = std::move(first[2 * parent + 1]);
+		track(first, first + i);
+		bubble_up_interval_max(first, 2 * parent + 1, value, comp, track);
+	} else {
+		first[i] = std::move(value);
+		track(first, first + i);
+	}
+}
+
+template<class RAI>
+void push_interval_heap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	push_interval_heap(first, last, std::less<value_t>());
+}
+
+/*!
+Given an interval heap on the range [first,middle), makes [first,last) an
+interval heap by inserting the elements in [middle,last): one by one, or by
+rebuilding the heap in linear time when they are more than those already
+in the heap.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void push_range_interval_heap(RAI first, RAI middle, RAI last,
+							  Compare comp, Tracker track = Tracker()) {
+	if (last - middle > middle - first) {
+		make_interval_heap(first, last, comp, track);
+		return;
+	}
+	for (RAI i = middle + 1; i <= last; ++i) {
+		push_interval_heap(first, i, comp, track);
+	}
+}
+
+template<class RAI>
+void push_range_interval_heap(RAI first, RAI middle, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	push_range_interval_heap(first, middle, last, std::less<value_t>());
+}
+
+/*!
+Moves the smallest value in the interval heap to the end of the sequence,
+shortening the actual interval heap range by one position.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void popmin_interval_heap(RAI first, RAI last, Compare comp,
+						 Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (last - first < 2) {
+		return;
+	}
+	value_t value = std::move(*(last - 1));
+	*(last - 1) = std::move(*first);
+	trickle_down_interval_min(first, last - 1, 0, value, comp, track);
+}
+
+template<class RAI>
+void popmin_interval_heap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmin_interval_heap(first, last, std::less<value_t>());
+}
+
+/*!
+Moves the largest value in the interval heap to the end of the sequence,
+shortening the actual interval heap range by one position.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void popmax_interval_heap(RAI first, RAI last, Compare comp,
+						 Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (last - first < 3) {
+		// the largest element is already in place
+		return;
+	}
+	value_t value = std::move(*(last - 1));
+	*(last - 1) = std::move(first[1]);
+	trickle_down_interval_max(first, last - 1, 0, value, comp, track);
+}
+
+template<class RAI>
+void popmax_interval_heap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmax_interval_heap(first, last, std::less<value_t>());
+}
+
+/*!
+Replaces the smallest value of the non-empty interval heap [first,last) with
+obj, sifting it down once.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void replacemin_interval_heap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj,
+	Compare comp,
+	Tracker track = Tracker()) {
+	trickle_down_interval_min(first, last, 0, obj, comp, track);
+}
+
+template<class RAI>
+void replacemin_interval_heap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	replacemin_interval_heap(first, last, std::move(obj),
+							 std::less<value_t>());
+}
+
+/*!
+Replaces the largest value of the non-empty interval heap [first,last) with
+obj, sifting it down once.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void replacemax_interval_heap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj,
+	Compare comp,
+	Tracker track = Tracker()) {
+	if (last - first < 2) {
+		*first = std::move(obj);
+		track(first, first);
+		return;
+	}
+	trickle_down_interval_max(first, last, 0, obj, comp, track);
+}
+
+template<class RAI>
+void replacemax_interval_heap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	replacemax_interval_heap(first, last, std::move(obj),
+							 std::less<value_t>());
+}
+
+/*!
+Heap backend of the container adapters, forwarding to the interval heap
+algorithms above.
+*/
+struct interval_heap_backend {
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void make(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
+		make_interval_heap(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void push(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
+		push_interval_heap(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void push_range(RAI first, RAI middle, RAI last, Compare comp,
+						   Tracker track = Tracker()) {
+		push_range_interval_heap(first, middle, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmin(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmin_interval_heap(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmax(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmax_interval_heap(first, last, comp, track);
+	}
+	template<class RAI, class T, class Compare, class Tracker = null_tracker>
+	static void replacemin(RAI first, RAI last, T && obj, Compare comp,
+						   Tracker track = Tracker()) {
+		replacemin_interval_heap(first, last, std::forward<T>(obj), comp,
+								 track);
+	}
+	template<class RAI, class T, class Compare, class Tracker = null_tracker>
+	static void replacemax(RAI first, RAI last, T && obj, Compare comp,
+						   Tracker track = Tracker()) {
+		replacemax_interval_heap(first, last, std::forward<T>(obj), comp,
+								 track);
+	}
+	template<class RAI, class Compare>
+	static RAI min(RAI first, RAI last, Compare comp) {
+		return min_interval_heap(first, last, comp);
+	}
+	template<class RAI, class Compare>
+	static RAI max(RAI first, RAI last, Compare comp) {
+		return max_interval_heap(first, last, comp);
+	}
+};
+
+}
+
+#endif
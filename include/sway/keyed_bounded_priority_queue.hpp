@@ -0,0 +1,252 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_KEYED_BOUNDED_PRIORITY_QUEUE_HPP
+#define SWAY_KEYED_BOUNDED_PRIORITY_QUEUE_HPP
+
+#include <sway/minmaxheap.hpp>
+#include <sway/detail/keyed_heap.hpp>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sway {
+
+/*!
+This template class is a priority queue with a bounded number of large
+elements, ordered by a key that KeyOf extracts from them: once the queue is
+full, the elements with the smallest priority are dropped.
+As in keyed_priority_dqueue, the heap only holds the keys with the indices
+of the elements, which are stored in a separate array: a rejected element
+costs one key comparison, and an element that evicts the bottom one takes
+its slot in the array. Once the queue is full, the position of its bottom
+element is cached.
+The key is extracted once, when the element is inserted, and must not change
+while the element is in the queue.
+If no comparer template parameter is specified, the < operator on the keys
+is used. The heap algorithms are provided by the Backend template parameter.
+The queue can be moved but not copied.
+*/
+template<class T,
+		 class KeyOf,
+		 class Compare =
+			std::less<typename detail::key_type_of<T, KeyOf>::type>,
+		 class Backend = minmaxheap_backend>
+class keyed_bounded_priority_queue {
+public:
+	typedef typename detail::key_type_of<T, KeyOf>::type key_type;
+private:
+	typedef detail::keyed_entry<key_type> entry;
+	typedef typename std::vector<entry>::iterator iterator;
+	std::size_t m_count;
+	std::vector<entry> m_heap;
+	detail::slot_array<T> m_payloads;
+	KeyOf m_key_of;
+	detail::keyed_entry_compare<Compare> m_comp;
+	// position of the bottom entry, valid while the queue is full
+	std::size_t m_bottom;
+	void update_bottom() {
+		m_bottom = Backend::max(m_heap.begin(), m_heap.end(), m_comp) -
+			m_heap.begin();
+	}
+	template<class U>
+	void insert(U && obj) {
+		if (m_count == m_heap.size()) {
+			if (m_count == 0) {
+				return;
+			}
+			key_type key = m_key_of(obj);
+			if (m_comp.comp(key, m_heap[m_bottom].key)) {
+				boost::uint32_t i = m_heap[m_bottom].index;
+				m_payloads[i] = std::forward<U>(obj);
+				entry e = { key, i };
+				Backend::replacemax(m_heap.begin(), m_heap.end(), e, m_comp);
+				update_bottom();
+			}
+		} else {
+			boost::uint32_t i = m_payloads.insert(std::forward<U>(obj));
+			entry e = { m_key_of(m_payloads[i]), i };
+			m_heap[m_count] = e;
+			++m_count;
+			Backend::push(m_heap.begin(), m_heap.begin() + m_count, m_comp);
+			if (m_count == m_heap.size()) {
+				update_bottom();
+			}
+		}
+	}
+	iterator end() {
+		return m_heap.begin() + m_count;
+	}
+public:
+	/*!
+	Constructs an empty bounded priority queue of the given size.
+	*/
+	keyed_bounded_priority_queue(std::size_t size,
+								 const KeyOf & key_of = KeyOf(),
+								 const Compare & comp = Compare())
+		: m_count(0), m_heap(size), m_key_of(key_of), m_comp(comp),
+		  m_bottom(0) {
+	}
+	keyed_bounded_priority_queue(keyed_bounded_priority_queue && other)
+		: m_count(0), m_key_of(other.m_key_of), m_comp(other.m_comp),
+		  m_bottom(other.m_bottom) {
+		std::swap(m_count, other.m_count);
+		m_heap.swap(other.m_heap);
+		m_payloads.swap(other.m_payloads);
+	}
+	~keyed_bounded_priority_queue() {
+		if (!std::is_trivially_destructible<T>::value) {
+			clear();
+		}
+	}
+	/*!
+	Tries to add a new element to the queue.
+	If the queue is full and the new element has a equal or higher priority
+	than the bottom element, the queue is left unmodified.
+	If the queue is full and the new element has a lower priority
+	than the bottom element, the bottom element is removed and the new element
+	is inserted.
+	*/
+	void push(const T & obj) {
+		insert(obj);
+	}
+	/*!
+	Same as above, moving the new element into the queue.
+	*/
+	void push(T && obj) {
+		insert(std::move(obj));
+	}
+	/*!
+	Same as push, constructing the new element from the arguments.
+	*/
+	template<class... Args>
+	void emplace(Args &&... args) {
+		insert(T(std::forward<Args>(args)...));
+	}
+	/*!
+	Tries to add the elements in the range [first,last) to the queue.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void push(InputIterator first, InputIterator last) {
+		for (; first != last; ++first) {
+			push(*first);
+		}
+	}
+	/*!
+	Returns a reference to the highest priority element of the queue.
+	*/
+	const T & top() const {
+		return m_payloads[m_heap[0].index];
+	}
+	/*!
+	Returns a reference to the lowest priority element of the queue.
+	*/
+	const T & bottom() const {
+		return m_payloads[Backend::max(m_heap.begin(),
+									   m_heap.begin() + m_count,
+									   m_comp)->index];
+	}
+	/*!
+	Returns the key of the highest priority element of the queue.
+	*/
+	const key_type & top_key() const {
+		return m_heap[0].key;
+	}
+	/*!
+	Returns the key of the lowest priority element of the queue.
+	*/
+	const key_type & bottom_key() const {
+		return Backend::max(m_heap.begin(), m_heap.begin() + m_count,
+							m_comp)->key;
+	}
+	/*!
+	Removes the highest priority element of the queue.
+	*/
+	void pop_top() {
+		Backend::popmin(m_heap.begin(), end(), m_comp);
+		--m_count;
+		m_payloads.erase(m_heap[m_count].index);
+	}
+	/*!
+	Removes the lowest priority element of the queue.
+	*/
+	void pop_bottom() {
+		Backend::popmax(m_heap.begin(), end(), m_comp);
+		--m_count;
+		m_payloads.erase(m_heap[m_count].index);
+	}
+	/*!
+	Removes the highest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_top() {
+		Backend::popmin(m_heap.begin(), end(), m_comp);
+		--m_count;
+		T obj(std::move(m_payloads[m_heap[m_count].index]));
+		m_payloads.erase(m_heap[m_count].index);
+		return obj;
+	}
+	/*!
+	Removes the lowest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_bottom() {
+		Backend::popmax(m_heap.begin(), end(), m_comp);
+		--m_count;
+		T obj(std::move(m_payloads[m_heap[m_count].index]));
+		m_payloads.erase(m_heap[m_count].index);
+		return obj;
+	}
+	/*!
+	Removes all the elements.
+	*/
+	void clear() {
+		for (; m_count > 0; --m_count) {
+			m_payloads.erase(m_heap[m_count - 1].index);
+		}
+	}
+	/*!
+	Returns the number of elements stored in the queue.
+	*/
+	std::size_t size() const {
+		return m_count;
+	}
+	/*!
+	Returns the maximum number of elements that can be stored in the queue.
+	*/
+	std::size_t max_size() const {
+		return m_heap.size();
+	}
+	/*!
+	Returns true if the queue has no elements, false otherwise.
+	*/
+	bool empty() const {
+		return m_count == 0;
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,251 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_KEYED_PRIORITY_DQUEUE_HPP
+#define SWAY_KEYED_PRIORITY_DQUEUE_HPP
+
+#include <sway/minmaxheap.hpp>
+#include <sway/detail/keyed_heap.hpp>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace sway {
+
+/*!
+This template class is a double-ended priority queue for large elements,
+ordered by a key that KeyOf extracts from them.
+The heap only holds the keys, each with the 32 bits index of its element,
+packed in a vector: the heap algorithms move and compare the keys without
+touching the elements, which are stored once in a separate array where they
+never move. When the elements are much larger than their keys, the sifts
+stay within a few cache lines.
+The key is extracted once, when the element is inserted, and must not change
+while the element is in the queue.
+If no comparer template parameter is specified, the < operator on the keys
+is used. The heap algorithms are provided by the Backend template parameter.
+The queue can be moved but not copied.
+*/
+template<class T,
+		 class KeyOf,
+		 class Compare =
+			std::less<typename detail::key_type_of<T, KeyOf>::type>,
+		 class Backend = minmaxheap_backend>
+class keyed_priority_dqueue {
+public:
+	typedef typename detail::key_type_of<T, KeyOf>::type key_type;
+private:
+	typedef detail::keyed_entry<key_type> entry;
+	std::vector<entry> m_heap;
+	detail::slot_array<T> m_payloads;
+	KeyOf m_key_of;
+	detail::keyed_entry_compare<Compare> m_comp;
+	template<class... Args>
+	void append(Args &&... args) {
+		boost::uint32_t i = m_payloads.insert(std::forward<Args>(args)...);
+		entry e = { m_key_of(m_payloads[i]), i };
+		try {
+			m_heap.push_back(e);
+		} catch (...) {
+			m_payloads.erase(i);
+			throw;
+		}
+	}
+	template<class... Args>
+	void insert(Args &&... args) {
+		append(std::forward<Args>(args)...);
+		Backend::push(m_heap.begin(), m_heap.end(), m_comp);
+	}
+	/*
+	Removes the entry at the back of the heap, with its element.
+	*/
+	void remove_back() {
+		m_payloads.erase(m_heap.back().index);
+		m_heap.pop_back();
+	}
+public:
+	/*!
+	Constructs an empty queue.
+	*/
+	keyed_priority_dqueue(const KeyOf & key_of = KeyOf(),
+						  const Compare & comp = Compare())
+		: m_key_of(key_of), m_comp(comp) {
+	}
+	/*!
+	Constructs a queue containing the elements in the range [first,last),
+	building the heap in linear time.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	keyed_priority_dqueue(InputIterator first, InputIterator last,
+						  const KeyOf & key_of = KeyOf(),
+						  const Compare & comp = Compare())
+		: m_key_of(key_of), m_comp(comp) {
+		try {
+			for (; first != last; ++first) {
+				append(*first);
+			}
+		} catch (...) {
+			clear();
+			throw;
+		}
+		Backend::make(m_heap.begin(), m_heap.end(), m_comp);
+	}
+	keyed_priority_dqueue(keyed_priority_dqueue && other)
+		: m_key_of(other.m_key_of), m_comp(other.m_comp) {
+		m_heap.swap(other.m_heap);
+		m_payloads.swap(other.m_payloads);
+	}
+	keyed_priority_dqueue & operator=(keyed_priority_dqueue && other) {
+		if (this != &other) {
+			clear();
+			m_heap.swap(other.m_heap);
+			m_payloads.swap(other.m_payloads);
+			std::swap(m_key_of, other.m_key_of);
+			std::swap(m_comp, other.m_comp);
+		}
+		return *this;
+	}
+	~keyed_priority_dqueue() {
+		if (!std::is_trivially_destructible<T>::value) {
+			clear();
+		}
+	}
+	/*!
+	Adds a new element to the queue.
+	*/
+	void push(const T & obj) {
+		insert(obj);
+	}
+	/*!
+	Same as above, moving the new element into the queue.
+	*/
+	void push(T && obj) {
+		insert(std::move(obj));
+	}
+	/*!
+	Adds a new element to the queue, constructed in place from the
+	arguments.
+	*/
+	template<class... Args>
+	void emplace(Args &&... args) {
+		insert(std::forward<Args>(args)...);
+	}
+	/*!
+	Adds the elements in the range [first,last) to the queue.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void push(InputIterator first, InputIterator last) {
+		std::size_t count = m_heap.size();
+		for (; first != last; ++first) {
+			append(*first);
+		}
+		Backend::push_range(m_heap.begin(), m_heap.begin() + count,
+							m_heap.end(), m_comp);
+	}
+	/*!
+	Returns a reference to the highest priority element of the queue.
+	*/
+	const T & top() const {
+		return m_payloads[m_heap[0].index];
+	}
+	/*!
+	Returns a reference to the lowest priority element of the queue.
+	*/
+	const T & bottom() const {
+		return m_payloads[Backend::max(m_heap.begin(), m_heap.end(),
+									   m_comp)->index];
+	}
+	/*!
+	Returns the key of the highest priority element of the queue.
+	*/
+	const key_type & top_key() const {
+		return m_heap[0].key;
+	}
+	/*!
+	Returns the key of the lowest priority element of the queue.
+	*/
+	const key_type & bottom_key() const {
+		return Backend::max(m_heap.begin(), m_heap.end(), m_comp)->key;
+	}
+	/*!
+	Removes the highest priority element of the queue.
+	*/
+	void pop_top() {
+		Backend::popmin(m_heap.begin(), m_heap.end(), m_comp);
+		remove_back();
+	}
+	/*!
+	Removes the lowest priority element of the queue.
+	*/
+	void pop_bottom() {
+		Backend::popmax(m_heap.begin(), m_heap.end(), m_comp);
+		remove_back();
+	}
+	/*!
+	Removes the highest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_top() {
+		Backend::popmin(m_heap.begin(), m_heap.end(), m_comp);
+		T obj(std::move(m_payloads[m_heap.back().index]));
+		remove_back();
+		return obj;
+	}
+	/*!
+	Removes the lowest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_bottom() {
+		Backend::popmax(m_heap.begin(), m_heap.end(), m_comp);
+		T obj(std::move(m_payloads[m_heap.back().index]));
+		remove_back();
+		return obj;
+	}
+	/*!
+	Removes all the elements.
+	*/
+	void clear() {
+		while (!m_heap.empty()) {
+			remove_back();
+		}
+	}
+	/*!
+	Returns the number of elements stored in the queue.
+	*/
+	std::size_t size() const {
+		return m_heap.size();
+	}
+	/*!
+	Returns true if the queue has no elements, false otherwise.
+	*/
+	bool empty() const {
+		return m_heap.empty();
+	}
+};
+
+}
+
+#endif
@@ -0,0 +1,420 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_MAPPED_VECTOR_HPP
+#define SWAY_MAPPED_VECTOR_HPP
+
+#include <sway/snapshot.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if !defined(SWAY_HAS_POSIX)
+#error "sway/mapped_vector.hpp needs mmap: it is only available on POSIX systems"
+#endif
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace sway {
+
+namespace detail {
+
+/*
+A snapshot mapped in memory with MAP_PRIVATE: the elements can be modified
+in place, the pages written are copied on write and the file is left
+unchanged. Virtual memory is reserved after the elements, up to the larger
+of the capacity and twice the count, so that the elements can be added in
+place; the pages not written to take no memory.
+*/
+class mapped_snapshot {
+private:
+	void * m_address;
+	std::size_t m_length;
+	snapshot_header m_header;
+	void fail(int fd, const std::string & path, const char * reason) {
+		if (fd != -1) {
+			::close(fd);
+		}
+		if (m_address) {
+			::munmap(m_address, m_length);
+			m_address = 0;
+		}
+		throw snapshot_error("Snapshot \"" + path + "\" " + reason);
+	}
+public:
+	/*
+	Maps the snapshot at path, checking that it holds elements of the given
+	size and that its checksum matches, which reads all of the elements.
+	*/
+	mapped_snapshot(const std::string & path, std::size_t element_size)
+		: m_address(0), m_length(0) {
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd == -1) {
+			fail(fd, path, "could not be opened.");
+		}
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size < 0 ||
+			::pread(fd, &m_header, sizeof(m_header), 0) !=
+				static_cast<ssize_t>(sizeof(m_header))) {
+			fail(fd, path, "is not a snapshot.");
+		}
+		// the header is checked, sizes included, before it sizes anything
+		if (const char * reason = check_snapshot_header(
+				m_header, element_size,
+				static_cast<boost::uint64_t>(st.st_size))) {
+			fail(fd, path, reason);
+		}
+		std::size_t file_size = snapshot_header::data_offset +
+			m_header.count * element_size;
+		std::size_t max_count = snapshot_max_count(element_size);
+		std::size_t room = std::max<std::size_t>(m_header.capacity,
+			m_header.count <= max_count / 2 ? 2 * m_header.count : max_count);
+		m_length = snapshot_header::data_offset + room * element_size;
+		// reserve the whole range, then map the file over its start
+		m_address = ::mmap(0, m_length, PROT_READ | PROT_WRITE,
+						   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (m_address == MAP_FAILED) {
+			m_address = 0;
+			fail(fd, path, "could not be mapped.");
+		}
+		if (::mmap(m_address, file_size, PROT_READ | PROT_WRITE,
+				   MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+			fail(fd, path, "could not be mapped.");
+		}
+		::close(fd);
+		snapshot_checksum checksum;
+		checksum.update(elements(), m_header.count * element_size);
+		if (checksum.value() != m_header.checksum) {
+			fail(-1, path, "has a wrong checksum.");
+		}
+	}
+	mapped_snapshot(const mapped_snapshot &) = delete;
+	mapped_snapshot & operator=(const mapped_snapshot &) = delete;
+	~mapped_snapshot() {
+		if (m_address) {
+			::munmap(m_address, m_length);
+		}
+	}
+	void * elements() const {
+		return static_cast<char *>(m_address) + snapshot_header::data_offset;
+	}
+	std::size_t count() const {
+		return m_header.count;
+	}
+	std::size_t capacity() const {
+		return m_header.capacity;
+	}
+	/*
+	Number of elements that fit in the mapping.
+	*/
+	std::size_t room() const {
+		return (m_length - snapshot_header::data_offset) /
+			m_header.element_size;
+	}
+	/*
+	Gives up the ownership of the mapping, which the caller must unmap.
+	*/
+	std::pair<void *, std::size_t> release() {
+		std::pair<void *, std::size_t> mapping(m_address, m_length);
+		m_address = 0;
+		return mapping;
+	}
+};
+
+}
+
+/*!
+Sequence container of trivially copyable elements stored in memory mapped
+pages, usable as the Container of the adapters. Its point is the restore
+of a snapshot: loading a priority_dqueue or a bounded_priority_queue
+whose Container is a mapped_vector maps the snapshot file and uses the
+mapping as the storage, in place, without copying or reordering the
+elements (see restore_snapshot). The pages are mapped privately: they are
+shared with the page cache until written, copied when first written, and
+the file is never modified. The load still reads every page once, to
+verify the checksum of the elements. The header is only available on
+POSIX systems.
+Otherwise it behaves as a vector whose storage is an anonymous mapping,
+grown by doubling.
+*/
+template<class T>
+class mapped_vector {
+	static_assert(std::is_trivially_copyable<T>::value,
+				  "mapped_vector needs trivially copyable elements");
+	static_assert(alignof(T) <= detail::snapshot_header::data_offset,
+				  "mapped_vector elements are aligned to 64 bytes at most");
+public:
+	typedef T value_type;
+	typedef T & reference;
+	typedef const T & const_reference;
+	typedef T * pointer;
+	typedef const T * const_pointer;
+	typedef T * iterator;
+	typedef const T * const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+	typedef std::size_t size_type;
+	typedef std::ptrdiff_t difference_type;
+private:
+	// the mapping, whose elements start at m_data
+	void * m_address;
+	std::size_t m_length;
+	T * m_data;
+	std::size_t m_size;
+	std::size_t m_capacity;
+	void unmap() {
+		if (m_address) {
+			::munmap(m_address, m_length);
+		}
+		m_address = 0;
+		m_length = 0;
+		m_data = 0;
+		m_capacity = 0;
+	}
+	void grow(std::size_t count) {
+		if (count <= m_capacity) {
+			return;
+		}
+		std::size_t capacity = std::max<std::size_t>(
+			std::max<std::size_t>(count, 2 * m_capacity), 16);
+		std::size_t length = capacity * sizeof(T);
+		void * address = ::mmap(0, length, PROT_READ | PROT_WRITE,
+								MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (address == MAP_FAILED) {
+			throw std::bad_alloc();
+		}
+		if (m_size != 0) {
+			std::memcpy(address, m_data, m_size * sizeof(T));
+		}
+		std::size_t size = m_size;
+		unmap();
+		m_address = address;
+		m_length = length;
+		m_data = static_cast<T *>(address);
+		m_size = size;
+		m_capacity = capacity;
+	}
+public:
+	/*!
+	Constructs an empty vector.
+	*/
+	mapped_vector()
+		: m_address(0), m_length(0), m_data(0), m_size(0), m_capacity(0) {
+	}
+	/*!
+	Constructs a vector of count value-initialized elements.
+	*/
+	explicit mapped_vector(size_type count)
+		: m_address(0), m_length(0), m_data(0), m_size(0), m_capacity(0) {
+		resize(count);
+	}
+	mapped_vector(const mapped_vector & other)
+		: m_address(0), m_length(0), m_data(0), m_size(0), m_capacity(0) {
+		insert(end(), other.begin(), other.end());
+	}
+	mapped_vector(mapped_vector && other)
+		: m_address(0), m_length(0), m_data(0), m_size(0), m_capacity(0) {
+		swap(other);
+	}
+	~mapped_vector() {
+		unmap();
+	}
+	mapped_vector & operator=(const mapped_vector & other) {
+		if (this != &other) {
+			clear();
+			insert(end(), other.begin(), other.end());
+		}
+		return *this;
+	}
+	mapped_vector & operator=(mapped_vector && other) {
+		swap(other);
+		return *this;
+	}
+	void swap(mapped_vector & other) {
+		std::swap(m_address, other.m_address);
+		std::swap(m_length, other.m_length);
+		std::swap(m_data, other.m_data);
+		std::swap(m_size, other.m_size);
+		std::swap(m_capacity, other.m_capacity);
+	}
+	/*!
+	Takes over the mapping of the snapshot: the vector holds its count
+	elements, in place, and can grow in place up to its room.
+	*/
+	void adopt(detail::mapped_snapshot & s) {
+		unmap();
+		m_capacity = s.room();
+		m_size = s.count();
+		m_data = static_cast<T *>(s.elements());
+		std::pair<void *, std::size_t> mapping = s.release();
+		m_address = mapping.first;
+		m_length = mapping.second;
+	}
+
+	iterator begin() {
+		return m_data;
+	}
+	const_iterator begin() const {
+		return m_data;
+	}
+	iterator end() {
+		return m_data + m_size;
+	}
+	const_iterator end() const {
+		return m_data + m_size;
+	}
+	reverse_iterator rbegin() {
+		return reverse_iterator(end());
+	}
+	const_reverse_iterator rbegin() const {
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend() {
+		return reverse_iterator(begin());
+	}
+	const_reverse_iterator rend() const {
+		return const_reverse_iterator(begin());
+	}
+
+	T * data() {
+		return m_data;
+	}
+	const T * data() const {
+		return m_data;
+	}
+	reference operator[](size_type i) {
+		return m_data[i];
+	}
+	const_reference operator[](size_type i) const {
+		return m_data[i];
+	}
+	reference front() {
+		return m_data[0];
+	}
+	const_reference front() const {
+		return m_data[0];
+	}
+	reference back() {
+		return m_data[m_size - 1];
+	}
+	const_reference back() const {
+		return m_data[m_size - 1];
+	}
+
+	size_type size() const {
+		return m_size;
+	}
+	bool empty() const {
+		return m_size == 0;
+	}
+	size_type capacity() const {
+		return m_capacity;
+	}
+	void reserve(size_type count) {
+		grow(count);
+	}
+
+	void push_back(const T & value) {
+		if (m_size == m_capacity) {
+			// value may be an element of the vector
+			T copy(value);
+			grow(m_size + 1);
+			new (m_data + m_size) T(copy);
+		} else {
+			new (m_data + m_size) T(value);
+		}
+		++m_size;
+	}
+	template<class... Args>
+	reference emplace_back(Args &&... args) {
+		T value(std::forward<Args>(args)...);
+		grow(m_size + 1);
+		new (m_data + m_size) T(value);
+		return m_data[m_size++];
+	}
+	void pop_back() {
+		--m_size;
+	}
+	/*!
+	Inserts the elements of the range [first,last) before pos.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	iterator insert(const_iterator pos, InputIterator first,
+					InputIterator last) {
+		size_type offset = pos - begin();
+		size_type size = m_size;
+		for (; first != last; ++first) {
+			push_back(*first);
+		}
+		std::rotate(begin() + offset, begin() + size, end());
+		return begin() + offset;
+	}
+	void resize(size_type count) {
+		grow(count);
+		for (; m_size < count; ++m_size) {
+			new (m_data + m_size) T();
+		}
+		m_size = count;
+	}
+	void clear() {
+		m_size = 0;
+	}
+};
+
+/*!
+Restores a snapshot into a mapped_vector by taking over its mapping: the
+elements are not copied, but they are all read once to verify their
+checksum, so the restore is O(N) in reads (and in page faults, on a cold
+page cache) while allocating nothing.
+*/
+template<class T>
+void restore_snapshot(mapped_vector<T> & c, const std::string & path) {
+	detail::mapped_snapshot s(path, sizeof(T));
+	c.adopt(s);
+}
+
+/*!
+Same as above, then appends value-initialized elements up to the capacity
+of the snapshot, in the room reserved by the mapping; returns the number
+of elements of the snapshot.
+*/
+template<class T>
+std::size_t restore_bounded_snapshot(mapped_vector<T> & c,
+									 const std::string & path) {
+	detail::mapped_snapshot s(path, sizeof(T));
+	c.adopt(s);
+	c.resize(s.capacity());
+	return s.count();
+}
+
+}
+
+#endif
@@ -0,0 +1,333 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_MERGEABLE_PRIORITY_DQUEUE_HPP
+#define SWAY_MERGEABLE_PRIORITY_DQUEUE_HPP
+
+#include <sway/detail/node_pool.hpp>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sway {
+
+/*!
+This template class implements a double-ended priority queue supporting
+meld, the merge of two queues, in O(log N) time.
+Each element is a node of two leftist trees, ordered by priority and by
+reverse priority, whose roots are the highest and the lowest priority
+elements. Melding merges the right spines of the trees; removing an end
+unlinks the node from both trees, O(log N).
+The nodes are allocated from a pool owned by the queue, in blocks of growing
+size; melding hands the pool of the other queue over, in constant time.
+The queue can be moved but not copied.
+If no comparer template parameter is specified, the < operator is used.
+*/
+template<class T,
+		 class Compare = std::less<T> >
+class mergeable_priority_dqueue {
+private:
+	// the tree ordered by priority, and the one ordered by reverse priority
+	enum { top_tree = 0, bottom_tree = 1 };
+	struct node;
+	struct link {
+		node * left;
+		node * right;
+		node * parent;
+		// length of the rightmost path, the null path length
+		std::size_t rank;
+	};
+	struct node {
+		link links[2];
+		T value;
+		template<class... Args>
+		node(Args &&... args) : value(std::forward<Args>(args)...) {
+			for (int i = 0; i < 2; ++i) {
+				links[i].left = 0;
+				links[i].right = 0;
+				links[i].parent = 0;
+				links[i].rank = 1;
+			}
+		}
+	};
+	node * m_roots[2];
+	std::size_t m_size;
+	Compare m_comp;
+	detail::node_pool<node> m_pool;
+
+	template<int Tree>
+	bool before(const node * a, const node * b) {
+		return Tree == top_tree ? m_comp(a->value, b->value) :
+			m_comp(b->value, a->value);
+	}
+	template<int Tree>
+	static std::size_t rank(const node * x) {
+		return x == 0 ? 0 : x->links[Tree].rank;
+	}
+	/*
+	Merges the trees rooted in a and b along their rightmost paths, which
+	are O(log N) long, and returns the new root.
+	*/
+	template<int Tree>
+	node * merge(node * a, node * b) {
+		if (a == 0) {
+			return b;
+		}
+		if (b == 0) {
+			return a;
+		}
+		if (before<Tree>(b, a)) {
+			std::swap(a, b);
+		}
+		link & l = a->links[Tree];
+		l.right = merge<Tree>(l.right, b);
+		l.right->links[Tree].parent = a;
+		if (rank<Tree>(l.left) < l.right->links[Tree].rank) {
+			std::swap(l.left, l.right);
+		}
+		l.rank = rank<Tree>(l.right) + 1;
+		return a;
+	}
+	template<int Tree>
+	void meld_root(node * x) {
+		m_roots[Tree] = merge<Tree>(m_roots[Tree], x);
+		m_roots[Tree]->links[Tree].parent = 0;
+	}
+	/*
+	Removes x from a tree, replacing it with the merge of its subtrees and
+	restoring the ranks of its ancestors.
+	*/
+	template<int Tree>
+	void unlink(node * x) {
+		link & l = x->links[Tree];
+		node * sub = merge<Tree>(l.left, l.right);
+		node * parent = l.parent;
+		if (sub != 0) {
+			sub->links[Tree].parent = parent;
+		}
+		if (parent == 0) {
+			m_roots[Tree] = sub;
+			return;
+		}
+		link & p = parent->links[Tree];
+		(p.left == x ? p.left : p.right) = sub;
+		for (; parent != 0; parent = parent->links[Tree].parent) {
+			link & a = parent->links[Tree];
+			if (rank<Tree>(a.left) < rank<Tree>(a.right)) {
+				std::swap(a.left, a.right);
+			}
+			std::size_t r = rank<Tree>(a.right) + 1;
+			if (r == a.rank) {
+				break;
+			}
+			a.rank = r;
+		}
+	}
+	template<class... Args>
+	void insert(Args &&... args) {
+		void * p = m_pool.allocate();
+		node * x;
+		try {
+			x = new (p) node(std::forward<Args>(args)...);
+		} catch (...) {
+			m_pool.deallocate(p);
+			throw;
+		}
+		meld_root<top_tree>(x);
+		meld_root<bottom_tree>(x);
+		++m_size;
+	}
+	void remove(node * x) {
+		unlink<top_tree>(x);
+		unlink<bottom_tree>(x);
+		x->~node();
+		m_pool.deallocate(x);
+		--m_size;
+	}
+	/*
+	Destroys all the nodes, visiting the tree ordered by priority with a
+	stack threaded through the links of the other tree.
+	*/
+	void destroy_all() {
+		node * stack = m_roots[top_tree];
+		if (stack != 0) {
+			stack->links[bottom_tree].left = 0;
+		}
+		while (stack != 0) {
+			node * x = stack;
+			stack = x->links[bottom_tree].left;
+			node * children[2] = { x->links[top_tree].left,
+								   x->links[top_tree].right };
+			for (int i = 0; i < 2; ++i) {
+				if (children[i] != 0) {
+					children[i]->links[bottom_tree].left = stack;
+					stack = children[i];
+				}
+			}
+			x->~node();
+			m_pool.deallocate(x);
+		}
+		m_roots[top_tree] = 0;
+		m_roots[bottom_tree] = 0;
+		m_size = 0;
+	}
+public:
+	/*!
+	Constructs an empty queue.
+	*/
+	mergeable_priority_dqueue(const Compare & comp = Compare())
+		: m_size(0), m_comp(comp) {
+		m_roots[top_tree] = 0;
+		m_roots[bottom_tree] = 0;
+	}
+	mergeable_priority_dqueue(mergeable_priority_dqueue && other)
+		: m_size(0), m_comp(other.m_comp) {
+		m_roots[top_tree] = 0;
+		m_roots[bottom_tree] = 0;
+		swap(other);
+	}
+	mergeable_priority_dqueue & operator=(mergeable_priority_dqueue && other) {
+		if (this != &other) {
+			clear();
+			swap(other);
+		}
+		return *this;
+	}
+	~mergeable_priority_dqueue() {
+		if (!std::is_trivially_destructible<T>::value) {
+			destroy_all();
+		}
+	}
+	/*!
+	Adds a new element to the queue.
+	*/
+	void push(const T & obj) {
+		insert(obj);
+	}
+	/*!
+	Same as above, moving the new element into the queue.
+	*/
+	void push(T && obj) {
+		insert(std::move(obj));
+	}
+	/*!
+	Adds a new element to the queue, constructed in place from the
+	arguments.
+	*/
+	template<class... Args>
+	void emplace(Args &&... args) {
+		insert(std::forward<Args>(args)...);
+	}
+	/*!
+	Moves all the elements of other into this queue, in O(log N) time, and
+	leaves other empty. The two queues must order the elements in the same
+	way.
+	*/
+	void meld(mergeable_priority_dqueue & other) {
+		if (this == &other) {
+			return;
+		}
+		m_roots[top_tree] = merge<top_tree>(m_roots[top_tree],
+											 other.m_roots[top_tree]);
+		m_roots[bottom_tree] = merge<bottom_tree>(m_roots[bottom_tree],
+												  other.m_roots[bottom_tree]);
+		m_size += other.m_size;
+		m_pool.splice(other.m_pool);
+		other.m_roots[top_tree] = 0;
+		other.m_roots[bottom_tree] = 0;
+		other.m_size = 0;
+	}
+	/*!
+	Returns a reference to the highest priority element of the queue.
+	*/
+	const T & top() const {
+		return m_roots[top_tree]->value;
+	}
+	/*!
+	Returns a reference to the lowest priority element of the queue.
+	*/
+	const T & bottom() const {
+		return m_roots[bottom_tree]->value;
+	}
+	/*!
+	Removes the highest priority element of the queue.
+	*/
+	void pop_top() {
+		remove(m_roots[top_tree]);
+	}
+	/*!
+	Removes the lowest priority element of the queue.
+	*/
+	void pop_bottom() {
+		remove(m_roots[bottom_tree]);
+	}
+	/*!
+	Removes the highest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_top() {
+		T obj(std::move(m_roots[top_tree]->value));
+		remove(m_roots[top_tree]);
+		return obj;
+	}
+	/*!
+	Removes the lowest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_bottom() {
+		T obj(std::move(m_roots[bottom_tree]->value));
+		remove(m_roots[bottom_tree]);
+		return obj;
+	}
+	/*!
+	Removes all the elements; the memory of the nodes is kept for reuse.
+	*/
+	void clear() {
+		destroy_all();
+	}
+	/*!
+	Returns the number of elements stored in the queue.
+	*/
+	std::size_t size() const {
+		return m_size;
+	}
+	/*!
+	Returns true if the queue has no elements, false otherwise.
+	*/
+	bool empty() const {
+		return m_size == 0;
+	}
+	void swap(mergeable_priority_dqueue & other) {
+		std::swap(m_roots[top_tree], other.m_roots[top_tree]);
+		std::swap(m_roots[bottom_tree], other.m_roots[bottom_tree]);
+		std::swap(m_size, other.m_size);
+		std::swap(m_comp, other.m_comp);
+		m_pool.swap(other.m_pool);
+	}
+};
+
+}
+
+#endif
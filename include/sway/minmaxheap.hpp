@@ -28,100 +28,278 @@ Based on the research paper:
 	Communications of the ACM, October 1986
 */
 
+/*
+The operations below give the basic exception guarantee: if the comparator
+throws, the range keeps the same elements, in an unspecified order that may
+not be a min-max heap.
+*/
+
 #ifndef SWAY_MIN_MAX_HEAP_HPP
 #define SWAY_MIN_MAX_HEAP_HPP
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
+#include <utility>
 #include <sway/detail/minmaxheap.hpp>
 
 namespace sway {
 
-template<class RAI>
-void make_minmaxheap(RAI first, RAI last) {
-	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
-	if (last - first >= 2) {
-		diff_t offset = (last - first) / 2 - 1;
-		for (RAI i = first + offset; i > first; --i) {
-			trickle_down(first, last, i);
-		}
-		trickle_down(first, last, first);
-	}
-}
-
 /*!
 Rearranges the values in the range [first,last) as a min-max heap.
 */
-template<class RAI, class Compare>
-void make_minmaxheap(RAI first, RAI last, Compare comp) {
+template<class RAI, class Compare, class Tracker = null_tracker>
+void make_minmaxheap(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
 	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
 	if (last - first >= 2) {
 		diff_t offset = (last - first) / 2 - 1;
-		for (RAI i = first + offset; i > first; --i) {
-			trickle_down(first, last, i, comp);
+		// the level is looked up once, then tracked while walking backwards
+		std::size_t level = get_level(first, last, first + offset);
+		diff_t level_first = (static_cast<diff_t>(1) << level) - 1;
+		for (RAI i = first + offset; ; --i) {
+			if (i - first < level_first) {
+				--level;
+				level_first = (level_first - 1) / 2;
+			}
+			if (level % 2 == 0) {
+				trickle_down_min(first, last, i, comp, track);
+			} else {
+				trickle_down_max(first, last, i, comp, track);
+			}
+			if (i == first) {
+				break;
+			}
 		}
-		trickle_down(first, last, first, comp);
 	}
 }
 
 template<class RAI>
-void popmin_minmaxheap(RAI first, RAI last) {
-	std::iter_swap(first, last-1);
-	trickle_down(first, last-1, first);
+void make_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	make_minmaxheap(first, last, std::less<value_t>());
 }
 
 /*!
 Moves the smallest value in the min-max heap to the end of the sequence,
 shortening the actual min-max heap range by one position.
 */
-template<class RAI, class Compare>
-void popmin_minmaxheap(RAI first, RAI last, Compare comp) {
-	std::iter_swap(first, last-1);
-	trickle_down(first, last-1, first, comp);
+template<class RAI, class Compare, class Tracker = null_tracker>
+void popmin_minmaxheap(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (last-first < 2) {
+		return;
+	}
+	value_t value = std::move(*(last-1));
+	*(last-1) = std::move(*first);
+	trickle_down_min_hole(first, last-1, first, value, comp, track);
 }
 
 template<class RAI>
-void popmax_minmaxheap(RAI first, RAI last) {
+void popmin_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmin_minmaxheap(first, last, std::less<value_t>());
+}
+
+/*!
+Moves the largest value in the min-max heap to the end of the sequence,
+shortening the actual min-max heap range by one position. */
+template<class RAI, class Compare, class Tracker = null_tracker>
+void popmax_minmaxheap(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
 	if (last-first < 2) {
 		return;
 	}
-	if (last-first == 2 || *(first+1) > *(first+2)) {
-		std::iter_swap(first+1, last-1);
-		trickle_down(first, last-1, first+1);
-	} else {
-		std::iter_swap(first+2, last-1);
-		trickle_down(first, last-1, first+2);
+	RAI max = first+1;
+	if (last-first > 2 && !comp(*(first+2), *(first+1))) {
+		max = first+2;
 	}
+	if (max == last-1) {
+		// the largest element is already in place
+		return;
+	}
+	value_t value = std::move(*(last-1));
+	*(last-1) = std::move(*max);
+	trickle_down_max_hole(first, last-1, max, value, comp, track);
+}
+
+template<class RAI>
+void popmax_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmax_minmaxheap(first, last, std::less<value_t>());
 }
 
 /*!
-Moves the largest value in the min-max heap to the end of the sequence,
-shortening the actual min-max heap range by one position. */
-template<class RAI, class Compare>
-void popmax_minmaxheap(RAI first, RAI last, Compare comp) {
+Same as popmin_minmaxheap, but the hole left by the smallest value is first
+moved down to a leaf along the path of the smallest grandchildren, and the
+last element is then bubbled up from there. This takes about half of the
+comparisons, which pays off with expensive comparators.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void popmin_bottom_up_minmaxheap(RAI first, RAI last, Compare comp,
+								 Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
 	if (last-first < 2) {
 		return;
 	}
-	if (last-first == 2 || comp(*(first+2), *(first+1))) {
-		std::iter_swap(first+1, last-1);
-		trickle_down(first, last-1, first+1, comp);
-	} else {
-		std::iter_swap(first+2, last-1);
-		trickle_down(first, last-1, first+2, comp);
+	value_t value = std::move(*(last-1));
+	*(last-1) = std::move(*first);
+	RAI hole = trickle_down_bottom_up_hole(first, last-1, first, value, comp,
+										   track);
+	hole = bubble_up_hole(first, last-1, hole, value, comp, track);
+	*hole = std::move(value);
+	track(first, hole);
+}
+
+template<class RAI>
+void popmin_bottom_up_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmin_bottom_up_minmaxheap(first, last, std::less<value_t>());
+}
+
+/*!
+Same as popmax_minmaxheap, using the bottom-up strategy of
+popmin_bottom_up_minmaxheap.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void popmax_bottom_up_minmaxheap(RAI first, RAI last, Compare comp,
+								 Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (last-first < 2) {
+		return;
+	}
+	RAI max = first+1;
+	if (last-first > 2 && !comp(*(first+2), *(first+1))) {
+		max = first+2;
+	}
+	if (max == last-1) {
+		// the largest element is already in place
+		return;
 	}
+	value_t value = std::move(*(last-1));
+	*(last-1) = std::move(*max);
+	RAI hole = trickle_down_bottom_up_hole(first, last-1, max, value,
+										   reverse_compare<Compare>(comp),
+										   track);
+	hole = bubble_up_hole(first, last-1, hole, value, comp, track);
+	*hole = std::move(value);
+	track(first, hole);
 }
 
 template<class RAI>
-void push_minmaxheap(RAI first, RAI last) {
-	bubble_up(first, last, last-1);
+void popmax_bottom_up_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	popmax_bottom_up_minmaxheap(first, last, std::less<value_t>());
+}
+
+/*!
+Given a min-max heap on the range [first,last) in which the value at
+position i has been modified, moves it to its correct position.
+Complexity O(log N).
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void update_minmaxheap(RAI first, RAI last, RAI i, Compare comp,
+					   Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	value_t value = std::move(*i);
+	update_hole(first, last, i, value, comp, track);
+}
+
+template<class RAI>
+void update_minmaxheap(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	update_minmaxheap(first, last, i, std::less<value_t>());
+}
+
+/*!
+Moves the value at position i of the min-max heap to the end of the
+sequence, shortening the actual min-max heap range by one position.
+Complexity O(log N).
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void erase_minmaxheap(RAI first, RAI last, RAI i, Compare comp,
+					  Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	if (i == last-1) {
+		return;
+	}
+	value_t value = std::move(*(last-1));
+	*(last-1) = std::move(*i);
+	update_hole(first, last-1, i, value, comp, track);
+}
+
+template<class RAI>
+void erase_minmaxheap(RAI first, RAI last, RAI i) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	erase_minmaxheap(first, last, i, std::less<value_t>());
 }
 
 /*! Given a min-max heap on the range [first,last), moves the element in the 
 last-1) position to its correct position.
 */
-template<class RAI, class Compare>
-void push_minmaxheap(RAI first, RAI last, Compare comp) {
-	bubble_up(first, last, last-1, comp);
+template<class RAI, class Compare, class Tracker = null_tracker>
+void push_minmaxheap(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
+	bubble_up(first, last, last-1, comp, track);
+}
+
+template<class RAI>
+void push_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	push_minmaxheap(first, last, std::less<value_t>());
+}
+
+/*!
+Given a min-max heap on the range [first,middle), makes [first,last) a
+min-max heap by inserting the elements in [middle,last).
+When only a few elements are added, they are pushed one by one, O(m log N).
+Otherwise, only the subtrees containing new elements are rebuilt, visiting
+their roots in the same order as make_minmaxheap, O(m + log^2 N).
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void push_range_minmaxheap(RAI first, RAI middle, RAI last, Compare comp,
+						   Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::difference_type diff_t;
+	diff_t count = middle - first;
+	diff_t added = last - middle;
+	if (added == 0) {
+		return;
+	}
+	if (count == 0) {
+		make_minmaxheap(first, last, comp, track);
+		return;
+	}
+	// a bubble up costs at most one comparison per level, while a rebuild
+	// costs about two trickle down steps per new element
+	std::size_t levels = get_level(first, last, last - 1) + 1;
+	if (static_cast<std::size_t>(added) <= levels) {
+		for (RAI i = middle + 1; i <= last; ++i) {
+			push_minmaxheap(first, i, comp, track);
+		}
+		return;
+	}
+	// the parents of a range of nodes form a range: walk up level by level,
+	// skipping the nodes that have already been visited
+	diff_t lo = (count - 1) / 2;
+	diff_t hi = (count + added - 2) / 2;
+	for (;;) {
+		for (diff_t k = hi; k >= lo; --k) {
+			trickle_down(first, last, first + k, comp, track);
+		}
+		if (lo == 0) {
+			break;
+		}
+		hi = std::min((hi - 1) / 2, lo - 1);
+		lo = (lo - 1) / 2;
+	}
+}
+
+template<class RAI>
+void push_range_minmaxheap(RAI first, RAI middle, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	push_range_minmaxheap(first, middle, last, std::less<value_t>());
 }
 
 template<class RAI>
@@ -139,7 +317,7 @@ template<class RAI>
 RAI max_minmaxheap(RAI first, RAI last) {
     typedef typename std::iterator_traits<RAI>::difference_type diff_t;
     diff_t count = last - first;
-    if (count == 1) {
+    if (count < 2) {
         return first;
     }
     RAI second = first + 1;
@@ -156,7 +334,7 @@ template<class RAI, class Compare>
 RAI max_minmaxheap(RAI first, RAI last, Compare comp) {
     typedef typename std::iterator_traits<RAI>::difference_type diff_t;
     diff_t count = last - first;
-    if (count == 1) {
+    if (count < 2) {
         return first;
     }
     RAI second = first + 1;
@@ -168,6 +346,233 @@ RAI max_minmaxheap(RAI first, RAI last, Compare comp) {
     return comp(*third, *second) ? second : third;
 }
 
+/*!
+Replaces the smallest value of the non-empty min-max heap [first,last) with
+obj, sifting it down once: equivalent to popmin_minmaxheap followed by
+push_minmaxheap, in a single traversal. obj is taken by value, so that an
+rvalue is moved into the heap.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void replacemin_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj,
+	Compare comp,
+	Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	value_t value(std::move(obj));
+	trickle_down_min_hole(first, last, first, value, comp, track);
+}
+
+template<class RAI>
+void replacemin_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	replacemin_minmaxheap(first, last, std::move(obj), std::less<value_t>());
+}
+
+/*!
+Replaces the largest value of the non-empty min-max heap [first,last) with
+obj, sifting it once: equivalent to popmax_minmaxheap followed by
+push_minmaxheap, in a single traversal. obj is taken by value, so that an
+rvalue is moved into the heap.
+*/
+template<class RAI, class Compare, class Tracker = null_tracker>
+void replacemax_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj,
+	Compare comp,
+	Tracker track = Tracker()) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	value_t value(std::move(obj));
+	RAI max = max_minmaxheap(first, last, comp);
+	if (max == first) {
+		*first = std::move(value);
+		track(first, first);
+		return;
+	}
+	if (comp(value, *first)) {
+		// obj becomes the smallest value, the old one sinks from the max level
+		using std::swap;
+		swap(value, *first);
+		track(first, first);
+	}
+	trickle_down_max_hole(first, last, max, value, comp, track);
+}
+
+template<class RAI>
+void replacemax_minmaxheap(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::value_type obj) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	replacemax_minmaxheap(first, last, std::move(obj), std::less<value_t>());
+}
+
+/*!
+Sorts the min-max heap [first,last) in ascending order, by moving the
+largest element to the end of the range N times. Complexity O(N log N).
+*/
+template<class RAI, class Compare>
+void sort_minmaxheap(RAI first, RAI last, Compare comp) {
+	for (; last - first > 1; --last) {
+		popmax_minmaxheap(first, last, comp);
+	}
+}
+
+template<class RAI>
+void sort_minmaxheap(RAI first, RAI last) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	sort_minmaxheap(first, last, std::less<value_t>());
+}
+
+/*!
+Rearranges the range [first,last) so that its first k_low positions contain
+the k_low smallest elements and its last k_high positions contain the k_high
+largest elements, both in ascending order. The order of the elements in the
+middle is unspecified.
+The range is scanned once: every element is offered to a max-heap of the
+smallest candidates, growing at the front of the range, and whatever it
+rejects or evicts is offered to a min-heap of the largest candidates,
+growing at the back. Each element costs about two comparisons, instead of
+one comparison per pass of two separate partial sorts.
+Complexity O(N log(k_low + k_high)).
+*/
+template<class RAI, class Compare>
+void partial_sort_both_ends(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::difference_type k_low,
+	typename std::iterator_traits<RAI>::difference_type k_high,
+	Compare comp) {
+	typedef std::reverse_iterator<RAI> reverse_t;
+	if (k_low + k_high >= last - first) {
+		std::sort(first, last, comp);
+		return;
+	}
+	// the high heap is handled through reverse iterators, so that it grows
+	// towards the front of the range like the low one
+	reverse_compare<Compare> rcomp(comp);
+	if (k_high == 0) {
+		std::partial_sort(first, first + k_low, last, comp);
+		return;
+	}
+	if (k_low == 0) {
+		std::partial_sort(reverse_t(last), reverse_t(last) + k_high,
+						  reverse_t(first), rcomp);
+		return;
+	}
+	RAI low_last = first + k_low;
+	std::make_heap(first, low_last, comp);
+	reverse_t high_first(last);
+	reverse_t high_last(last);
+	RAI i = low_last;
+	// fill the high heap with what the low heap rejects or evicts
+	while (high_last - high_first < k_high) {
+		if (comp(*i, *first)) {
+			std::pop_heap(first, low_last, comp);
+			std::iter_swap(i, low_last - 1);
+			std::push_heap(first, low_last, comp);
+		}
+		std::iter_swap(i, high_last);
+		++high_last;
+		std::push_heap(high_first, high_last, rcomp);
+	}
+	for (; i != high_last.base(); ++i) {
+		if (comp(*i, *first)) {
+			std::pop_heap(first, low_last, comp);
+			std::iter_swap(i, low_last - 1);
+			std::push_heap(first, low_last, comp);
+		}
+		if (comp(*high_first, *i)) {
+			std::pop_heap(high_first, high_last, rcomp);
+			std::iter_swap(i, high_last - 1);
+			std::push_heap(high_first, high_last, rcomp);
+		}
+	}
+	std::sort_heap(first, low_last, comp);
+	std::sort_heap(high_first, high_last, rcomp);
+}
+
+template<class RAI>
+void partial_sort_both_ends(
+	RAI first,
+	RAI last,
+	typename std::iterator_traits<RAI>::difference_type k_low,
+	typename std::iterator_traits<RAI>::difference_type k_high) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	partial_sort_both_ends(first, last, k_low, k_high, std::less<value_t>());
+}
+
+/*!
+Heap backend of the container adapters, forwarding to the binary min-max heap
+algorithms above. Alternative backends provide the same static functions.
+*/
+struct minmaxheap_backend {
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void make(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
+		make_minmaxheap(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void push(RAI first, RAI last, Compare comp,
+					 Tracker track = Tracker()) {
+		push_minmaxheap(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void push_range(RAI first, RAI middle, RAI last, Compare comp,
+						   Tracker track = Tracker()) {
+		push_range_minmaxheap(first, middle, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmin(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmin_minmaxheap(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmax(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmax_minmaxheap(first, last, comp, track);
+	}
+	template<class RAI, class T, class Compare, class Tracker = null_tracker>
+	static void replacemin(RAI first, RAI last, T && obj, Compare comp,
+						   Tracker track = Tracker()) {
+		replacemin_minmaxheap(first, last, std::forward<T>(obj), comp, track);
+	}
+	template<class RAI, class T, class Compare, class Tracker = null_tracker>
+	static void replacemax(RAI first, RAI last, T && obj, Compare comp,
+						   Tracker track = Tracker()) {
+		replacemax_minmaxheap(first, last, std::forward<T>(obj), comp, track);
+	}
+	template<class RAI, class Compare>
+	static RAI min(RAI first, RAI last, Compare comp) {
+		return min_minmaxheap(first, last, comp);
+	}
+	template<class RAI, class Compare>
+	static RAI max(RAI first, RAI last, Compare comp) {
+		return max_minmaxheap(first, last, comp);
+	}
+};
+
+/*!
+Same as minmaxheap_backend, with bottom-up removals.
+*/
+struct bottom_up_minmaxheap_backend : minmaxheap_backend {
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmin(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmin_bottom_up_minmaxheap(first, last, comp, track);
+	}
+	template<class RAI, class Compare, class Tracker = null_tracker>
+	static void popmax(RAI first, RAI last, Compare comp,
+					   Tracker track = Tracker()) {
+		popmax_bottom_up_minmaxheap(first, last, comp, track);
+	}
+};
+
 }
 
 #endif
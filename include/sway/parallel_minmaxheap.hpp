@@ -0,0 +1,159 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Multi-threaded construction of the min-max heap.
+
+The subtrees rooted at a given level of the heap are disjoint, so Floyd's
+heapify can process them concurrently: each thread takes a block of
+consecutive roots of the cutoff level and trickles down, level by level from
+the bottom, the nodes of their subtrees. The nodes of a block on one level are
+contiguous in memory. The levels above the cutoff, a few hundred nodes, are
+then heapified by the calling thread.
+*/
+
+#ifndef SWAY_PARALLEL_MINMAXHEAP_HPP
+#define SWAY_PARALLEL_MINMAXHEAP_HPP
+
+#include <sway/minmaxheap.hpp>
+#include <sway/ilog2.hpp>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sway {
+
+namespace detail {
+
+/*
+Heapifies the subtrees of the roots [first+root_first,first+root_last), which
+are on level root_level, visiting their nodes from the deepest internal level
+up to the roots.
+*/
+template<class RAI, class Compare>
+void make_minmaxheap_subtrees(RAI first, RAI last, std::size_t root_level,
+							  std::size_t root_first, std::size_t root_last,
+							  Compare comp) {
+	std::size_t internal = static_cast<std::size_t>(last - first) / 2;
+	std::size_t depth = ilog2(internal) - root_level;
+	for (std::size_t d = depth + 1; d-- > 0; ) {
+		std::size_t lo = ((root_first + 1) << d) - 1;
+		std::size_t hi = std::min(((root_last + 1) << d) - 1, internal);
+		bool min_level = (root_level + d) % 2 == 0;
+		for (std::size_t i = hi; i-- > lo; ) {
+			if (min_level) {
+				trickle_down_min(first, last, first + i, comp);
+			} else {
+				trickle_down_max(first, last, first + i, comp);
+			}
+		}
+	}
+}
+
+}
+
+/*!
+Rearranges the values in the range [first,last) as a min-max heap, using up
+to the given number of threads (by default, one per hardware thread).
+The result is a valid min-max heap, not necessarily the one built by
+make_minmaxheap. Small ranges are heapified by the calling thread.
+The comparator is copied to each thread and must be safe to call
+concurrently on distinct elements. If it throws, the range keeps the same
+elements in an unspecified order, as with make_minmaxheap, and the first
+exception is rethrown.
+*/
+template<class RAI, class Compare>
+void make_parallel_minmaxheap(RAI first, RAI last, Compare comp,
+							  unsigned threads = 0) {
+	// below this size the threads cost more than they save
+	static const std::size_t min_parallel_size = 1 << 16;
+	// blocks handed out per thread, to balance the partially filled bottom
+	// level and the differences between the cores
+	static const std::size_t blocks_per_thread = 8;
+	std::size_t n = static_cast<std::size_t>(last - first);
+	if (threads == 0) {
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	if (threads == 1 || n < min_parallel_size) {
+		make_minmaxheap(first, last, comp);
+		return;
+	}
+	std::size_t blocks = threads * blocks_per_thread;
+	// cutoff level with at least one root per block, above the last
+	// internal level
+	std::size_t root_level = std::min(ilog2(blocks - 1) + 1, ilog2(n / 2));
+	std::size_t level_first = (static_cast<std::size_t>(1) << root_level) - 1;
+	std::size_t roots = level_first + 1;
+	blocks = std::min(blocks, roots);
+
+	std::atomic<std::size_t> next(0);
+	std::exception_ptr error;
+	std::mutex error_mutex;
+	auto worker = [&]() {
+		try {
+			for (std::size_t b = next++; b < blocks; b = next++) {
+				detail::make_minmaxheap_subtrees(
+					first, last, root_level,
+					level_first + b * roots / blocks,
+					level_first + (b + 1) * roots / blocks, comp);
+			}
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+			next = blocks;
+		}
+	};
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+	for (unsigned t = 1; t < threads; ++t) {
+		pool.push_back(std::thread(worker));
+	}
+	worker();
+	for (std::size_t t = 0; t < pool.size(); ++t) {
+		pool[t].join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+
+	for (std::size_t i = level_first; i-- > 0; ) {
+		trickle_down(first, last, first + i, comp);
+	}
+}
+
+template<class RAI>
+void make_parallel_minmaxheap(RAI first, RAI last, unsigned threads = 0) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	make_parallel_minmaxheap(first, last, std::less<value_t>(), threads);
+}
+
+}
+
+#endif
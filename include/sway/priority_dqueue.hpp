@@ -25,7 +25,16 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define SWAY_PRIORITY_DQUEUE_HPP
 
 #include <sway/minmaxheap.hpp>
+#include <sway/instrumentation.hpp>
+#include <sway/radix_backend.hpp>
+#include <sway/snapshot.hpp>
+#include <sway/detail/radix_buckets.hpp>
+#include <cstddef>
 #include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace sway {
@@ -34,16 +43,35 @@ namespace sway {
 This template class is a container adapter, implementing a double-ended
 priority queue.
 The implementation is based on the min-max heap implicit data structure.
-If no container template parameter is specified, a vector is used.
+If no container template parameter is specified, a vector is used; the
+container must provide random access iterators, push_back, emplace_back,
+pop_back, clear and range insert; with inline_vector a small queue does not
+allocate memory, with mapped_vector a snapshot is restored in place (see
+load).
 If no comparer template parameter is specified, the < operator is used.
+The heap algorithms are provided by the Backend template parameter, which
+defaults to the binary min-max heap (see dary_minmaxheap_backend for the
+D-ary alternative); radix_backend selects the bucket based specialization
+below for unsigned integers in a bounded range.
+The Instrumentation template parameter can record statistics about the
+operations (see counting_instrumentation); by default nothing is recorded.
 */
 template<class T,
 		 class Container = std::vector<T>,
-		 class Compare = std::less<T> >
+		 class Compare = std::less<T>,
+		 class Backend = typename default_backend<T, Compare>::type,
+		 class Instrumentation = null_instrumentation>
 class priority_dqueue {
 private:
-	std::vector<T> m_heap;
+	Container m_heap;
 	Compare m_comp;
+	Instrumentation m_instr;
+	typedef typename Instrumentation::scope scope;
+	void make() {
+		scope s(m_instr, op_make);
+		Backend::make(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					  m_instr.tracker());
+	}
 public:
 	/*!
 	Constructs an empty queue.
@@ -53,21 +81,105 @@ public:
 	}
 	/*!
 	Constructs a queue containing the items of the container.
+	The heap is built in linear time.
 	*/
 	priority_dqueue(const Container & container,
-                    const Compare & comp = Compare())
-		: m_heap(container.size()), m_comp(comp) {
-		typename Container::const_iterator itr;
-		for (itr = container.begin(); itr != container.end(); ++itr) {
-			push(*itr);
-		}
+					const Compare & comp = Compare())
+		: m_heap(container), m_comp(comp) {
+		make();
+	}
+	/*!
+	Constructs a queue taking ownership of the items of the container.
+	The heap is built in linear time.
+	*/
+	priority_dqueue(Container && container,
+					const Compare & comp = Compare())
+		: m_heap(std::move(container)), m_comp(comp) {
+		make();
+	}
+	/*!
+	Constructs a queue containing the elements in the range [first,last).
+	The heap is built in linear time; with move iterators the elements are
+	moved into the queue.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	priority_dqueue(InputIterator first, InputIterator last,
+					const Compare & comp = Compare())
+		: m_comp(comp) {
+		m_heap.insert(m_heap.end(), first, last);
+		make();
+	}
+	/*!
+	Replaces the elements of the queue with those in the range [first,last),
+	building the heap in linear time.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void assign(InputIterator first, InputIterator last) {
+		m_heap.clear();
+		m_heap.insert(m_heap.end(), first, last);
+		make();
+	}
+	/*!
+	Replaces the elements of the queue with the items of the container,
+	building the heap in linear time.
+	*/
+	void assign(const Container & container) {
+		m_heap = container;
+		make();
+	}
+	/*!
+	Replaces the elements of the queue with the items of the container,
+	taking ownership of them, and builds the heap in linear time.
+	*/
+	void assign(Container && container) {
+		m_heap = std::move(container);
+		make();
 	}
 	/*!
 	Adds a new element to the queue.
 	*/
 	void push(const T & obj) {
-	    m_heap.push_back(obj);
-		push_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+		scope s(m_instr, op_push);
+		m_heap.push_back(obj);
+		Backend::push(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					  m_instr.tracker());
+	}
+	/*!
+	Adds a new element to the queue, moving it into the queue.
+	*/
+	void push(T && obj) {
+		scope s(m_instr, op_push);
+		m_heap.push_back(std::move(obj));
+		Backend::push(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					  m_instr.tracker());
+	}
+	/*!
+	Adds a new element to the queue, constructed in place from the
+	arguments.
+	*/
+	template<class... Args>
+	void emplace(Args &&... args) {
+		scope s(m_instr, op_push);
+		m_heap.emplace_back(std::forward<Args>(args)...);
+		Backend::push(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					  m_instr.tracker());
+	}
+	/*!
+	Adds the elements in the range [first,last) to the queue.
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void push(InputIterator first, InputIterator last) {
+		scope s(m_instr, op_push_range);
+		std::size_t count = m_heap.size();
+		m_heap.insert(m_heap.end(), first, last);
+		Backend::push_range(m_heap.begin(),
+							m_heap.begin() + count,
+							m_heap.end(),
+							m_instr.compare(m_comp),
+							m_instr.tracker());
 	}
 	/*!
 	Returns a reference to the highest priority element of the queue.
@@ -79,25 +191,65 @@ public:
 	Returns a reference to the lowest priority element of the queue.
 	*/
 	const T & bottom() const {
-		if (m_heap.size() == 1) {
-			return m_heap[0];
-		}
-		if (m_heap.size() == 2) {
-			return m_heap[1];
-		}
-		return m_comp(m_heap[2], m_heap[1]) ? m_heap[1] : m_heap[2];
+		return *(Backend::max(m_heap.begin(), m_heap.end(), m_comp));
 	}
 	/*!
 	Removes the highest priority element of the queue.
 	*/
 	void pop_top() {
-		popmin_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+		scope s(m_instr, op_pop_top);
+		Backend::popmin(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					   m_instr.tracker());
+		m_heap.pop_back();
 	}
 	/*!
 	Removes the lowest priority element of the queue.
 	*/
 	void pop_bottom() {
-		popmax_minmaxheap(m_heap.begin(), m_heap.end(), m_comp);
+		scope s(m_instr, op_pop_bottom);
+		Backend::popmax(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					   m_instr.tracker());
+		m_heap.pop_back();
+	}
+	/*!
+	Removes the highest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_top() {
+		scope s(m_instr, op_pop_top);
+		Backend::popmin(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					   m_instr.tracker());
+		T obj(std::move(m_heap.back()));
+		m_heap.pop_back();
+		return obj;
+	}
+	/*!
+	Removes the lowest priority element of the queue and returns it, moved
+	out of the queue.
+	*/
+	T extract_bottom() {
+		scope s(m_instr, op_pop_bottom);
+		Backend::popmax(m_heap.begin(), m_heap.end(), m_instr.compare(m_comp),
+					   m_instr.tracker());
+		T obj(std::move(m_heap.back()));
+		m_heap.pop_back();
+		return obj;
+	}
+	/*!
+	Replaces the highest priority element of the queue with a new element.
+	*/
+	void replace_top(const T & obj) {
+		scope s(m_instr, op_replace_top);
+		Backend::replacemin(m_heap.begin(), m_heap.end(), obj,
+							m_instr.compare(m_comp), m_instr.tracker());
+	}
+	/*!
+	Replaces the lowest priority element of the queue with a new element.
+	*/
+	void replace_bottom(const T & obj) {
+		scope s(m_instr, op_replace_bottom);
+		Backend::replacemax(m_heap.begin(), m_heap.end(), obj,
+							m_instr.compare(m_comp), m_instr.tracker());
 	}
 	/*!
 	Returns the number of elements stored in the queue.
@@ -111,6 +263,230 @@ public:
 	bool empty() const {
 		return m_heap.empty();
 	}
+	/*!
+	Writes the heap array to a snapshot file at path, with a header holding
+	the number and the size of the elements and a checksum. The elements
+	must be trivially copyable; the file is replaced atomically.
+	*/
+	void save(const std::string & path) const {
+		detail::save_snapshot(path, m_heap.begin(), m_heap.end(),
+							  m_heap.size());
+	}
+	/*!
+	Replaces the elements of the queue with those of the snapshot at path,
+	which must have been saved by a queue with the same Compare and
+	Backend: the array is already a heap and is not rebuilt. The elements
+	are read into the container with stdio or, if it is a mapped_vector,
+	the file is mapped and used in place (see restore_snapshot). Throws
+	snapshot_error if the file is not a valid snapshot of elements of this
+	size, leaving the queue unchanged.
+	*/
+	void load(const std::string & path) {
+		restore_snapshot(m_heap, path);
+	}
+	/*!
+	Returns the instrumentation policy, to read the statistics it recorded.
+	*/
+	const Instrumentation & instrumentation() const {
+		return m_instr;
+	}
+};
+
+/*!
+Specialization of priority_dqueue for unsigned integers in
+[base,base+2^Bits), selected by radix_backend; base is given to the
+constructors and defaults to 0, so that a window of timestamps or scores far
+from 0 can be stored without shifting the keys. The elements are counted in
+one bucket per key, with a hierarchy of bitmaps to find the smallest and
+largest non-empty buckets (see detail::radix_buckets): push is O(1), pop_top
+and pop_bottom scan ceil(Bits/6) words, and top and bottom are cached.
+The Compare must be std::less or std::greater, and the order follows from
+the type: the comparator arguments of the constructors are only accepted
+for compatibility with the generic queue, and ignored. The Container is
+only used to pass the initial elements, and no comparison is reported to
+the Instrumentation. As no array is stored, top and bottom return by value
+and there is no save and load.
+Pushing an element out of [base,base+2^Bits) throws std::out_of_range.
+*/
+template<class T,
+		 class Container,
+		 class Compare,
+		 unsigned Bits,
+		 class Instrumentation>
+class priority_dqueue<T, Container, Compare, radix_backend<Bits>,
+					  Instrumentation> {
+	static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value,
+				  "radix_backend needs unsigned integer elements");
+	static_assert(std::is_same<Compare, std::less<T> >::value ||
+				  std::is_same<Compare, std::greater<T> >::value,
+				  "radix_backend needs std::less or std::greater");
+private:
+	static const bool descending =
+		std::is_same<Compare, std::greater<T> >::value;
+	detail::radix_buckets<Bits> m_buckets;
+	T m_base;
+	Instrumentation m_instr;
+	typedef typename Instrumentation::scope scope;
+	void insert(const T & obj) {
+		if (obj < m_base || ((obj - m_base) >> Bits) != 0) {
+			throw std::out_of_range("priority_dqueue: key out of the radix range");
+		}
+		m_buckets.insert(static_cast<std::size_t>(obj - m_base));
+	}
+	template<class InputIterator>
+	void insert(InputIterator first, InputIterator last) {
+		for (; first != last; ++first) {
+			insert(*first);
+		}
+	}
+	std::size_t top_key() const {
+		return descending ? m_buckets.max() : m_buckets.min();
+	}
+	std::size_t bottom_key() const {
+		return descending ? m_buckets.min() : m_buckets.max();
+	}
+	void make(const Container & container) {
+		scope s(m_instr, op_make);
+		insert(container.begin(), container.end());
+	}
+public:
+	priority_dqueue(const Compare & = Compare()) : m_base(0) {
+	}
+	/*!
+	Constructs an empty queue for the elements in [base,base+2^Bits).
+	*/
+	explicit priority_dqueue(T base, const Compare & = Compare())
+		: m_base(base) {
+	}
+	priority_dqueue(const Container & container,
+					const Compare & comp = Compare())
+		: priority_dqueue(container, T(0), comp) {
+	}
+	/*!
+	Constructs a queue for the elements in [base,base+2^Bits), containing
+	the items of the container.
+	*/
+	priority_dqueue(const Container & container, T base,
+					const Compare & = Compare())
+		: m_base(base) {
+		make(container);
+	}
+	/*!
+	Same as the copying constructors: the items are counted, so there is
+	nothing to take ownership of.
+	*/
+	priority_dqueue(Container && container, const Compare & comp = Compare())
+		: priority_dqueue(container, T(0), comp) {
+	}
+	priority_dqueue(Container && container, T base,
+					const Compare & comp = Compare())
+		: priority_dqueue(container, base, comp) {
+	}
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	priority_dqueue(InputIterator first, InputIterator last,
+					const Compare & comp = Compare())
+		: priority_dqueue(first, last, T(0), comp) {
+	}
+	/*!
+	Constructs a queue for the elements in [base,base+2^Bits), containing
+	the elements in the range [first,last).
+	*/
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	priority_dqueue(InputIterator first, InputIterator last, T base,
+					const Compare & = Compare())
+		: m_base(base) {
+		scope s(m_instr, op_make);
+		insert(first, last);
+	}
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void assign(InputIterator first, InputIterator last) {
+		m_buckets.clear();
+		scope s(m_instr, op_make);
+		insert(first, last);
+	}
+	void assign(const Container & container) {
+		m_buckets.clear();
+		make(container);
+	}
+	void assign(Container && container) {
+		assign(static_cast<const Container &>(container));
+	}
+	void push(const T & obj) {
+		scope s(m_instr, op_push);
+		insert(obj);
+	}
+	template<class... Args>
+	void emplace(Args &&... args) {
+		scope s(m_instr, op_push);
+		insert(T(std::forward<Args>(args)...));
+	}
+	template<class InputIterator, class = typename std::enable_if<
+		!std::is_integral<InputIterator>::value>::type>
+	void push(InputIterator first, InputIterator last) {
+		scope s(m_instr, op_push_range);
+		insert(first, last);
+	}
+	/*!
+	Returns the highest priority element of the queue; the elements are not
+	stored, so it is returned by value.
+	*/
+	T top() const {
+		return static_cast<T>(m_base + top_key());
+	}
+	/*!
+	Returns the lowest priority element of the queue, by value.
+	*/
+	T bottom() const {
+		return static_cast<T>(m_base + bottom_key());
+	}
+	void pop_top() {
+		scope s(m_instr, op_pop_top);
+		m_buckets.erase(top_key());
+	}
+	void pop_bottom() {
+		scope s(m_instr, op_pop_bottom);
+		m_buckets.erase(bottom_key());
+	}
+	T extract_top() {
+		T obj = top();
+		pop_top();
+		return obj;
+	}
+	T extract_bottom() {
+		T obj = bottom();
+		pop_bottom();
+		return obj;
+	}
+	void replace_top(const T & obj) {
+		scope s(m_instr, op_replace_top);
+		std::size_t key = top_key();
+		insert(obj);
+		m_buckets.erase(key);
+	}
+	void replace_bottom(const T & obj) {
+		scope s(m_instr, op_replace_bottom);
+		std::size_t key = bottom_key();
+		insert(obj);
+		m_buckets.erase(key);
+	}
+	/*!
+	Returns the smallest element the queue can store.
+	*/
+	T base() const {
+		return m_base;
+	}
+	std::size_t size() const {
+		return m_buckets.size();
+	}
+	bool empty() const {
+		return m_buckets.size() == 0;
+	}
+	const Instrumentation & instrumentation() const {
+		return m_instr;
+	}
 };
 
 }
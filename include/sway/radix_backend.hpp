@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_RADIX_BACKEND_HPP
+#define SWAY_RADIX_BACKEND_HPP
+
+#include <sway/minmaxheap.hpp>
+
+namespace sway {
+
+/*!
+Tag selecting, as the Backend of priority_dqueue, the radix specialization
+for unsigned integer elements in [base,base+2^Bits), where base is given to
+the constructor: instead of a heap, the queue keeps a counter per key and a
+hierarchy of bitmaps over the non-empty keys, so push is O(1) and pop_top
+and pop_bottom take ceil(Bits/6) bit scans. The queue allocates 4 bytes per
+key upfront, so Bits is at most 24. It is never selected by default.
+*/
+template<unsigned Bits>
+struct radix_backend {
+	static_assert(Bits >= 1 && Bits <= 24,
+				  "radix_backend supports keys of 1 to 24 bits");
+};
+
+/*!
+Default Backend of priority_dqueue, the binary min-max heap for every
+element type: the radix specialization changes the storage, the memory
+footprint and the return type of top and bottom, so it must be asked for
+explicitly with radix_backend.
+*/
+template<class T, class Compare>
+struct default_backend {
+	typedef minmaxheap_backend type;
+};
+
+}
+
+#endif
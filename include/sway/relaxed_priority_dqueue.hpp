@@ -0,0 +1,360 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_RELAXED_PRIORITY_DQUEUE_HPP
+#define SWAY_RELAXED_PRIORITY_DQUEUE_HPP
+
+#include <sway/minmaxheap.hpp>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace sway {
+
+namespace detail {
+
+/*
+True if std::atomic<T> exists and is lock-free, so that the ends of a shard
+can be cached for reading without its lock.
+*/
+template<class T>
+struct has_lock_free_atomic : std::integral_constant<bool,
+	std::is_trivially_copyable<T>::value &&
+	std::conditional<std::is_trivially_copyable<T>::value,
+					 std::atomic<T>,
+					 std::atomic<int> >::type::is_always_lock_free> {
+};
+
+/*
+Copies of the highest and lowest priority elements of a shard, written under
+the lock of the shard and read without it.
+*/
+template<class T, bool LockFree = has_lock_free_atomic<T>::value>
+struct relaxed_ends {
+	std::atomic<T> top;
+	std::atomic<T> bottom;
+	relaxed_ends() : top(T()), bottom(T()) {
+	}
+	void store(const T & t, const T & b) {
+		top.store(t, std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+	}
+};
+
+template<class T>
+struct relaxed_ends<T, false> {
+	void store(const T &, const T &) {
+	}
+};
+
+}
+
+/*!
+This template class implements a relaxed double-ended priority queue that
+can be used concurrently by several threads, in the style of the MultiQueue.
+The elements are spread over a number of shards, each one a min-max heap
+behind its own try-lock; a good choice is two to four shards per thread.
+push inserts into a random shard. try_pop_top and try_pop_bottom sample two
+random shards and remove the best end of the two: the element removed is
+not necessarily the highest (lowest) priority one, but its rank is small on
+average, growing with the number of shards.
+When the elements are small and trivially copyable (std::atomic<T> is
+lock-free), each shard caches its ends, so that the two shards are compared
+without taking their locks and only the chosen one is locked; otherwise both
+are try-locked and compared. The cached ends also allow try_peek_top and
+try_peek_bottom, which take no lock at all.
+A thread never blocks on a shard: if its try-lock fails, it samples again.
+If no comparer template parameter is specified, the < operator is used.
+*/
+template<class T,
+		 class Compare = std::less<T>,
+		 class Backend = minmaxheap_backend>
+class relaxed_priority_dqueue {
+public:
+	static const std::size_t cache_line_size = 64;
+private:
+	typedef detail::has_lock_free_atomic<T> cached_ends;
+	struct alignas(cache_line_size) shard {
+		std::atomic<bool> locked;
+		// number of elements, read without the lock
+		std::atomic<std::size_t> count;
+		std::vector<T> heap;
+		detail::relaxed_ends<T> ends;
+		shard() : locked(false), count(0) {
+		}
+		bool try_lock() {
+			return !locked.load(std::memory_order_relaxed) &&
+				!locked.exchange(true, std::memory_order_acquire);
+		}
+		void unlock() {
+			locked.store(false, std::memory_order_release);
+		}
+	};
+	std::size_t m_shard_count;
+	std::unique_ptr<shard[]> m_shards;
+	Compare m_comp;
+
+	shard & random_shard() {
+		static thread_local boost::uint64_t state = 0;
+		if (state == 0) {
+			state = (std::hash<std::thread::id>()(std::this_thread::get_id())
+					 ^ reinterpret_cast<std::size_t>(&state))
+				* 0x9E3779B97F4A7C15ull | 1;
+		}
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return m_shards[state % m_shard_count];
+	}
+	// must be called with the lock of s held; the ends are stored before
+	// the count is released, so a reader that sees a non-zero count also
+	// sees ends at least as recent
+	void update(shard & s) {
+		if (!s.heap.empty()) {
+			s.ends.store(s.heap[0],
+						 *Backend::max(s.heap.begin(), s.heap.end(), m_comp));
+		}
+		s.count.store(s.heap.size(), std::memory_order_release);
+	}
+	// best cached end among the non-empty shards, read without locks
+	bool peek(T & obj, bool top) const {
+		static_assert(cached_ends::value,
+					  "peeking needs elements for which std::atomic is "
+					  "lock-free");
+		Compare comp(m_comp);
+		bool found = false;
+		T best = T();
+		for (std::size_t i = 0; i < m_shard_count; ++i) {
+			const shard & s = m_shards[i];
+			if (s.count.load(std::memory_order_acquire) == 0) {
+				continue;
+			}
+			T end = top ? s.ends.top.load(std::memory_order_relaxed)
+						: s.ends.bottom.load(std::memory_order_relaxed);
+			if (!found || (top ? comp(end, best) : comp(best, end))) {
+				best = end;
+				found = true;
+			}
+		}
+		if (found) {
+			obj = best;
+		}
+		return found;
+	}
+	// true if the end of a has a higher priority than the end of b
+	bool better(shard & a, shard & b, bool top, std::true_type) {
+		if (top) {
+			return !m_comp(b.ends.top.load(std::memory_order_relaxed),
+						   a.ends.top.load(std::memory_order_relaxed));
+		} else {
+			return !m_comp(a.ends.bottom.load(std::memory_order_relaxed),
+						   b.ends.bottom.load(std::memory_order_relaxed));
+		}
+	}
+	bool better(shard & a, shard & b, bool top, std::false_type) {
+		if (top) {
+			return !m_comp(b.heap[0], a.heap[0]);
+		} else {
+			return !m_comp(*Backend::max(a.heap.begin(), a.heap.end(), m_comp),
+						   *Backend::max(b.heap.begin(), b.heap.end(), m_comp));
+		}
+	}
+	/*
+	Locks the shard with the best end among a and b, comparing the cached
+	ends. Returns 0 if the lock fails.
+	*/
+	shard * lock_best(shard & a, shard & b, bool top, std::true_type) {
+		shard * s = &b;
+		if (b.count.load(std::memory_order_relaxed) == 0 ||
+			(a.count.load(std::memory_order_relaxed) != 0 &&
+			 better(a, b, top, cached_ends()))) {
+			s = &a;
+		}
+		return s->try_lock() ? s : 0;
+	}
+	/*
+	Locks a and b, and keeps the lock of the shard with the best end.
+	If only one lock succeeds, that shard is chosen. Returns 0 if both fail.
+	*/
+	shard * lock_best(shard & a, shard & b, bool top, std::false_type) {
+		bool locked_a = a.try_lock();
+		bool locked_b = &a != &b && b.try_lock();
+		if (!locked_a || !locked_b) {
+			return locked_a ? &a : (locked_b ? &b : 0);
+		}
+		if (b.heap.empty() ||
+			(!a.heap.empty() && better(a, b, top, cached_ends()))) {
+			b.unlock();
+			return &a;
+		}
+		a.unlock();
+		return &b;
+	}
+	// returns a locked non-empty shard, or 0 if all the shards look empty
+	shard * lock_nonempty(bool top) {
+		for (;;) {
+			shard & a = random_shard();
+			shard & b = random_shard();
+			shard * s;
+			if (a.count.load(std::memory_order_relaxed) == 0 &&
+				b.count.load(std::memory_order_relaxed) == 0) {
+				// few elements left: scan for them, starting from a
+				s = 0;
+				for (std::size_t i = &a - m_shards.get(), n = 0;
+					 n < m_shard_count && s == 0; ++n) {
+					shard & c = m_shards[(i + n) % m_shard_count];
+					if (c.count.load(std::memory_order_relaxed) != 0) {
+						s = &c;
+					}
+				}
+				if (s == 0) {
+					return 0;
+				}
+				if (!s->try_lock()) {
+					continue;
+				}
+			} else {
+				s = lock_best(a, b, top, cached_ends());
+			}
+			if (s == 0) {
+				continue;
+			}
+			if (s->heap.empty()) {
+				s->unlock();
+				continue;
+			}
+			return s;
+		}
+	}
+	relaxed_priority_dqueue(const relaxed_priority_dqueue &);
+	relaxed_priority_dqueue & operator=(const relaxed_priority_dqueue &);
+public:
+	/*!
+	Constructs an empty queue with the given number of shards.
+	*/
+	relaxed_priority_dqueue(std::size_t shards,
+							const Compare & comp = Compare())
+		: m_shard_count(shards), m_shards(new shard[shards]), m_comp(comp) {
+	}
+	/*!
+	Adds a new element to the queue.
+	*/
+	void push(const T & obj) {
+		shard * s;
+		do {
+			s = &random_shard();
+		} while (!s->try_lock());
+		s->heap.push_back(obj);
+		Backend::push(s->heap.begin(), s->heap.end(), m_comp);
+		update(*s);
+		s->unlock();
+	}
+	/*!
+	Removes a high priority element of the queue, moving it to obj.
+	Returns false, leaving obj unmodified, if the queue is empty.
+	*/
+	bool try_pop_top(T & obj) {
+		shard * s = lock_nonempty(true);
+		if (s == 0) {
+			return false;
+		}
+		Backend::popmin(s->heap.begin(), s->heap.end(), m_comp);
+		obj = std::move(s->heap.back());
+		s->heap.pop_back();
+		update(*s);
+		s->unlock();
+		return true;
+	}
+	/*!
+	Removes a low priority element of the queue, moving it to obj.
+	Returns false, leaving obj unmodified, if the queue is empty.
+	*/
+	bool try_pop_bottom(T & obj) {
+		shard * s = lock_nonempty(false);
+		if (s == 0) {
+			return false;
+		}
+		Backend::popmax(s->heap.begin(), s->heap.end(), m_comp);
+		obj = std::move(s->heap.back());
+		s->heap.pop_back();
+		update(*s);
+		s->unlock();
+		return true;
+	}
+	/*!
+	Copies the highest priority element of the queue to obj, reading the
+	cached ends of the shards without taking any lock.
+	Returns false, leaving obj unmodified, if the queue is empty. While
+	other threads modify the queue, the result is relaxed: the element may
+	already have been removed, or a higher priority one added.
+	Only available when std::atomic<T> is lock-free.
+	*/
+	bool try_peek_top(T & obj) const {
+		return peek(obj, true);
+	}
+	/*!
+	Copies the lowest priority element of the queue to obj, as try_peek_top.
+	*/
+	bool try_peek_bottom(T & obj) const {
+		return peek(obj, false);
+	}
+	/*!
+	Returns the number of elements stored in the queue. While other threads
+	modify the queue, the result is approximate.
+	*/
+	std::size_t size() const {
+		std::size_t total = 0;
+		for (std::size_t i = 0; i < m_shard_count; ++i) {
+			total += m_shards[i].count.load(std::memory_order_relaxed);
+		}
+		return total;
+	}
+	/*!
+	Returns true if the queue has no elements, false otherwise. While other
+	threads modify the queue, the result is approximate.
+	*/
+	bool empty() const {
+		for (std::size_t i = 0; i < m_shard_count; ++i) {
+			if (m_shards[i].count.load(std::memory_order_relaxed) != 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+	/*!
+	Returns the number of shards.
+	*/
+	std::size_t shards() const {
+		return m_shard_count;
+	}
+};
+
+}
+
+#endif
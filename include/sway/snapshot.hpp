@@ -0,0 +1,410 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_SNAPSHOT_HPP
+#define SWAY_SNAPSHOT_HPP
+
+#include <sway/detail/file_io.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+namespace sway {
+
+/*!
+Thrown when a snapshot cannot be written, or cannot be read or does not
+match the queue it is loaded into.
+*/
+class snapshot_error : public std::runtime_error {
+public:
+	snapshot_error(const std::string & msg) : std::runtime_error(msg) {
+	}
+};
+
+namespace detail {
+
+/*
+Header of a snapshot file. The elements follow at offset data_offset, in
+the order of the heap array, with the byte order and layout of the machine
+that saved them. checksum covers the elements, header_checksum the header
+itself, so that a corrupted count or capacity is caught before it is used
+to size anything.
+*/
+struct snapshot_header {
+	char magic[8];
+	boost::uint32_t version;
+	boost::uint32_t element_size;
+	boost::uint64_t count;
+	boost::uint64_t capacity;
+	boost::uint64_t checksum;
+	boost::uint64_t header_checksum;
+	static const std::size_t data_offset = 64;
+	static const boost::uint32_t current_version = 2;
+};
+
+static_assert(sizeof(snapshot_header) <= snapshot_header::data_offset,
+			  "the snapshot header must fit before the elements");
+
+static const char snapshot_magic[8] = { 'S', 'W', 'A', 'Y', 'S', 'N', 'A', 'P' };
+
+/*
+64 bits checksum of a byte stream, fed in pieces of any size: the stream is
+cut in 32 bytes blocks, whose four 8 bytes words are combined by four
+independent FNV-1a style multiply and xor chains, so that the multiplies
+overlap; the chains and the tail are folded together at the end.
+*/
+class snapshot_checksum {
+private:
+	static const boost::uint64_t prime = 0x100000001b3ull;
+	boost::uint64_t m_lanes[4];
+	boost::uint64_t m_length;
+	unsigned char m_pending[32];
+	std::size_t m_pending_size;
+	void block(const unsigned char * p) {
+		for (int i = 0; i < 4; ++i) {
+			boost::uint64_t w;
+			std::memcpy(&w, p + 8 * i, 8);
+			m_lanes[i] = (m_lanes[i] ^ w) * prime;
+		}
+	}
+public:
+	snapshot_checksum() : m_length(0), m_pending_size(0) {
+		for (int i = 0; i < 4; ++i) {
+			m_lanes[i] = 0xcbf29ce484222325ull + i;
+		}
+	}
+	void update(const void * data, std::size_t size) {
+		const unsigned char * p = static_cast<const unsigned char *>(data);
+		m_length += size;
+		if (m_pending_size != 0) {
+			std::size_t n = std::min(size, 32 - m_pending_size);
+			std::memcpy(m_pending + m_pending_size, p, n);
+			m_pending_size += n;
+			p += n;
+			size -= n;
+			if (m_pending_size < 32) {
+				return;
+			}
+			block(m_pending);
+			m_pending_size = 0;
+		}
+		for (; size >= 32; p += 32, size -= 32) {
+			block(p);
+		}
+		std::memcpy(m_pending, p, size);
+		m_pending_size = size;
+	}
+	boost::uint64_t value() const {
+		boost::uint64_t h = m_length;
+		for (int i = 0; i < 4; ++i) {
+			h = (h ^ m_lanes[i]) * prime;
+		}
+		for (std::size_t i = 0; i < m_pending_size; ++i) {
+			h = (h ^ m_pending[i]) * prime;
+		}
+		return h;
+	}
+};
+
+/*
+Checksum of the header, header_checksum excluded.
+*/
+inline boost::uint64_t snapshot_header_checksum(snapshot_header header) {
+	header.header_checksum = 0;
+	snapshot_checksum checksum;
+	checksum.update(&header, sizeof(header));
+	return checksum.value();
+}
+
+/*
+Largest number of elements of the given size a snapshot can describe
+without its length overflowing std::size_t.
+*/
+inline std::size_t snapshot_max_count(std::size_t element_size) {
+	return (std::numeric_limits<std::size_t>::max() -
+			snapshot_header::data_offset) / element_size;
+}
+
+/*
+Checks a snapshot header read from a file of file_size bytes, before any
+of its fields is trusted; returns 0 if it is valid, the reason otherwise.
+*/
+inline const char * check_snapshot_header(const snapshot_header & header,
+										  std::size_t element_size,
+										  boost::uint64_t file_size) {
+	if (std::memcmp(header.magic, snapshot_magic,
+					sizeof(header.magic)) != 0 ||
+		header.version != snapshot_header::current_version) {
+		return "is not a snapshot.";
+	}
+	if (header.header_checksum != snapshot_header_checksum(header)) {
+		return "has a wrong checksum.";
+	}
+	if (header.element_size != element_size) {
+		return "holds elements of a different size.";
+	}
+	if (header.count > header.capacity ||
+		header.capacity > snapshot_max_count(element_size) ||
+		file_size != snapshot_header::data_offset +
+			header.count * element_size) {
+		return "is truncated or corrupted.";
+	}
+	return 0;
+}
+
+/*
+Writes the elements in [first,last) as a snapshot at path. The file is
+written under a temporary name, synced and renamed, so that on POSIX a
+crash leaves either the previous snapshot or the new one.
+*/
+template<class RAI>
+void save_snapshot(const std::string & path, RAI first, RAI last,
+				   std::size_t capacity) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	static_assert(std::is_trivially_copyable<value_t>::value,
+				  "snapshots need trivially copyable elements");
+	std::string tmp = path + ".tmp";
+	std::FILE * f = std::fopen(tmp.c_str(), "wb");
+	if (!f) {
+		throw snapshot_error("Snapshot \"" + tmp + "\" could not be created.");
+	}
+	snapshot_header header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, snapshot_magic, sizeof(header.magic));
+	header.version = snapshot_header::current_version;
+	header.element_size = sizeof(value_t);
+	header.count = last - first;
+	header.capacity = capacity;
+	// the elements are copied in chunks, as the container may not be
+	// contiguous
+	const std::size_t chunk = std::max<std::size_t>(65536 / sizeof(value_t), 1);
+	std::vector<value_t> buffer;
+	buffer.reserve(chunk);
+	snapshot_checksum checksum;
+	char padding[snapshot_header::data_offset] = { 0 };
+	bool ok = std::fwrite(padding, 1, sizeof(padding), f) == sizeof(padding);
+	while (ok && first != last) {
+		std::size_t n = std::min<std::size_t>(chunk, last - first);
+		buffer.assign(first, first + n);
+		first += n;
+		checksum.update(&buffer[0], n * sizeof(value_t));
+		ok = std::fwrite(&buffer[0], sizeof(value_t), n, f) == n;
+	}
+	header.checksum = checksum.value();
+	header.header_checksum = snapshot_header_checksum(header);
+	ok = ok && std::fseek(f, 0, SEEK_SET) == 0 &&
+		std::fwrite(&header, sizeof(header), 1, f) == 1 && sync_file(f);
+	ok = std::fclose(f) == 0 && ok;
+#if !defined(SWAY_HAS_POSIX)
+	// rename does not replace an existing file everywhere
+	if (ok) {
+		std::remove(path.c_str());
+	}
+#endif
+	if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+		std::remove(tmp.c_str());
+		throw snapshot_error("Snapshot \"" + path + "\" could not be written.");
+	}
+}
+
+/*
+Reads a snapshot with stdio, checking its header and its size and, once
+all the elements have been read, their checksum.
+*/
+class snapshot_reader {
+private:
+	file_ptr m_file;
+	std::string m_path;
+	snapshot_header m_header;
+	snapshot_checksum m_checksum;
+	std::size_t m_read;
+public:
+	snapshot_reader(const std::string & path, std::size_t element_size)
+		: m_file(std::fopen(path.c_str(), "rb")), m_path(path), m_read(0) {
+		if (!m_file) {
+			fail("could not be opened.");
+		}
+		boost::uint64_t file_size;
+		if (!get_file_size(m_file.get(), file_size) ||
+			std::fread(&m_header, sizeof(m_header), 1, m_file.get()) != 1) {
+			fail("is not a snapshot.");
+		}
+		if (const char * reason = check_snapshot_header(m_header, element_size,
+														file_size)) {
+			fail(reason);
+		}
+		if (std::fseek(m_file.get(), snapshot_header::data_offset,
+					   SEEK_SET) != 0) {
+			fail("could not be read.");
+		}
+	}
+	void fail(const char * reason) const {
+		throw snapshot_error("Snapshot \"" + m_path + "\" " + reason);
+	}
+	std::size_t count() const {
+		return m_header.count;
+	}
+	std::size_t capacity() const {
+		return m_header.capacity;
+	}
+	/*
+	Reads up to max elements into dest, returning how many were read, 0
+	once all of them have been read.
+	*/
+	template<class T>
+	std::size_t read(T * dest, std::size_t max) {
+		std::size_t n = std::min<std::size_t>(max, m_header.count - m_read);
+		if (n != 0 && std::fread(dest, sizeof(T), n, m_file.get()) != n) {
+			fail("could not be read.");
+		}
+		m_checksum.update(dest, n * sizeof(T));
+		m_read += n;
+		return n;
+	}
+	/*
+	Checks that the file ends after the elements and that the checksum of
+	the elements read matches.
+	*/
+	void finish() {
+		if (m_read != m_header.count || std::fgetc(m_file.get()) != EOF) {
+			fail("is truncated or corrupted.");
+		}
+		if (m_checksum.value() != m_header.checksum) {
+			fail("has a wrong checksum.");
+		}
+	}
+};
+
+/*
+Number of elements read at once by the generic restores.
+*/
+template<class T>
+std::size_t snapshot_chunk() {
+	return std::max<std::size_t>(65536 / sizeof(T), 1);
+}
+
+}
+
+/*!
+Replaces the elements of the container with those of the snapshot at path,
+read with stdio. The adapters call restore_snapshot and
+restore_bounded_snapshot unqualified, so that containers can provide
+overloads: std::vector is read in place, mapped_vector maps the file (see
+sway/mapped_vector.hpp). The container is left unchanged if the snapshot
+is not valid.
+*/
+template<class Container>
+void restore_snapshot(Container & c, const std::string & path) {
+	typedef typename Container::value_type value_t;
+	detail::snapshot_reader r(path, sizeof(value_t));
+	std::vector<value_t> buffer(detail::snapshot_chunk<value_t>());
+	Container restored;
+	std::size_t n;
+	try {
+		while ((n = r.read(&buffer[0], buffer.size())) != 0) {
+			restored.insert(restored.end(), buffer.begin(),
+							buffer.begin() + n);
+		}
+	} catch (const std::length_error &) {
+		r.fail("does not fit the container.");
+	}
+	r.finish();
+	c = std::move(restored);
+}
+
+template<class T, class Allocator>
+void restore_snapshot(std::vector<T, Allocator> & c,
+					  const std::string & path) {
+	detail::snapshot_reader r(path, sizeof(T));
+	std::vector<T, Allocator> restored;
+	if (r.count() > restored.max_size()) {
+		r.fail("does not fit the container.");
+	}
+	restored.resize(r.count());
+	if (!restored.empty()) {
+		r.read(&restored[0], restored.size());
+	}
+	r.finish();
+	c.swap(restored);
+}
+
+/*!
+Replaces the container with one holding as many elements as the capacity
+recorded in the snapshot at path, the first of which are those of the
+snapshot and the others value-initialized; returns the number of elements
+of the snapshot. Used by bounded_priority_queue, whose container has the
+size of the queue.
+*/
+template<class Container>
+std::size_t restore_bounded_snapshot(Container & c,
+									 const std::string & path) {
+	typedef typename Container::value_type value_t;
+	detail::snapshot_reader r(path, sizeof(value_t));
+	std::vector<value_t> buffer(detail::snapshot_chunk<value_t>());
+	Container restored;
+	try {
+		Container sized(r.capacity());
+		restored = std::move(sized);
+	} catch (const std::length_error &) {
+		r.fail("does not fit the container.");
+	}
+	std::size_t n, count = 0;
+	while ((n = r.read(&buffer[0], buffer.size())) != 0) {
+		std::copy(buffer.begin(), buffer.begin() + n,
+				  restored.begin() + count);
+		count += n;
+	}
+	r.finish();
+	c = std::move(restored);
+	return count;
+}
+
+template<class T, class Allocator>
+std::size_t restore_bounded_snapshot(std::vector<T, Allocator> & c,
+									 const std::string & path) {
+	detail::snapshot_reader r(path, sizeof(T));
+	std::vector<T, Allocator> restored;
+	if (r.capacity() > restored.max_size()) {
+		r.fail("does not fit the container.");
+	}
+	restored.resize(r.capacity());
+	if (r.count() != 0) {
+		r.read(&restored[0], r.count());
+	}
+	r.finish();
+	c.swap(restored);
+	return r.count();
+}
+
+}
+
+#endif
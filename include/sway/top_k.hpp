@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef SWAY_TOP_K_HPP
+#define SWAY_TOP_K_HPP
+
+#include <sway/minmaxheap.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace sway {
+
+/*!
+Order of the elements written by top_k, bottom_k and extremes_k.
+*/
+enum result_order {
+	sorted_result,
+	unsorted_result
+};
+
+namespace detail {
+
+/*
+Keeps the k highest priority elements of a stream in a binary heap whose root
+is the lowest priority one, so that rejecting an element costs a single
+comparison. Only one end is needed, so a min-max heap would only add
+comparisons to each replacement.
+*/
+template<class T, class Compare>
+class k_selector {
+private:
+	std::size_t m_k;
+	std::vector<T> m_heap;
+	Compare m_comp;
+public:
+	// k may exceed the length of the stream, so the heap grows as it fills
+	k_selector(std::size_t k, const Compare & comp) : m_k(k), m_comp(comp) {}
+	void push(const T & obj) {
+		if (m_heap.size() == m_k) {
+			if (m_comp(obj, m_heap.front())) {
+				std::pop_heap(m_heap.begin(), m_heap.end(), m_comp);
+				m_heap.back() = obj;
+				std::push_heap(m_heap.begin(), m_heap.end(), m_comp);
+			}
+		} else {
+			m_heap.push_back(obj);
+			if (m_heap.size() == m_k) {
+				std::make_heap(m_heap.begin(), m_heap.end(), m_comp);
+			}
+		}
+	}
+	template<class OutputIterator>
+	OutputIterator copy(OutputIterator out, result_order order) {
+		if (order == sorted_result) {
+			if (m_heap.size() == m_k) {
+				std::sort_heap(m_heap.begin(), m_heap.end(), m_comp);
+			} else {
+				std::sort(m_heap.begin(), m_heap.end(), m_comp);
+			}
+		}
+		return std::move(m_heap.begin(), m_heap.end(), out);
+	}
+};
+
+// input iterators are streamed through a k_selector
+template<class InputIterator, class OutputIterator, class Compare>
+OutputIterator top_k(InputIterator first, InputIterator last, std::size_t k,
+					 OutputIterator out, Compare comp, result_order order,
+					 std::input_iterator_tag) {
+	typedef typename std::iterator_traits<InputIterator>::value_type value_t;
+	k_selector<value_t, Compare> selector(k, comp);
+	for (; first != last; ++first) {
+		selector.push(*first);
+	}
+	return selector.copy(out, order);
+}
+
+/*
+From this fraction of the input, a copy and a selection are faster than a
+heap: the heap accepts about k log(n/k) elements on random input, each one
+costing O(log k), while the selection costs O(n) whatever k is. Measured on
+int and string keys, 10^4 to 10^6 elements.
+*/
+const std::size_t selection_ratio = 32;
+
+template<class RAI, class OutputIterator, class Compare>
+OutputIterator top_k(RAI first, RAI last, std::size_t k, OutputIterator out,
+					 Compare comp, result_order order,
+					 std::random_access_iterator_tag) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	std::size_t n = static_cast<std::size_t>(last - first);
+	if (k < n / selection_ratio) {
+		return top_k(first, last, k, out, comp, order,
+					 std::input_iterator_tag());
+	}
+	std::vector<value_t> buffer(first, last);
+	k = std::min(k, n);
+	std::nth_element(buffer.begin(), buffer.begin() + k, buffer.end(), comp);
+	if (order == sorted_result) {
+		std::sort(buffer.begin(), buffer.begin() + k, comp);
+	}
+	return std::move(buffer.begin(), buffer.begin() + k, out);
+}
+
+template<class InputIterator, class OutputIterator1, class OutputIterator2,
+		 class Compare>
+std::pair<OutputIterator1, OutputIterator2> extremes_k(
+	InputIterator first,
+	InputIterator last,
+	std::size_t k,
+	OutputIterator1 top_out,
+	OutputIterator2 bottom_out,
+	Compare comp,
+	result_order order,
+	std::input_iterator_tag) {
+	typedef typename std::iterator_traits<InputIterator>::value_type value_t;
+	k_selector<value_t, Compare> top(k, comp);
+	k_selector<value_t, reverse_compare<Compare> > bottom(
+		k, reverse_compare<Compare>(comp));
+	for (; first != last; ++first) {
+		top.push(*first);
+		bottom.push(*first);
+	}
+	return std::make_pair(top.copy(top_out, order),
+						  bottom.copy(bottom_out, order));
+}
+
+template<class RAI, class OutputIterator1, class OutputIterator2,
+		 class Compare>
+std::pair<OutputIterator1, OutputIterator2> extremes_k(
+	RAI first,
+	RAI last,
+	std::size_t k,
+	OutputIterator1 top_out,
+	OutputIterator2 bottom_out,
+	Compare comp,
+	result_order order,
+	std::random_access_iterator_tag) {
+	typedef typename std::iterator_traits<RAI>::value_type value_t;
+	std::size_t n = static_cast<std::size_t>(last - first);
+	if (k < n / selection_ratio) {
+		return extremes_k(first, last, k, top_out, bottom_out, comp, order,
+						  std::input_iterator_tag());
+	}
+	std::vector<value_t> buffer(first, last);
+	k = std::min(k, n);
+	if (2 * k >= n) {
+		// the two outputs overlap, or almost
+		std::sort(buffer.begin(), buffer.end(), comp);
+		return std::make_pair(
+			std::copy(buffer.begin(), buffer.begin() + k, top_out),
+			std::copy(buffer.rbegin(), buffer.rbegin() + k, bottom_out));
+	}
+	std::nth_element(buffer.begin(), buffer.begin() + k, buffer.end(), comp);
+	std::nth_element(buffer.begin() + k, buffer.end() - k, buffer.end(),
+					 comp);
+	if (order == sorted_result) {
+		std::sort(buffer.begin(), buffer.begin() + k, comp);
+		std::sort(buffer.end() - k, buffer.end(), comp);
+	}
+	return std::make_pair(
+		std::move(buffer.begin(), buffer.begin() + k, top_out),
+		std::move(buffer.rbegin(), buffer.rbegin() + k, bottom_out));
+}
+
+}
+
+/*!
+Writes to out the k highest priority elements of [first,last) (the k
+smallest, if comp is the < operator), or all of them if there are fewer than
+k. If order is sorted_result they are written from the highest priority one,
+otherwise in an unspecified order. Returns the end of the output.
+Input iterators, and random access ones when k is small relative to the
+size of the range, are streamed through a heap of k elements, complexity
+O(N log k). Otherwise the range is copied and the k elements are
+found by selection (std::nth_element), complexity O(N).
+*/
+template<class InputIterator, class OutputIterator, class Compare>
+OutputIterator top_k(InputIterator first, InputIterator last, std::size_t k,
+					 OutputIterator out, Compare comp,
+					 result_order order = sorted_result) {
+	typedef typename std::iterator_traits<InputIterator>::iterator_category
+		category;
+	if (k == 0) {
+		return out;
+	}
+	return detail::top_k(first, last, k, out, comp, order, category());
+}
+
+template<class InputIterator, class OutputIterator>
+OutputIterator top_k(InputIterator first, InputIterator last, std::size_t k,
+					 OutputIterator out, result_order order = sorted_result) {
+	typedef typename std::iterator_traits<InputIterator>::value_type value_t;
+	return top_k(first, last, k, out, std::less<value_t>(), order);
+}
+
+/*!
+Writes to out the k lowest priority elements of [first,last) (the k largest,
+if comp is the < operator), or all of them if there are fewer than k. If
+order is sorted_result they are written from the lowest priority one.
+Same complexity as top_k.
+*/
+template<class InputIterator, class OutputIterator, class Compare>
+OutputIterator bottom_k(InputIterator first, InputIterator last,
+						std::size_t k, OutputIterator out, Compare comp,
+						result_order order = sorted_result) {
+	return top_k(first, last, k, out, reverse_compare<Compare>(comp), order);
+}
+
+template<class InputIterator, class OutputIterator>
+OutputIterator bottom_k(InputIterator first, InputIterator last,
+						std::size_t k, OutputIterator out,
+						result_order order = sorted_result) {
+	typedef typename std::iterator_traits<InputIterator>::value_type value_t;
+	return bottom_k(first, last, k, out, std::less<value_t>(), order);
+}
+
+/*!
+Writes to top_out the k highest priority elements of [first,last), as
+top_k, and to bottom_out the k lowest priority ones, as bottom_k, in a single
+pass over the range. If the range has fewer than 2k elements, some elements
+are written to both outputs. Returns the ends of the two outputs.
+*/
+template<class InputIterator, class OutputIterator1, class OutputIterator2,
+		 class Compare>
+std::pair<OutputIterator1, OutputIterator2> extremes_k(
+	InputIterator first,
+	InputIterator last,
+	std::size_t k,
+	OutputIterator1 top_out,
+	OutputIterator2 bottom_out,
+	Compare comp,
+	result_order order = sorted_result) {
+	typedef typename std::iterator_traits<InputIterator>::iterator_category
+		category;
+	if (k == 0) {
+		return std::make_pair(top_out, bottom_out);
+	}
+	return detail::extremes_k(first, last, k, top_out, bottom_out, comp,
+							  order, category());
+}
+
+template<class InputIterator, class OutputIterator1, class OutputIterator2>
+std::pair<OutputIterator1, OutputIterator2> extremes_k(
+	InputIterator first,
+	InputIterator last,
+	std::size_t k,
+	OutputIterator1 top_out,
+	OutputIterator2 bottom_out,
+	result_order order = sorted_result) {
+	typedef typename std::iterator_traits<InputIterator>::value_type value_t;
+	return extremes_k(first, last, k, top_out, bottom_out,
+					  std::less<value_t>(), order);
+}
+
+}
+
+#endif
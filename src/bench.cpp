@@ -0,0 +1,1283 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+Benchmark harness comparing the sway containers and algorithms with the
+standard library. Options are given as key=value arguments:
+ groups=heap:hold:topk:partial:dary:interval:meld:keyed:radix:
+        external:snapshot:bottomup:parallel:concurrent:relaxed:inline
+                                 groups to run (default all)
+ sizes=100:10000:1000000         number of elements
+ reps=N                          repetitions (default 1e6/size)
+ format=text|json                output format
+The best time over the repetitions is reported, in nanoseconds per element.
+*/
+
+#include <sway/bounded_priority_queue.hpp>
+#include <sway/concurrent_top_k.hpp>
+#include <sway/configuration.hpp>
+#include <sway/dary_minmaxheap.hpp>
+#include <sway/external_priority_dqueue.hpp>
+#include <sway/inline_vector.hpp>
+#include <sway/interval_heap.hpp>
+#include <sway/keyed_bounded_priority_queue.hpp>
+#include <sway/keyed_priority_dqueue.hpp>
+#include <sway/mapped_vector.hpp>
+#include <sway/mergeable_priority_dqueue.hpp>
+#include <sway/minmaxheap.hpp>
+#include <sway/parallel_minmaxheap.hpp>
+#include <sway/priority_dqueue.hpp>
+#include <sway/radix_backend.hpp>
+#include <sway/relaxed_priority_dqueue.hpp>
+#include <sway/top_k.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace sway;
+
+namespace {
+
+/* A 64 bytes record ordered by its key, as found in event queues. */
+struct record {
+	int key;
+	int payload[15];
+};
+
+bool operator<(const record & a, const record & b) {
+	return a.key < b.key;
+}
+
+/* A 256 bytes record ordered by its key. */
+struct large_record {
+	int key;
+	int payload[63];
+};
+
+bool operator<(const large_record & a, const large_record & b) {
+	return a.key < b.key;
+}
+
+/* Extracts the key of the records, for the keyed adapters. */
+struct record_key {
+	template<class Record>
+	int operator()(const Record & r) const {
+		return r.key;
+	}
+};
+
+template<class T>
+T make_value(int key) {
+	return key;
+}
+
+template<>
+double make_value<double>(int key) {
+	return static_cast<double>(key) / 1024.0;
+}
+
+template<>
+record make_value<record>(int key) {
+	record r;
+	r.key = key;
+	std::fill(r.payload, r.payload + 15, key);
+	return r;
+}
+
+template<>
+large_record make_value<large_record>(int key) {
+	large_record r;
+	r.key = key;
+	std::fill(r.payload, r.payload + 63, key);
+	return r;
+}
+
+template<>
+std::string make_value<std::string>(int key) {
+	char buf[32];
+	std::sprintf(buf, "key-%010d", key);
+	return buf;
+}
+
+template<class T>
+std::vector<T> random_values(std::size_t n, unsigned seed) {
+	std::mt19937 gen(seed);
+	std::uniform_int_distribution<int> dist;
+	std::vector<T> v;
+	v.reserve(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		v.push_back(make_value<T>(dist(gen)));
+	}
+	return v;
+}
+
+/* Hides the comparator type, so that the scalar code paths are taken. */
+template<class T>
+struct scalar_less {
+	bool operator()(const T & a, const T & b) const {
+		return a < b;
+	}
+};
+
+class stopwatch {
+private:
+	std::chrono::steady_clock::time_point m_start;
+public:
+	stopwatch() : m_start(std::chrono::steady_clock::now()) {
+	}
+	double elapsed_ns() const {
+		std::chrono::duration<double, std::nano> d =
+			std::chrono::steady_clock::now() - m_start;
+		return d.count();
+	}
+};
+
+/*
+Runs setup and then measures run, reps times, returning the best time: the
+setup (typically copying the input) is not measured.
+*/
+template<class Setup, class Run>
+double best_of(unsigned reps, Setup setup, Run run) {
+	double best = HUGE_VAL;
+	for (unsigned r = 0; r < reps; ++r) {
+		setup();
+		stopwatch sw;
+		run();
+		best = std::min(best, sw.elapsed_ns());
+	}
+	return best;
+}
+
+/*
+Collects the results, printing them as text lines or as a JSON document.
+The results are times in nanoseconds per element, or other metrics with
+their unit.
+*/
+class reporter {
+private:
+	struct result {
+		std::string group;
+		std::string type;
+		std::string comparator;
+		std::string op;
+		std::size_t n;
+		double value;
+		std::string unit;
+	};
+	bool m_json;
+	std::vector<result> m_results;
+public:
+	reporter() : m_json(false) {
+	}
+	void set_json(bool json) {
+		m_json = json;
+	}
+	void add(const char * group, const char * type, const char * comparator,
+			 const std::string & op, std::size_t n, double ns) {
+		add_metric(group, type, comparator, op, n, ns / n, "ns/elem");
+	}
+	void add_metric(const char * group, const char * type,
+					const char * comparator, const std::string & op,
+					std::size_t n, double value, const char * unit) {
+		result r;
+		r.group = group;
+		r.type = type;
+		r.comparator = comparator;
+		r.op = op;
+		r.n = n;
+		r.value = value;
+		r.unit = unit;
+		if (m_json) {
+			m_results.push_back(r);
+		} else {
+			std::printf("%-9s %-7s %-8s %-32s %10lu %10.2f %s\n",
+						group, type, comparator, op.c_str(),
+						static_cast<unsigned long>(n), value, unit);
+			std::fflush(stdout);
+		}
+	}
+	void finish() const {
+		if (!m_json) {
+			return;
+		}
+		std::printf("{\n  \"compiler\": \"%s\",\n  \"results\": [",
+					__VERSION__);
+		for (std::size_t i = 0; i < m_results.size(); ++i) {
+			const result & r = m_results[i];
+			std::printf("%s\n    {\"group\": \"%s\", \"type\": \"%s\", "
+						"\"comparator\": \"%s\", \"op\": \"%s\", "
+						"\"n\": %lu, ",
+						i == 0 ? "" : ",", r.group.c_str(), r.type.c_str(),
+						r.comparator.c_str(), r.op.c_str(),
+						static_cast<unsigned long>(r.n));
+			if (r.unit == "ns/elem") {
+				std::printf("\"ns_per_elem\": %.3f}", r.value);
+			} else {
+				std::printf("\"value\": %.3f, \"unit\": \"%s\"}", r.value,
+							r.unit.c_str());
+			}
+		}
+		std::printf("\n  ]\n}\n");
+	}
+};
+
+reporter out;
+
+/*
+make, push, popmin and popmax on the min-max heap, against the standard
+heap algorithms, std::priority_queue and std::multiset.
+*/
+template<class T, class Compare>
+void bench_heap(const char * type, const char * cname, std::size_t n,
+				unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 42);
+	Compare comp;
+	std::vector<T> v;
+	typedef typename std::vector<T>::iterator iterator;
+	const char * g = "heap";
+
+	std::function<void()> none = []() {};
+	std::function<void()> copy = [&]() { v = input; };
+	std::function<void()> copy_make = [&]() {
+		v = input;
+		make_minmaxheap(v.begin(), v.end(), comp);
+	};
+	out.add(g, type, cname, "sway make", n, best_of(reps, copy, [&]() {
+		make_minmaxheap(v.begin(), v.end(), comp);
+	}));
+	out.add(g, type, cname, "sway push", n, best_of(reps, copy, [&]() {
+		for (iterator last = v.begin() + 1; last <= v.end(); ++last) {
+			push_minmaxheap(v.begin(), last, comp);
+		}
+	}));
+	out.add(g, type, cname, "sway popmin", n, best_of(reps, copy_make, [&]() {
+		for (iterator last = v.end(); last != v.begin(); --last) {
+			popmin_minmaxheap(v.begin(), last, comp);
+		}
+	}));
+	out.add(g, type, cname, "sway popmax", n, best_of(reps, copy_make, [&]() {
+		for (iterator last = v.end(); last != v.begin(); --last) {
+			popmax_minmaxheap(v.begin(), last, comp);
+		}
+	}));
+
+	typedef priority_dqueue<T, std::vector<T>, Compare> pdq_t;
+	out.add(g, type, cname, "sway priority_dqueue push", n,
+			best_of(reps, none, [&]() {
+		pdq_t pdq(comp);
+		for (std::size_t i = 0; i < n; ++i) {
+			pdq.push(input[i]);
+		}
+	}));
+	out.add(g, type, cname, "sway priority_dqueue construct", n,
+			best_of(reps, copy, [&]() {
+		pdq_t pdq(std::move(v), comp);
+	}));
+
+	out.add(g, type, cname, "std::make_heap", n, best_of(reps, copy, [&]() {
+		std::make_heap(v.begin(), v.end(), comp);
+	}));
+	out.add(g, type, cname, "std::push_heap", n, best_of(reps, copy, [&]() {
+		for (iterator last = v.begin() + 1; last <= v.end(); ++last) {
+			std::push_heap(v.begin(), last, comp);
+		}
+	}));
+	std::function<void()> copy_std_make = [&]() {
+		v = input;
+		std::make_heap(v.begin(), v.end(), comp);
+	};
+	out.add(g, type, cname, "std::pop_heap", n,
+			best_of(reps, copy_std_make, [&]() {
+		for (iterator last = v.end(); last != v.begin(); --last) {
+			std::pop_heap(v.begin(), last, comp);
+		}
+	}));
+
+	typedef std::priority_queue<T, std::vector<T>, Compare> pq_t;
+	pq_t pq;
+	out.add(g, type, cname, "std::priority_queue push", n,
+			best_of(reps, [&]() { pq = pq_t(); }, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			pq.push(input[i]);
+		}
+	}));
+	out.add(g, type, cname, "std::priority_queue pop", n,
+			best_of(reps, [&]() { pq = pq_t(comp, input); }, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			pq.pop();
+		}
+	}));
+
+	typedef std::multiset<T, Compare> set_t;
+	set_t s;
+	std::function<void()> fill = [&]() {
+		s.clear();
+		s.insert(input.begin(), input.end());
+	};
+	out.add(g, type, cname, "std::multiset insert", n,
+			best_of(reps, [&]() { s.clear(); }, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			s.insert(input[i]);
+		}
+	}));
+	out.add(g, type, cname, "std::multiset popmin", n, best_of(reps, fill, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			s.erase(s.begin());
+		}
+	}));
+	out.add(g, type, cname, "std::multiset popmax", n, best_of(reps, fill, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			s.erase(--s.end());
+		}
+	}));
+}
+
+/*
+Hold model: n operations on a queue of n elements, each removing an end and
+inserting a new random element. The "both" variants alternate the ends.
+*/
+template<class T, class Compare>
+void bench_hold(const char * type, const char * cname, std::size_t n,
+				unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 46);
+	const std::vector<T> stream = random_values<T>(n, 47);
+	Compare comp;
+	std::vector<T> v;
+	const char * g = "hold";
+
+	std::function<void()> copy_make = [&]() {
+		v = input;
+		make_minmaxheap(v.begin(), v.end(), comp);
+	};
+	out.add(g, type, cname, "sway replacemin", n,
+			best_of(reps, copy_make, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			replacemin_minmaxheap(v.begin(), v.end(), stream[i], comp);
+		}
+	}));
+	out.add(g, type, cname, "sway popmin+push", n,
+			best_of(reps, copy_make, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			popmin_minmaxheap(v.begin(), v.end(), comp);
+			v.back() = stream[i];
+			push_minmaxheap(v.begin(), v.end(), comp);
+		}
+	}));
+	out.add(g, type, cname, "sway replace both", n,
+			best_of(reps, copy_make, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			if (i % 2 == 0) {
+				replacemin_minmaxheap(v.begin(), v.end(), stream[i], comp);
+			} else {
+				replacemax_minmaxheap(v.begin(), v.end(), stream[i], comp);
+			}
+		}
+	}));
+
+	typedef std::priority_queue<T, std::vector<T>, Compare> pq_t;
+	pq_t pq;
+	out.add(g, type, cname, "std::priority_queue", n,
+			best_of(reps, [&]() { pq = pq_t(comp, input); }, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			pq.pop();
+			pq.push(stream[i]);
+		}
+	}));
+
+	typedef std::multiset<T, Compare> set_t;
+	set_t s;
+	std::function<void()> fill = [&]() {
+		s.clear();
+		s.insert(input.begin(), input.end());
+	};
+	out.add(g, type, cname, "std::multiset", n, best_of(reps, fill, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			s.erase(s.begin());
+			s.insert(stream[i]);
+		}
+	}));
+	out.add(g, type, cname, "std::multiset both", n, best_of(reps, fill, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			if (i % 2 == 0) {
+				s.erase(s.begin());
+			} else {
+				s.erase(--s.end());
+			}
+			s.insert(stream[i]);
+		}
+	}));
+}
+
+/*
+Keeps the k smallest elements of a stream of n elements, with a random
+stream and with a descending one, in which every element is accepted.
+*/
+template<class T, class Compare>
+void bench_top_k(const char * type, const char * cname, std::size_t n,
+				 std::size_t k, unsigned reps) {
+	std::vector<T> random_stream = random_values<T>(n, 44);
+	std::vector<T> descending_stream(random_stream);
+	std::sort(descending_stream.begin(), descending_stream.end(),
+			  std::bind(Compare(), std::placeholders::_2,
+						std::placeholders::_1));
+	Compare comp;
+	const char * g = "topk";
+	std::function<void()> none = []() {};
+	for (int d = 0; d < 2; ++d) {
+		const std::vector<T> & input = d == 0 ? random_stream :
+			descending_stream;
+		const char * suffix = d == 0 ? "" : " desc";
+		char op[64];
+
+		std::sprintf(op, "sway k=%lu%s", static_cast<unsigned long>(k),
+					 suffix);
+		out.add(g, type, cname, op, n, best_of(reps, none, [&]() {
+			bounded_priority_queue<T, std::vector<T>, Compare> bpq(k, comp);
+			for (std::size_t i = 0; i < n; ++i) {
+				bpq.push(input[i]);
+			}
+		}));
+
+		std::sprintf(op, "sway push range k=%lu%s",
+					 static_cast<unsigned long>(k), suffix);
+		out.add(g, type, cname, op, n, best_of(reps, none, [&]() {
+			bounded_priority_queue<T, std::vector<T>, Compare> bpq(k, comp);
+			bpq.push(input.begin(), input.end());
+		}));
+
+		std::vector<T> result;
+		result.reserve(k);
+		std::sprintf(op, "sway top_k k=%lu%s", static_cast<unsigned long>(k),
+					 suffix);
+		out.add(g, type, cname, op, n, best_of(reps, none, [&]() {
+			result.clear();
+			top_k(input.begin(), input.end(), k, std::back_inserter(result),
+				  comp, unsorted_result);
+		}));
+
+		std::sprintf(op, "std::priority_queue k=%lu%s",
+					 static_cast<unsigned long>(k), suffix);
+		out.add(g, type, cname, op, n, best_of(reps, none, [&]() {
+			std::priority_queue<T, std::vector<T>, Compare> pq(comp);
+			for (std::size_t i = 0; i < n; ++i) {
+				if (pq.size() < k) {
+					pq.push(input[i]);
+				} else if (comp(input[i], pq.top())) {
+					pq.pop();
+					pq.push(input[i]);
+				}
+			}
+		}));
+
+		std::sprintf(op, "std::multiset k=%lu%s",
+					 static_cast<unsigned long>(k), suffix);
+		out.add(g, type, cname, op, n, best_of(reps, none, [&]() {
+			std::multiset<T, Compare> s(comp);
+			for (std::size_t i = 0; i < n; ++i) {
+				if (s.size() < k) {
+					s.insert(input[i]);
+				} else if (comp(input[i], *s.rbegin())) {
+					s.erase(--s.end());
+					s.insert(input[i]);
+				}
+			}
+		}));
+
+		std::vector<T> v;
+		std::sprintf(op, "std::partial_sort k=%lu%s",
+					 static_cast<unsigned long>(k), suffix);
+		out.add(g, type, cname, op, n, best_of(reps, none, [&]() {
+			v = input;
+			std::partial_sort(v.begin(), v.begin() + k, v.end(), comp);
+		}));
+	}
+}
+
+template<class T>
+void bench_partial_sort(const char * type, std::size_t n, std::size_t k,
+						unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 43);
+	std::less<T> comp;
+	std::vector<T> v;
+	std::function<void()> copy = [&]() { v = input; };
+	char op[64];
+	std::sprintf(op, "both_ends k=%lu", static_cast<unsigned long>(k));
+	out.add("partial", type, "less", op, n, best_of(reps, copy, [&]() {
+		partial_sort_both_ends(v.begin(), v.end(), k, k, comp);
+	}));
+	std::sprintf(op, "2x std::partial_sort k=%lu",
+				 static_cast<unsigned long>(k));
+	out.add("partial", type, "less", op, n, best_of(reps, copy, [&]() {
+		std::partial_sort(v.begin(), v.begin() + k, v.end(), comp);
+		std::partial_sort(v.rbegin(), v.rbegin() + k, v.rend() - k,
+						  [&comp](const T & a, const T & b) {
+							  return comp(b, a);
+						  });
+	}));
+}
+
+/* Measures push, popmin and popmax through one of the adapter backends. */
+template<class T, class Backend>
+void bench_backend(const char * group, const char * type, const char * name,
+				   std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 45);
+	std::less<T> comp;
+	std::vector<T> v;
+	typedef typename std::vector<T>::iterator iterator;
+	std::function<void()> copy = [&]() { v = input; };
+	std::function<void()> copy_make = [&]() {
+		v = input;
+		Backend::make(v.begin(), v.end(), comp);
+	};
+	std::string prefix(name);
+	out.add(group, type, "less", prefix + " push", n,
+			best_of(reps, copy, [&]() {
+		for (iterator last = v.begin() + 1; last <= v.end(); ++last) {
+			Backend::push(v.begin(), last, comp);
+		}
+	}));
+	out.add(group, type, "less", prefix + " popmin", n,
+			best_of(reps, copy_make, [&]() {
+		for (iterator last = v.end(); last != v.begin(); --last) {
+			Backend::popmin(v.begin(), last, comp);
+		}
+	}));
+	out.add(group, type, "less", prefix + " popmax", n,
+			best_of(reps, copy_make, [&]() {
+		for (iterator last = v.end(); last != v.begin(); --last) {
+			Backend::popmax(v.begin(), last, comp);
+		}
+	}));
+}
+
+template<class T>
+void bench_dary(const char * type, std::size_t n, unsigned reps) {
+	bench_backend<T, minmaxheap_backend>("dary", type, "binary", n, reps);
+	bench_backend<T, dary_minmaxheap_backend<4> >(
+		"dary", type, "4-ary", n, reps);
+	bench_backend<T, dary_minmaxheap_backend<8> >(
+		"dary", type, "8-ary", n, reps);
+}
+
+/* Less than, counting the comparisons. */
+template<class T>
+struct counting_less {
+	std::size_t * count;
+	bool operator()(const T & a, const T & b) const {
+		++*count;
+		return a < b;
+	}
+};
+
+/* Reports the comparisons per element of make, push, popmin and popmax. */
+template<class T, class Backend>
+void count_backend(const char * group, const char * type, const char * name,
+				   std::size_t n) {
+	const std::vector<T> input = random_values<T>(n, 45);
+	std::size_t count = 0;
+	counting_less<T> comp = { &count };
+	std::vector<T> v(input);
+	typedef typename std::vector<T>::iterator iterator;
+	std::string prefix(name);
+	Backend::make(v.begin(), v.end(), comp);
+	out.add_metric(group, type, "less", prefix + " make", n,
+				   static_cast<double>(count) / n, "cmp/elem");
+	count = 0;
+	for (iterator last = v.end(); last != v.begin(); --last) {
+		Backend::popmin(v.begin(), last, comp);
+	}
+	out.add_metric(group, type, "less", prefix + " popmin", n,
+				   static_cast<double>(count) / n, "cmp/elem");
+	v = input;
+	count = 0;
+	for (iterator last = v.begin() + 1; last <= v.end(); ++last) {
+		Backend::push(v.begin(), last, comp);
+	}
+	out.add_metric(group, type, "less", prefix + " push", n,
+				   static_cast<double>(count) / n, "cmp/elem");
+	count = 0;
+	for (iterator last = v.end(); last != v.begin(); --last) {
+		Backend::popmax(v.begin(), last, comp);
+	}
+	out.add_metric(group, type, "less", prefix + " popmax", n,
+				   static_cast<double>(count) / n, "cmp/elem");
+}
+
+template<class T>
+void bench_interval(const char * type, std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 45);
+	std::less<T> comp;
+	std::vector<T> v;
+	std::function<void()> copy = [&]() { v = input; };
+	out.add("interval", type, "less", "min-max make", n,
+			best_of(reps, copy, [&]() {
+		make_minmaxheap(v.begin(), v.end(), comp);
+	}));
+	out.add("interval", type, "less", "interval make", n,
+			best_of(reps, copy, [&]() {
+		make_interval_heap(v.begin(), v.end(), comp);
+	}));
+	bench_backend<T, minmaxheap_backend>(
+		"interval", type, "min-max", n, reps);
+	bench_backend<T, interval_heap_backend>(
+		"interval", type, "interval", n, reps);
+	count_backend<T, minmaxheap_backend>("interval", type, "min-max", n);
+	count_backend<T, interval_heap_backend>("interval", type, "interval", n);
+}
+
+template<class T>
+void bench_bottom_up(const char * type, std::size_t n, unsigned reps) {
+	bench_backend<T, minmaxheap_backend>(
+		"bottomup", type, "top-down", n, reps);
+	bench_backend<T, bottom_up_minmaxheap_backend>(
+		"bottomup", type, "bottom-up", n, reps);
+}
+
+/*
+Many short-lived bounded priority queues, one per chunk of the input, stored
+in a std::vector or in an inline_vector.
+*/
+template<class T, class Container>
+void bench_inline_queues(const char * type, const char * name,
+						 const std::vector<T> & input, std::size_t chunk,
+						 std::size_t k, unsigned reps) {
+	std::size_t n = input.size();
+	std::vector<T> tops(n / chunk + 1);
+	char op[64];
+	std::sprintf(op, "%s k=%lu chunk=%lu", name, static_cast<unsigned long>(k),
+				 static_cast<unsigned long>(chunk));
+	out.add("inline", type, "less", op, n, best_of(reps, []() {}, [&]() {
+		for (std::size_t i = 0; i < n; i += chunk) {
+			bounded_priority_queue<T, Container> bpq(k);
+			bpq.push(input.begin() + i,
+					 input.begin() + std::min(n, i + chunk));
+			tops[i / chunk] = bpq.bottom();
+		}
+	}));
+}
+
+template<class T>
+void bench_inline(const char * type, std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 50);
+	const std::size_t k = 16;
+	for (std::size_t chunk = 32; chunk <= 512; chunk *= 4) {
+		bench_inline_queues<T, std::vector<T> >(
+			type, "vector", input, chunk, k, reps);
+		bench_inline_queues<T, inline_vector<T, k> >(
+			type, "inline_vector", input, chunk, k, reps);
+	}
+}
+
+/*
+Melding a queue of n/2 elements into another: mergeable_priority_dqueue::meld
+against pushing the elements into a priority_dqueue, one by one or as a
+range. The meld times are totals, in nanoseconds. Push and pop are measured
+too.
+*/
+template<class T>
+void bench_meld(const char * type, std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 51);
+	const char * g = "meld";
+	std::size_t half = n / 2;
+	if (half == 0) {
+		return;
+	}
+	typedef mergeable_priority_dqueue<T> mpdq_t;
+	typedef priority_dqueue<T> pdq_t;
+	mpdq_t a;
+	mpdq_t b;
+	out.add_metric(g, type, "less", "mergeable meld", half,
+				   best_of(reps, [&]() {
+		a.clear();
+		b.clear();
+		for (std::size_t i = 0; i < half; ++i) {
+			a.push(input[i]);
+			b.push(input[half + i]);
+		}
+	}, [&]() {
+		a.meld(b);
+	}), "ns");
+	pdq_t pdq;
+	std::function<void()> fill = [&]() {
+		pdq.assign(input.begin(), input.begin() + half);
+	};
+	out.add_metric(g, type, "less", "priority_dqueue push each", half,
+				   best_of(reps, fill, [&]() {
+		for (std::size_t i = half; i < 2 * half; ++i) {
+			pdq.push(input[i]);
+		}
+	}), "ns");
+	out.add_metric(g, type, "less", "priority_dqueue push range", half,
+				   best_of(reps, fill, [&]() {
+		pdq.push(input.begin() + half, input.begin() + 2 * half);
+	}), "ns");
+
+	out.add(g, type, "less", "mergeable push", n,
+			best_of(reps, [&]() { a.clear(); }, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			a.push(input[i]);
+		}
+	}));
+	out.add(g, type, "less", "mergeable pop_top", n, best_of(reps, [&]() {
+		a.clear();
+		for (std::size_t i = 0; i < n; ++i) {
+			a.push(input[i]);
+		}
+	}, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			a.pop_top();
+		}
+	}));
+	out.add(g, type, "less", "priority_dqueue push", n,
+			best_of(reps, [&]() { pdq.assign(input.end(), input.end()); },
+					[&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			pdq.push(input[i]);
+		}
+	}));
+	out.add(g, type, "less", "priority_dqueue pop_top", n,
+			best_of(reps, [&]() { pdq.assign(input.begin(), input.end()); },
+					[&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			pdq.pop_top();
+		}
+	}));
+}
+
+/*
+Large records in priority_dqueue and bounded_priority_queue, which sift the
+records, against the keyed adapters, which sift compact keys and indices.
+*/
+template<class T>
+void bench_keyed(const char * type, std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 52);
+	const char * g = "keyed";
+	std::function<void()> none = []() {};
+	{
+		typedef priority_dqueue<T> pdq_t;
+		pdq_t pdq;
+		out.add(g, type, "less", "priority_dqueue push", n,
+				best_of(reps, [&]() { pdq = pdq_t(); }, [&]() {
+			for (std::size_t i = 0; i < n; ++i) {
+				pdq.push(input[i]);
+			}
+		}));
+		out.add(g, type, "less", "priority_dqueue pop_top", n,
+				best_of(reps, [&]() { pdq.assign(input.begin(), input.end()); },
+						[&]() {
+			for (std::size_t i = 0; i < n; ++i) {
+				pdq.pop_top();
+			}
+		}));
+	}
+	{
+		typedef keyed_priority_dqueue<T, record_key> kpdq_t;
+		kpdq_t kpdq;
+		out.add(g, type, "less", "keyed_priority_dqueue push", n,
+				best_of(reps, [&]() { kpdq.clear(); }, [&]() {
+			for (std::size_t i = 0; i < n; ++i) {
+				kpdq.push(input[i]);
+			}
+		}));
+		out.add(g, type, "less", "keyed_priority_dqueue pop_top", n,
+				best_of(reps, [&]() {
+			kpdq.clear();
+			kpdq.push(input.begin(), input.end());
+		}, [&]() {
+			for (std::size_t i = 0; i < n; ++i) {
+				kpdq.pop_top();
+			}
+		}));
+	}
+	std::size_t k = std::max<std::size_t>(1, n / 100);
+	char op[64];
+	std::sprintf(op, "bounded_priority_queue k=%lu",
+				 static_cast<unsigned long>(k));
+	out.add(g, type, "less", op, n, best_of(reps, none, [&]() {
+		bounded_priority_queue<T> bpq(k);
+		for (std::size_t i = 0; i < n; ++i) {
+			bpq.push(input[i]);
+		}
+	}));
+	std::sprintf(op, "keyed_bounded_priority_queue k=%lu",
+				 static_cast<unsigned long>(k));
+	out.add(g, type, "less", op, n, best_of(reps, none, [&]() {
+		keyed_bounded_priority_queue<T, record_key> kbpq(k);
+		for (std::size_t i = 0; i < n; ++i) {
+			kbpq.push(input[i]);
+		}
+	}));
+}
+
+/* Runs the radix group on one queue type. */
+template<class Queue, class T>
+void bench_radix_queue(const char * type, const char * name,
+					   const std::vector<T> & input, T mask, unsigned reps) {
+	const char * g = "radix";
+	std::size_t n = input.size();
+	Queue q;
+	std::function<void()> fill = [&]() {
+		q.assign(input.begin(), input.end());
+	};
+	out.add(g, type, "less", std::string(name) + " push", n,
+			best_of(reps, [&]() { q.assign(input.end(), input.end()); },
+					[&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			q.push(input[i]);
+		}
+	}));
+	out.add(g, type, "less", std::string(name) + " pop_top", n,
+			best_of(reps, fill, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			q.pop_top();
+		}
+	}));
+	out.add(g, type, "less", std::string(name) + " pop_bottom", n,
+			best_of(reps, fill, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			q.pop_bottom();
+		}
+	}));
+	out.add(g, type, "less", std::string(name) + " hold", n,
+			best_of(reps, fill, [&]() {
+		for (std::size_t i = 0; i < n; ++i) {
+			T t = q.extract_top();
+			q.push(static_cast<T>((t + (input[i] & 1023)) & mask));
+		}
+	}));
+}
+
+/*
+Unsigned keys in [0,2^Bits) in priority_dqueue with the min-max heap and
+with the radix specialization: push, pop_top, pop_bottom and the hold model
+of an event queue, where the popped timestamp is pushed back delayed.
+*/
+template<class T, unsigned Bits>
+void bench_radix(const char * type, std::size_t n, unsigned reps) {
+	const T mask = static_cast<T>((std::size_t(1) << Bits) - 1);
+	std::vector<T> input = random_values<T>(n, 53);
+	for (std::size_t i = 0; i < n; ++i) {
+		input[i] &= mask;
+	}
+	bench_radix_queue<priority_dqueue<T, std::vector<T>, std::less<T>,
+									  minmaxheap_backend> >(
+		type, "heap", input, mask, reps);
+	bench_radix_queue<priority_dqueue<T, std::vector<T>, std::less<T>,
+									  radix_backend<Bits> > >(
+		type, "radix", input, mask, reps);
+}
+
+/*
+Push of n elements then removal of all of them from alternate ends, with
+priority_dqueue and with external_priority_dqueue keeping n/16 pushed
+elements in memory and reading and writing blocks of 1024 elements; the
+elements written and read are reported as passes over the input.
+*/
+template<class T>
+void bench_external(const char * type, std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 54);
+	const char * g = "external";
+	std::function<void()> none = []() {};
+	out.add(g, type, "less", "priority_dqueue push+pop", n,
+			best_of(reps, none, [&]() {
+		priority_dqueue<T> pdq;
+		pdq.push(input.begin(), input.end());
+		for (std::size_t i = 0; i < n; ++i) {
+			if (i % 2) {
+				pdq.pop_top();
+			} else {
+				pdq.pop_bottom();
+			}
+		}
+	}));
+	external_io_stats io;
+	out.add(g, type, "less", "external push+pop", n,
+			best_of(reps, none, [&]() {
+		external_priority_dqueue<T> epdq(std::max<std::size_t>(n / 16, 1),
+										 1024);
+		epdq.push(input.begin(), input.end());
+		for (std::size_t i = 0; i < n; ++i) {
+			if (i % 2) {
+				epdq.pop_top();
+			} else {
+				epdq.pop_bottom();
+			}
+		}
+		io = epdq.io_stats();
+	}));
+	out.add_metric(g, type, "less", "external write", n,
+				   static_cast<double>(io.blocks_written) * 1024 / n,
+				   "passes");
+	out.add_metric(g, type, "less", "external read", n,
+				   static_cast<double>(io.blocks_read) * 1024 / n, "passes");
+}
+
+/*
+Restoring a priority_dqueue: rebuilding the heap from the elements against
+loading a snapshot into a vector, with one copy, and into a mapped_vector,
+in place. Both loads verify the checksum, which reads every page of the
+file, from the page cache here.
+*/
+template<class T>
+void bench_snapshot(const char * type, std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 55);
+	const char * g = "snapshot";
+	std::function<void()> none = []() {};
+	const std::string path = "/tmp/sway_bench_snapshot";
+	priority_dqueue<T> pdq(input.begin(), input.end());
+	out.add(g, type, "less", "save", n, best_of(reps, none, [&]() {
+		pdq.save(path);
+	}));
+	out.add(g, type, "less", "rebuild", n, best_of(reps, none, [&]() {
+		pdq.assign(input.begin(), input.end());
+	}));
+	out.add(g, type, "less", "load vector", n, best_of(reps, none, [&]() {
+		pdq.load(path);
+	}));
+	typedef priority_dqueue<T, mapped_vector<T>, std::less<T> > mapped_t;
+	mapped_t mapped;
+	out.add(g, type, "less", "load mapped", n, best_of(reps, none, [&]() {
+		mapped.load(path);
+	}));
+	std::remove(path.c_str());
+}
+
+/*
+Top-k of a stream split among threads: a bounded_priority_queue shared under
+a mutex against concurrent_top_k with one shard per thread.
+*/
+template<class T>
+void bench_concurrent_top_k(const char * type, std::size_t n, std::size_t k,
+							unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 49);
+	const char * g = "concurrent";
+	std::function<void()> none = []() {};
+	const unsigned threads[] = { 1, 2, 4, 0 };
+	for (std::size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+		unsigned count = threads[t] != 0 ? threads[t]
+			: std::max(1u, std::thread::hardware_concurrency());
+		// runs body(first, last) on count threads, over slices of the input
+		auto run_split = [&](std::function<void(unsigned, std::size_t,
+												std::size_t)> body) {
+			std::vector<std::thread> pool;
+			for (unsigned i = 0; i < count; ++i) {
+				pool.push_back(std::thread(body, i, i * n / count,
+										   (i + 1) * n / count));
+			}
+			for (unsigned i = 0; i < count; ++i) {
+				pool[i].join();
+			}
+		};
+		char op[64];
+		std::sprintf(op, "mutex k=%lu t=%u", static_cast<unsigned long>(k),
+					 count);
+		out.add(g, type, "less", op, n, best_of(reps, none, [&]() {
+			bounded_priority_queue<T> bpq(k);
+			std::mutex mutex;
+			run_split([&](unsigned, std::size_t first, std::size_t last) {
+				for (std::size_t i = first; i < last; ++i) {
+					std::lock_guard<std::mutex> lock(mutex);
+					bpq.push(input[i]);
+				}
+			});
+		}));
+		std::sprintf(op, "sharded k=%lu t=%u", static_cast<unsigned long>(k),
+					 count);
+		out.add(g, type, "less", op, n, best_of(reps, none, [&]() {
+			concurrent_top_k<T> topk(k, count);
+			run_split([&](unsigned s, std::size_t first, std::size_t last) {
+				for (std::size_t i = first; i < last; ++i) {
+					topk.get_shard(s).push(input[i]);
+				}
+			});
+			topk.collect();
+		}));
+	}
+}
+
+/*
+Rank error of relaxed_priority_dqueue: the queue is filled with a permutation
+of 0..n-1 and emptied with try_pop_top, counting for each removal how many
+smaller elements were still in the queue (with a Fenwick tree).
+Then throughput of a mix of pushes and pops on all threads, against a min-max
+heap under a mutex.
+*/
+void bench_relaxed(std::size_t n, unsigned reps) {
+	const char * g = "relaxed";
+	std::vector<int> input(n);
+	for (std::size_t i = 0; i < n; ++i) {
+		input[i] = static_cast<int>(i);
+	}
+	std::shuffle(input.begin(), input.end(), std::mt19937(50));
+	const std::size_t shards[] = { 1, 4, 16, 64 };
+	for (std::size_t s = 0; s < sizeof(shards) / sizeof(shards[0]); ++s) {
+		relaxed_priority_dqueue<int> q(shards[s]);
+		for (std::size_t i = 0; i < n; ++i) {
+			q.push(input[i]);
+		}
+		// tree[i] counts the elements left in a range of values ending at i
+		std::vector<std::size_t> tree(n + 1, 0);
+		for (std::size_t i = 1; i <= n; ++i) {
+			++tree[i];
+			if (i + (i & -i) <= n) {
+				tree[i + (i & -i)] += tree[i];
+			}
+		}
+		double total = 0;
+		std::size_t worst = 0;
+		int value;
+		while (q.try_pop_top(value)) {
+			std::size_t rank = 0;
+			for (std::size_t i = value; i > 0; i -= i & -i) {
+				rank += tree[i];
+			}
+			for (std::size_t i = value + 1; i <= n; i += i & -i) {
+				--tree[i];
+			}
+			total += rank;
+			worst = std::max(worst, rank);
+		}
+		char op[64];
+		std::sprintf(op, "rank error mean shards=%lu",
+					 static_cast<unsigned long>(shards[s]));
+		out.add_metric(g, "int", "less", op, n, total / n, "rank");
+		std::sprintf(op, "rank error max shards=%lu",
+					 static_cast<unsigned long>(shards[s]));
+		out.add_metric(g, "int", "less", op, n, worst, "rank");
+	}
+
+	// each thread pushes its slice of the input, popping the top or the
+	// bottom after every other push
+	std::function<void()> none = []() {};
+	unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+	auto run_threads = [&](std::function<void(std::size_t, std::size_t)> body) {
+		std::vector<std::thread> pool;
+		for (unsigned t = 0; t < threads; ++t) {
+			pool.push_back(std::thread(body, t * n / threads,
+									   (t + 1) * n / threads));
+		}
+		for (unsigned t = 0; t < threads; ++t) {
+			pool[t].join();
+		}
+	};
+	char op[64];
+	std::sprintf(op, "mutex push/pop t=%u", threads);
+	out.add(g, "int", "less", op, n, best_of(reps, none, [&]() {
+		std::vector<int> heap;
+		std::mutex mutex;
+		run_threads([&](std::size_t first, std::size_t last) {
+			for (std::size_t i = first; i < last; ++i) {
+				std::lock_guard<std::mutex> lock(mutex);
+				heap.push_back(input[i]);
+				push_minmaxheap(heap.begin(), heap.end());
+				if (i % 2 == 1) {
+					if (i % 4 == 1) {
+						popmin_minmaxheap(heap.begin(), heap.end());
+					} else {
+						popmax_minmaxheap(heap.begin(), heap.end());
+					}
+					heap.pop_back();
+				}
+			}
+		});
+	}));
+	std::sprintf(op, "relaxed push/pop t=%u", threads);
+	out.add(g, "int", "less", op, n, best_of(reps, none, [&]() {
+		relaxed_priority_dqueue<int> q(threads * 2);
+		run_threads([&](std::size_t first, std::size_t last) {
+			int value;
+			for (std::size_t i = first; i < last; ++i) {
+				q.push(input[i]);
+				if (i % 2 == 1) {
+					if (i % 4 == 1) {
+						q.try_pop_top(value);
+					} else {
+						q.try_pop_bottom(value);
+					}
+				}
+			}
+		});
+	}));
+}
+
+/* make_minmaxheap against make_parallel_minmaxheap with 2, 4 and all threads. */
+template<class T>
+void bench_parallel(const char * type, std::size_t n, unsigned reps) {
+	const std::vector<T> input = random_values<T>(n, 48);
+	std::less<T> comp;
+	std::vector<T> v;
+	std::function<void()> copy = [&]() { v = input; };
+	const char * g = "parallel";
+	out.add(g, type, "less", "sway make", n, best_of(reps, copy, [&]() {
+		make_minmaxheap(v.begin(), v.end(), comp);
+	}));
+	const unsigned threads[] = { 2, 4, 0 };
+	for (std::size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); ++t) {
+		unsigned count = threads[t] != 0 ? threads[t]
+			: std::max(1u, std::thread::hardware_concurrency());
+		out.add(g, type, "less",
+				"sway parallel make t=" + std::to_string(count), n,
+				best_of(reps, copy, [&]() {
+			make_parallel_minmaxheap(v.begin(), v.end(), comp, count);
+		}));
+	}
+}
+
+/* Runs the groups of benchmarks on all the key types, for one size. */
+void bench_size(const std::vector<std::string> & groups, std::size_t n,
+				unsigned reps) {
+	bool all = groups.empty();
+	if (all || std::count(groups.begin(), groups.end(), "heap")) {
+		bench_heap<int, std::less<int> >("int", "less", n, reps);
+		bench_heap<int, scalar_less<int> >("int", "functor", n, reps);
+		bench_heap<double, std::less<double> >("double", "less", n, reps);
+		bench_heap<std::string, std::less<std::string> >(
+			"string", "less", n, reps);
+		bench_heap<record, std::less<record> >("record", "less", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "hold")) {
+		bench_hold<int, std::less<int> >("int", "less", n, reps);
+		bench_hold<double, std::less<double> >("double", "less", n, reps);
+		bench_hold<std::string, std::less<std::string> >(
+			"string", "less", n, reps);
+		bench_hold<record, std::less<record> >("record", "less", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "topk")) {
+		std::size_t k = std::max<std::size_t>(1, n / 100);
+		bench_top_k<int, std::less<int> >("int", "less", n, k, reps);
+		bench_top_k<int, scalar_less<int> >("int", "functor", n, k, reps);
+		bench_top_k<double, std::less<double> >("double", "less", n, k, reps);
+		bench_top_k<std::string, std::less<std::string> >(
+			"string", "less", n, k, reps);
+		bench_top_k<record, std::less<record> >("record", "less", n, k, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "partial")) {
+		std::size_t k = std::max<std::size_t>(1, n / 100);
+		bench_partial_sort<int>("int", n, std::min<std::size_t>(10, n / 2),
+								reps);
+		bench_partial_sort<int>("int", n, k, reps);
+		bench_partial_sort<double>("double", n, k, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "dary")) {
+		bench_dary<int>("int", n, reps);
+		bench_dary<record>("record", n, reps);
+		bench_dary<std::string>("string", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "interval")) {
+		bench_interval<int>("int", n, reps);
+		bench_interval<std::string>("string", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "meld")) {
+		bench_meld<int>("int", n, reps);
+		bench_meld<std::string>("string", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "keyed")) {
+		bench_keyed<record>("record", n, reps);
+		bench_keyed<large_record>("large", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "radix")) {
+		bench_radix<unsigned short, 16>("ushort", n, reps);
+		bench_radix<unsigned, 20>("uint20", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "external")) {
+		bench_external<int>("int", n, reps);
+		bench_external<record>("record", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "snapshot")) {
+		bench_snapshot<int>("int", n, reps);
+		bench_snapshot<record>("record", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "bottomup")) {
+		bench_bottom_up<int>("int", n, reps);
+		bench_bottom_up<std::string>("string", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "concurrent")) {
+		std::size_t k = std::max<std::size_t>(1, n / 100);
+		bench_concurrent_top_k<int>("int", n, k, reps);
+		bench_concurrent_top_k<std::string>("string", n, k, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "relaxed")) {
+		bench_relaxed(n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "parallel")) {
+		bench_parallel<int>("int", n, reps);
+		bench_parallel<record>("record", n, reps);
+	}
+	if (all || std::count(groups.begin(), groups.end(), "inline")) {
+		bench_inline<int>("int", n, reps);
+		bench_inline<std::string>("string", n, reps);
+	}
+}
+
+std::vector<std::string> split_list(const std::string & list) {
+	std::vector<std::string> items;
+	if (!list.empty()) {
+		boost::split(items, list, boost::is_any_of(":"));
+	}
+	return items;
+}
+}
+
+int main(int argc, char * argv[]) {
+	std::string options;
+	for (int i = 1; i < argc; ++i) {
+		options += argv[i];
+		options += ",";
+	}
+	try {
+		configuration cfg = configuration::from_string(options);
+		std::vector<std::string> groups =
+			split_list(cfg.get<std::string>("groups", ""));
+		std::vector<std::string> sizes =
+			split_list(cfg.get<std::string>("sizes", "100:10000:1000000"));
+		unsigned reps = cfg.get<unsigned>("reps", 0);
+		out.set_json(cfg.get<std::string>("format", "text") == "json");
+		std::vector<std::string> unused = cfg.unused();
+		if (!unused.empty()) {
+			throw configuration_error("Unknown option \"" + unused[0] + "\"");
+		}
+		for (std::size_t s = 0; s < sizes.size(); ++s) {
+			std::size_t n = boost::lexical_cast<std::size_t>(sizes[s]);
+			unsigned size_reps = reps > 0 ? reps : static_cast<unsigned>(
+				std::max<std::size_t>(3, 1000000 / n));
+			bench_size(groups, n, size_reps);
+		}
+	} catch (const std::exception & e) {
+		std::cerr << e.what() << std::endl;
+		return 1;
+	}
+	out.finish();
+	return 0;
+}
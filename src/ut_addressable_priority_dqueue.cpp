@@ -0,0 +1,136 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/addressable_priority_dqueue.hpp>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace sway;
+
+BOOST_AUTO_TEST_CASE(TestAPDQ) {
+
+    addressable_priority_dqueue<int> apdq;
+
+    addressable_priority_dqueue<int>::handle_type h10 = apdq.push(10);
+    addressable_priority_dqueue<int>::handle_type h5 = apdq.push(5);
+    addressable_priority_dqueue<int>::handle_type h20 = apdq.push(20);
+    apdq.push(15);
+
+    BOOST_CHECK_EQUAL(apdq.size(), 4);
+    BOOST_CHECK_EQUAL(apdq.top(), 5);
+    BOOST_CHECK_EQUAL(apdq.bottom(), 20);
+    BOOST_CHECK_EQUAL(apdq.top_handle(), h5);
+    BOOST_CHECK_EQUAL(apdq.bottom_handle(), h20);
+
+    apdq.update(h10, 30);
+    BOOST_CHECK_EQUAL(apdq.bottom(), 30);
+    BOOST_CHECK_EQUAL(apdq.get(h10), 30);
+    apdq.update(h20, 1);
+    BOOST_CHECK_EQUAL(apdq.top(), 1);
+
+    apdq.erase(h5);
+    BOOST_CHECK_EQUAL(apdq.size(), 3);
+    apdq.pop_top();
+    BOOST_CHECK_EQUAL(apdq.top(), 15);
+    apdq.pop_bottom();
+    BOOST_CHECK_EQUAL(apdq.top(), 15);
+    BOOST_CHECK_EQUAL(apdq.bottom(), 15);
+}
+
+BOOST_AUTO_TEST_CASE(TestAPDQRandom) {
+
+    addressable_priority_dqueue<int, std::greater<int> > apdq;
+    // handle -> value, and the values as a multiset
+    std::map<std::size_t, int> handles;
+    std::multiset<int> values;
+
+    srand(8);
+    for (int i = 0; i < 5000; i++) {
+        int op = rand() % 5;
+        int x = rand() % 1000;
+        if (op == 0 || handles.empty()) {
+            std::size_t h = apdq.push(x);
+            BOOST_REQUIRE(handles.find(h) == handles.end());
+            handles[h] = x;
+            values.insert(x);
+        } else {
+            std::map<std::size_t, int>::iterator it = handles.begin();
+            std::advance(it, rand() % handles.size());
+            if (op == 1) {
+                apdq.update(it->first, x);
+                values.erase(values.find(it->second));
+                values.insert(x);
+                it->second = x;
+            } else if (op == 2) {
+                apdq.erase(it->first);
+                values.erase(values.find(it->second));
+                handles.erase(it);
+            } else if (op == 3) {
+                std::size_t h = apdq.top_handle();
+                BOOST_REQUIRE_EQUAL(handles[h], *values.rbegin());
+                apdq.pop_top();
+                values.erase(--values.end());
+                handles.erase(h);
+            } else {
+                std::size_t h = apdq.bottom_handle();
+                BOOST_REQUIRE_EQUAL(handles[h], *values.begin());
+                apdq.pop_bottom();
+                values.erase(values.begin());
+                handles.erase(h);
+            }
+        }
+        BOOST_REQUIRE_EQUAL(apdq.size(), values.size());
+        if (!values.empty()) {
+            BOOST_REQUIRE_EQUAL(apdq.top(), *values.rbegin());
+            BOOST_REQUIRE_EQUAL(apdq.bottom(), *values.begin());
+        }
+        for (std::map<std::size_t, int>::iterator it = handles.begin();
+             it != handles.end(); ++it) {
+            BOOST_REQUIRE_EQUAL(apdq.get(it->first), it->second);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestAPDQMove) {
+
+    addressable_priority_dqueue<std::string> apdq;
+    std::string a("apple");
+    std::size_t h = apdq.push(std::move(a));
+    BOOST_CHECK(a.empty());
+    apdq.emplace(4, 'z');
+    apdq.push("mango");
+    BOOST_CHECK_EQUAL(apdq.get(h), "apple");
+    BOOST_CHECK_EQUAL(apdq.size(), 3u);
+
+    BOOST_CHECK_EQUAL(apdq.extract_bottom(), "zzzz");
+    BOOST_CHECK_EQUAL(apdq.extract_top(), "apple");
+    BOOST_CHECK_EQUAL(apdq.size(), 1u);
+    BOOST_CHECK_EQUAL(apdq.top(), "mango");
+    BOOST_CHECK_EQUAL(apdq.bottom(), "mango");
+}
@@ -24,6 +24,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/test/unit_test.hpp>
 
 #include <sway/bounded_priority_queue.hpp>
+#include <sway/instrumentation.hpp>
+#include <vector>
+#include <list>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <boost/cstdint.hpp>
 
 using namespace sway;
 
@@ -92,6 +100,40 @@ BOOST_AUTO_TEST_CASE(TestBPQSmall) {
 	BOOST_CHECK_EQUAL(bpq.bottom(), 2);
 }
 
+BOOST_AUTO_TEST_CASE(TestBPQZeroSize) {
+
+	// like keyed_bounded_priority_queue, a queue of size 0 rejects everything
+	bounded_priority_queue<int> bpq(0);
+	bpq.push(1);
+	int three = 3;
+	bpq.push(std::move(three));
+	bpq.emplace(4);
+	// contiguous, vectorized when the target allows it, and element-wise
+	std::vector<int> data(100, 2);
+	bpq.push(data.begin(), data.end());
+	std::list<int> l(data.begin(), data.end());
+	bpq.push(l.begin(), l.end());
+	BOOST_CHECK(bpq.empty());
+	BOOST_CHECK_EQUAL(bpq.size(), 0u);
+	BOOST_CHECK_EQUAL(bpq.max_size(), 0u);
+
+	bounded_priority_queue<int> from_container(0, data);
+	BOOST_CHECK(from_container.empty());
+
+	// every push is reported as rejected, none reaches the heap
+	bounded_priority_queue<int, std::vector<int>, std::less<int>,
+						   minmaxheap_backend, counting_instrumentation<> >
+		counted(0);
+	counted.push(1);
+	counted.push(data.begin(), data.end());
+	BOOST_CHECK(counted.empty());
+	const counting_instrumentation<> & instr = counted.instrumentation();
+	BOOST_CHECK_EQUAL(instr.outcomes(push_rejected), 101u);
+	BOOST_CHECK_EQUAL(instr.outcomes(push_inserted), 0u);
+	BOOST_CHECK_EQUAL(instr.stats(op_push).comparisons, 0u);
+	BOOST_CHECK_EQUAL(instr.stats(op_push).moves, 0u);
+}
+
 BOOST_AUTO_TEST_CASE(TestBPQConstructFromVector) {
 
 	std::vector<int> data;
@@ -139,3 +181,119 @@ BOOST_AUTO_TEST_CASE(TestBPQConstructFromSmallerVector) {
 	BOOST_CHECK_EQUAL(bpq.top(), 5);
 	BOOST_CHECK_EQUAL(bpq.bottom(), 11);
 }
+
+BOOST_AUTO_TEST_CASE(TestBPQPushRange) {
+
+	bounded_priority_queue<int> bpq(20);
+
+	bpq.push(100);
+
+	std::vector<int> data;
+	for (int i = 0; i < 50; i++) {
+		data.push_back((i * 7) % 50);
+	}
+	bpq.push(data.begin(), data.end());
+
+	BOOST_REQUIRE_EQUAL(bpq.size(), 20u);
+	BOOST_CHECK_EQUAL(bpq.top(), 0);
+	BOOST_CHECK_EQUAL(bpq.bottom(), 19);
+
+	for (int i = 0; i < 20; i++) {
+		BOOST_CHECK_EQUAL(bpq.top(), i);
+		bpq.pop_top();
+	}
+	BOOST_CHECK(bpq.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestBPQTopBottomNotFull) {
+
+	bounded_priority_queue<int> bpq(10);
+	bpq.push(4);
+	bpq.push(8);
+	bpq.push(6);
+	BOOST_CHECK_EQUAL(bpq.top(), 4);
+	BOOST_CHECK_EQUAL(bpq.bottom(), 8);
+
+	// the elements moved past the end of the queue are not looked at
+	bpq.pop_bottom();
+	BOOST_CHECK_EQUAL(bpq.bottom(), 6);
+	bpq.pop_top();
+	BOOST_CHECK_EQUAL(bpq.top(), 6);
+	BOOST_CHECK_EQUAL(bpq.bottom(), 6);
+}
+
+/*
+Pushes random values into a queue in a single range, one by one and from a
+list (never vectorized), and checks that the three queues hold the smallest
+values according to Compare.
+*/
+template<class T, class Compare>
+void CheckBPQPushRange(std::size_t capacity, std::size_t n, unsigned seed) {
+	srand(seed);
+	std::vector<T> data;
+	for (std::size_t i = 0; i < n; i++) {
+		data.push_back(static_cast<T>(rand() % 10000 - 5000) / 4);
+	}
+	std::vector<T> sorted(data);
+	std::sort(sorted.begin(), sorted.end(), Compare());
+	sorted.resize(std::min(capacity, n));
+
+	bounded_priority_queue<T, std::vector<T>, Compare> range(capacity);
+	bounded_priority_queue<T, std::vector<T>, Compare> single(capacity);
+	bounded_priority_queue<T, std::vector<T>, Compare> list(capacity);
+	// two ranges, so that the second one starts with a full queue
+	range.push(data.begin(), data.begin() + n / 3);
+	range.push(data.begin() + n / 3, data.end());
+	for (std::size_t i = 0; i < n; i++) {
+		single.push(data[i]);
+	}
+	std::list<T> l(data.begin(), data.end());
+	list.push(l.begin(), l.end());
+
+	for (std::size_t i = 0; i < sorted.size(); i++) {
+		BOOST_REQUIRE_EQUAL(range.top(), sorted[i]);
+		BOOST_REQUIRE_EQUAL(single.top(), sorted[i]);
+		BOOST_REQUIRE_EQUAL(list.top(), sorted[i]);
+		range.pop_top();
+		single.pop_top();
+		list.pop_top();
+	}
+	BOOST_CHECK(range.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestBPQPushRangeFiltered) {
+
+	const std::size_t capacities[] = { 1, 3, 8, 50, 1000 };
+	for (std::size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]);
+		 c++) {
+		for (std::size_t n = 0; n < 40; n += 7) {
+			CheckBPQPushRange<int, std::less<int> >(capacities[c], n, 1);
+		}
+		std::size_t cap = capacities[c];
+		CheckBPQPushRange<int, std::less<int> >(cap, 5003, 2);
+		CheckBPQPushRange<int, std::greater<int> >(cap, 5003, 3);
+		CheckBPQPushRange<float, std::less<float> >(cap, 5001, 4);
+		CheckBPQPushRange<double, std::less<double> >(cap, 5002, 5);
+		CheckBPQPushRange<double, std::greater<double> >(cap, 5002, 6);
+		CheckBPQPushRange<boost::int64_t, std::less<boost::int64_t> >(
+			cap, 5001, 7);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestBPQMove) {
+
+	bounded_priority_queue<std::string> bpq(3);
+	std::string words[] = { "fig", "apple", "kiwi", "pear", "banana" };
+	for (int i = 0; i < 5; i++) {
+		std::string w(words[i]);
+		bpq.push(std::move(w));
+		// inserted elements are moved into the queue, rejected ones are not
+		BOOST_CHECK_EQUAL(w.empty(), words[i] != "pear");
+	}
+	bpq.emplace(3, 'a');
+	BOOST_REQUIRE_EQUAL(bpq.size(), 3u);
+	BOOST_CHECK_EQUAL(bpq.extract_bottom(), "banana");
+	BOOST_CHECK_EQUAL(bpq.extract_top(), "aaa");
+	BOOST_CHECK_EQUAL(bpq.extract_top(), "apple");
+	BOOST_CHECK(bpq.empty());
+}
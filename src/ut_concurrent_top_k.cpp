@@ -0,0 +1,126 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/concurrent_top_k.hpp>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+BOOST_AUTO_TEST_CASE(TestTopKSingleShard) {
+
+	concurrent_top_k<int> topk(3, 1);
+	topk.get_shard(0).push(10);
+	topk.get_shard(0).push(5);
+
+	vector<int> result = topk.collect();
+	BOOST_REQUIRE_EQUAL(result.size(), 2u);
+	BOOST_CHECK_EQUAL(result[0], 5);
+	BOOST_CHECK_EQUAL(result[1], 10);
+
+	topk.get_shard(0).push(20);
+	topk.get_shard(0).push(1);
+	topk.get_shard(0).push(7);
+	topk.get_shard(0).push(30);
+	result = topk.collect();
+	BOOST_REQUIRE_EQUAL(result.size(), 3u);
+	BOOST_CHECK_EQUAL(result[0], 1);
+	BOOST_CHECK_EQUAL(result[1], 5);
+	BOOST_CHECK_EQUAL(result[2], 7);
+}
+
+BOOST_AUTO_TEST_CASE(TestTopKShards) {
+
+	srand(13);
+	vector<int> data;
+	for (int i = 0; i < 20000; i++) {
+		data.push_back(rand() % 5000);
+	}
+	vector<int> sorted(data);
+	sort(sorted.begin(), sorted.end(), greater<int>());
+	sorted.resize(100);
+
+	// the shards are fed in turns, so that the thresholds they publish
+	// reject elements of the other shards
+	concurrent_top_k<int, greater<int> > topk(100, 5);
+	for (size_t i = 0; i < data.size(); i++) {
+		topk.get_shard(i % 5).push(data[i]);
+	}
+	BOOST_CHECK(topk.collect() == sorted);
+	size_t held = 0;
+	for (size_t s = 0; s < topk.shards(); s++) {
+		held += topk.get_shard(s).size();
+	}
+	BOOST_CHECK(held >= 100 && held <= 500);
+}
+
+BOOST_AUTO_TEST_CASE(TestTopKStrings) {
+
+	concurrent_top_k<string> topk(2, 2);
+	topk.get_shard(0).push("pear");
+	topk.get_shard(1).push("fig");
+	topk.get_shard(0).push("apple");
+	topk.get_shard(1).push("kiwi");
+	topk.get_shard(1).push("banana");
+	vector<string> result = topk.collect();
+	BOOST_REQUIRE_EQUAL(result.size(), 2u);
+	BOOST_CHECK_EQUAL(result[0], "apple");
+	BOOST_CHECK_EQUAL(result[1], "banana");
+}
+
+BOOST_AUTO_TEST_CASE(TestTopKThreads) {
+
+	const size_t threads = 4;
+	const size_t per_thread = 50000;
+	const size_t k = 250;
+	vector<vector<int> > streams(threads);
+	vector<int> all;
+	srand(14);
+	for (size_t t = 0; t < threads; t++) {
+		for (size_t i = 0; i < per_thread; i++) {
+			streams[t].push_back(rand());
+		}
+		all.insert(all.end(), streams[t].begin(), streams[t].end());
+	}
+	sort(all.begin(), all.end());
+	all.resize(k);
+
+	concurrent_top_k<int> topk(k, threads);
+	vector<thread> pool;
+	for (size_t t = 0; t < threads; t++) {
+		pool.push_back(thread([&topk, &streams, t]() {
+			topk.get_shard(t).push(streams[t].begin(), streams[t].end());
+		}));
+	}
+	for (size_t t = 0; t < threads; t++) {
+		pool[t].join();
+	}
+	BOOST_CHECK(topk.collect() == all);
+}
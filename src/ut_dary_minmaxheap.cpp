@@ -0,0 +1,217 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/dary_minmaxheap.hpp>
+#include <sway/detail/dary_minmaxheap.hpp>
+#include <sway/bounded_priority_queue.hpp>
+#include <sway/priority_dqueue.hpp>
+#include <vector>
+#include <set>
+#include <functional>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+template<unsigned D>
+void CheckDaryMinMaxHeapProperty(vector<int> & v) {
+	for (size_t k = 1; k < v.size(); k++) {
+		bool odd = get_dary_level<D>(v.begin(), v.begin() + k) % 2 == 1;
+		// it is enough to compare each node with its parent and grandparent
+		size_t parent = (k - 1) / D;
+		if (odd)
+			BOOST_REQUIRE_GE(v[k], v[parent]);
+		else
+			BOOST_REQUIRE_LE(v[k], v[parent]);
+		if (parent > 0) {
+			size_t grand_parent = (parent - 1) / D;
+			if (odd)
+				BOOST_REQUIRE_LE(v[k], v[grand_parent]);
+			else
+				BOOST_REQUIRE_GE(v[k], v[grand_parent]);
+		}
+	}
+}
+
+template<unsigned D>
+void CheckDaryMakeHeap() {
+	srand(7);
+	for (int n = 0; n <= 300; n++) {
+		vector<int> v;
+		for (int i = 0; i < n; i++) {
+			v.push_back(rand() % 1000);
+		}
+		make_dary_minmaxheap<D>(v.begin(), v.end());
+		CheckDaryMinMaxHeapProperty<D>(v);
+	}
+}
+
+template<unsigned D>
+void CheckDaryRandomPushPop() {
+	vector<int> v;
+	multiset<int> reference;
+	srand(42);
+	for (int i = 0; i < 3000; i++) {
+		int op = rand() % 3;
+		if (op == 0 || v.empty()) {
+			int x = rand() % 100;
+			v.push_back(x);
+			push_dary_minmaxheap<D>(v.begin(), v.end());
+			reference.insert(x);
+		} else if (op == 1) {
+			BOOST_REQUIRE_EQUAL(*min_dary_minmaxheap<D>(v.begin(), v.end()),
+								*reference.begin());
+			popmin_dary_minmaxheap<D>(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.begin());
+			v.pop_back();
+			reference.erase(reference.begin());
+		} else {
+			BOOST_REQUIRE_EQUAL(*max_dary_minmaxheap<D>(v.begin(), v.end()),
+								*reference.rbegin());
+			popmax_dary_minmaxheap<D>(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.rbegin());
+			v.pop_back();
+			reference.erase(--reference.end());
+		}
+		CheckDaryMinMaxHeapProperty<D>(v);
+	}
+}
+
+template<unsigned D>
+void CheckDaryPushRange() {
+	srand(11);
+	for (int n = 1; n <= 100; n += 3) {
+		for (int added = 0; added <= 150; added += 7) {
+			vector<int> v;
+			for (int i = 0; i < n + added; i++) {
+				v.push_back(rand() % 1000);
+			}
+			make_dary_minmaxheap<D>(v.begin(), v.begin() + n);
+			push_range_dary_minmaxheap<D>(v.begin(), v.begin() + n, v.end());
+			CheckDaryMinMaxHeapProperty<D>(v);
+		}
+	}
+}
+
+template<unsigned D>
+void CheckDaryReplace() {
+	vector<int> v;
+	multiset<int> reference;
+	srand(46);
+	v.push_back(500);
+	reference.insert(500);
+	for (int i = 0; i < 3000; i++) {
+		int x = rand() % 1000;
+		if (v.size() < 200 && i % 4 == 0) {
+			v.push_back(x);
+			push_dary_minmaxheap<D>(v.begin(), v.end());
+		} else if (i % 2 == 0) {
+			replacemin_dary_minmaxheap<D>(v.begin(), v.end(), x);
+			reference.erase(reference.begin());
+		} else {
+			replacemax_dary_minmaxheap<D>(v.begin(), v.end(), x);
+			reference.erase(--reference.end());
+		}
+		reference.insert(x);
+		CheckDaryMinMaxHeapProperty<D>(v);
+		BOOST_REQUIRE_EQUAL(v[0], *reference.begin());
+		BOOST_REQUIRE_EQUAL(*max_dary_minmaxheap<D>(v.begin(), v.end()),
+							*reference.rbegin());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestDaryMakeHeap) {
+	CheckDaryMakeHeap<2>();
+	CheckDaryMakeHeap<4>();
+	CheckDaryMakeHeap<8>();
+}
+
+BOOST_AUTO_TEST_CASE(TestDaryRandomPushPop) {
+	CheckDaryRandomPushPop<2>();
+	CheckDaryRandomPushPop<3>();
+	CheckDaryRandomPushPop<4>();
+	CheckDaryRandomPushPop<8>();
+}
+
+BOOST_AUTO_TEST_CASE(TestDaryPushRange) {
+	CheckDaryPushRange<2>();
+	CheckDaryPushRange<4>();
+	CheckDaryPushRange<8>();
+}
+
+BOOST_AUTO_TEST_CASE(TestDaryReplace) {
+	CheckDaryReplace<2>();
+	CheckDaryReplace<4>();
+	CheckDaryReplace<8>();
+}
+
+BOOST_AUTO_TEST_CASE(TestDarySameAsBinary) {
+
+	// with two children per node and distinct values the layout is the one
+	// of the binary heap
+	vector<int> v;
+	for (int i = 0; i < 1000; i++) {
+		v.push_back((i * 367) % 1000);
+	}
+	vector<int> w(v);
+	make_minmaxheap(v.begin(), v.end());
+	make_dary_minmaxheap<2>(w.begin(), w.end());
+	BOOST_CHECK(v == w);
+}
+
+BOOST_AUTO_TEST_CASE(TestDaryComp) {
+
+	vector<int> v;
+	for (int i = 0; i < 200; i++) {
+		v.push_back((i * 37) % 200);
+	}
+	make_dary_minmaxheap<4>(v.begin(), v.end(), greater<int>());
+	for (int i = 0; i < 100; i++) {
+		popmin_dary_minmaxheap<4>(v.begin(), v.end(), greater<int>());
+		BOOST_REQUIRE_EQUAL(v.back(), 199 - i);
+		v.pop_back();
+		popmax_dary_minmaxheap<4>(v.begin(), v.end(), greater<int>());
+		BOOST_REQUIRE_EQUAL(v.back(), i);
+		v.pop_back();
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestDaryBackend) {
+
+	typedef dary_minmaxheap_backend<4> backend;
+	priority_dqueue<int, vector<int>, less<int>, backend> pdq;
+	bounded_priority_queue<int, vector<int>, less<int>, backend> bpq(10);
+	for (int i = 0; i < 100; i++) {
+		int x = (i * 37) % 100;
+		pdq.push(x);
+		bpq.push(x);
+	}
+	BOOST_CHECK_EQUAL(pdq.size(), 100);
+	BOOST_CHECK_EQUAL(pdq.top(), 0);
+	BOOST_CHECK_EQUAL(pdq.bottom(), 99);
+	BOOST_CHECK_EQUAL(bpq.size(), 10);
+	BOOST_CHECK_EQUAL(bpq.top(), 0);
+	BOOST_CHECK_EQUAL(bpq.bottom(), 9);
+}
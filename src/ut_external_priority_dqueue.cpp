@@ -0,0 +1,169 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/external_priority_dqueue.hpp>
+#include <sway/priority_dqueue.hpp>
+#include <functional>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+template<class T, class Compare>
+void CheckEqual(const external_priority_dqueue<T, Compare> & epdq,
+				const priority_dqueue<T, vector<T>, Compare> & pdq) {
+	BOOST_REQUIRE_EQUAL(epdq.size(), pdq.size());
+	if (!pdq.empty()) {
+		BOOST_REQUIRE(!(epdq.top() < pdq.top()) && !(pdq.top() < epdq.top()));
+		BOOST_REQUIRE(!(epdq.bottom() < pdq.bottom()) &&
+					  !(pdq.bottom() < epdq.bottom()));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestEPDQAgainstPDQ) {
+	// small memory and blocks, so that many runs are written and merged
+	external_priority_dqueue<int> epdq(64, 8);
+	priority_dqueue<int> pdq;
+	srand(3);
+	size_t max_runs = 0;
+	for (int i = 0; i < 60000; i++) {
+		int op = rand() % 10;
+		if (op < 6 || pdq.empty()) {
+			int value = rand() % 5000;
+			epdq.push(value);
+			pdq.push(value);
+		} else if (op < 8) {
+			BOOST_REQUIRE_EQUAL(epdq.extract_top(), pdq.extract_top());
+		} else {
+			BOOST_REQUIRE_EQUAL(epdq.extract_bottom(), pdq.extract_bottom());
+		}
+		CheckEqual(epdq, pdq);
+		max_runs = max(max_runs, epdq.runs());
+	}
+	BOOST_CHECK(max_runs >= external_priority_dqueue<int>::merge_fanout);
+	while (!pdq.empty()) {
+		if (pdq.size() % 2) {
+			BOOST_REQUIRE_EQUAL(epdq.extract_top(), pdq.extract_top());
+		} else {
+			BOOST_REQUIRE_EQUAL(epdq.extract_bottom(), pdq.extract_bottom());
+		}
+	}
+	BOOST_CHECK(epdq.empty());
+	BOOST_CHECK_EQUAL(epdq.runs(), 0u);
+}
+
+struct event {
+	int time;
+	int payload[3];
+};
+
+bool operator<(const event & a, const event & b) {
+	return a.time < b.time;
+}
+
+struct later {
+	bool operator()(const event & a, const event & b) const {
+		return b.time < a.time;
+	}
+};
+
+BOOST_AUTO_TEST_CASE(TestEPDQRecords) {
+	external_priority_dqueue<event, later> epdq(100, 16, "/tmp");
+	priority_dqueue<event, vector<event>, later> pdq;
+	srand(5);
+	for (int round = 0; round < 4; round++) {
+		// sorted, reverse sorted and random bursts, then drain half
+		for (int i = 0; i < 3000; i++) {
+			event e;
+			e.time = round == 0 ? i : round == 1 ? 3000 - i : rand() % 1000;
+			e.payload[0] = e.payload[1] = e.payload[2] = e.time;
+			epdq.push(e);
+			pdq.push(e);
+		}
+		CheckEqual(epdq, pdq);
+		for (int i = 0; i < 2000; i++) {
+			event a = i % 3 ? epdq.extract_top() : epdq.extract_bottom();
+			event b = i % 3 ? pdq.extract_top() : pdq.extract_bottom();
+			BOOST_REQUIRE_EQUAL(a.time, b.time);
+			BOOST_REQUIRE_EQUAL(a.payload[2], a.time);
+			CheckEqual(epdq, pdq);
+		}
+	}
+	epdq.clear();
+	BOOST_CHECK(epdq.empty());
+	BOOST_CHECK_EQUAL(epdq.runs(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestEPDQIo) {
+	const size_t memory = 64, block = 16, n = 8192;
+	external_priority_dqueue<int> epdq(memory, block);
+	srand(9);
+	for (size_t i = 0; i < n; i++) {
+		epdq.push(rand());
+	}
+	// at most 8 runs of each of the levels 0, 1 and 2 remain
+	BOOST_CHECK(epdq.runs() <= 3 * external_priority_dqueue<int>::merge_fanout);
+	int last = epdq.top();
+	while (!epdq.empty()) {
+		BOOST_REQUIRE(!(epdq.top() < last));
+		last = epdq.extract_top();
+	}
+	// every element is written once per level and each block is read once
+	const external_io_stats & io = epdq.io_stats();
+	BOOST_CHECK(io.blocks_written <= 3 * n / block);
+	BOOST_CHECK(io.blocks_read <= io.blocks_written);
+}
+
+BOOST_AUTO_TEST_CASE(TestEPDQStorageError) {
+	external_priority_dqueue<int> epdq(32, 8, "/nonexistent/sway");
+	for (int i = 0; i < 32; i++) {
+		epdq.push(i);
+	}
+	BOOST_CHECK_THROW(epdq.push(32), external_storage_error);
+	// the elements in memory are kept
+	BOOST_CHECK_EQUAL(epdq.size(), 32u);
+	BOOST_CHECK_EQUAL(epdq.top(), 0);
+	BOOST_CHECK_EQUAL(epdq.bottom(), 31);
+	epdq.pop_bottom();
+	BOOST_CHECK_EQUAL(epdq.bottom(), 30);
+}
+
+BOOST_AUTO_TEST_CASE(TestEPDQLargeOffsets) {
+	// offsets past 4 GiB are neither truncated nor wrapped (the file is
+	// sparse: nothing is written before the offset)
+	detail::file_ptr f = detail::open_temporary_file("/tmp");
+	const boost::uint64_t offset = (boost::uint64_t(5) << 30) + 8;
+	int value = 12345, read = 0;
+	BOOST_REQUIRE(detail::seek_file(f.get(), offset));
+	BOOST_REQUIRE_EQUAL(fwrite(&value, sizeof(value), 1, f.get()), 1u);
+	BOOST_REQUIRE(detail::seek_file(f.get(), 0));
+	BOOST_REQUIRE(detail::seek_file(f.get(), offset));
+	BOOST_REQUIRE_EQUAL(fread(&read, sizeof(read), 1, f.get()), 1u);
+	BOOST_CHECK_EQUAL(read, value);
+	// offsets that the platform cannot represent are rejected
+	BOOST_CHECK(!detail::seek_file(f.get(), ~boost::uint64_t(0)));
+}
@@ -0,0 +1,60 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/ilog2.hpp>
+
+using namespace sway;
+
+BOOST_AUTO_TEST_CASE(TestILog2Constexpr) {
+	static_assert(ilog2(static_cast<uint32_t>(1)) == 0, "ilog2(1)");
+	static_assert(ilog2(static_cast<uint32_t>(1024)) == 10, "ilog2(1024)");
+	static_assert(ilog2_portable(static_cast<uint64_t>(1) << 40) == 40,
+				  "ilog2_portable(2^40)");
+	BOOST_CHECK_EQUAL(ilog2(static_cast<uint8_t>(0)), 0);
+	BOOST_CHECK_EQUAL(ilog2(static_cast<uint64_t>(0)), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestILog2MatchesPortable) {
+	for (uint32_t x = 0; x < 256; ++x) {
+		uint8_t y = static_cast<uint8_t>(x);
+		BOOST_REQUIRE_EQUAL(ilog2(y), ilog2_portable(y));
+	}
+	for (uint32_t x = 0; x < 65536; ++x) {
+		uint16_t y = static_cast<uint16_t>(x);
+		BOOST_REQUIRE_EQUAL(ilog2(y), ilog2_portable(y));
+	}
+	for (unsigned b = 0; b < 64; ++b) {
+		uint64_t p = static_cast<uint64_t>(1) << b;
+		BOOST_REQUIRE_EQUAL(ilog2(p), static_cast<uint64_t>(b));
+		BOOST_REQUIRE_EQUAL(ilog2(p), ilog2_portable(p));
+		BOOST_REQUIRE_EQUAL(ilog2(p | (p - 1)), ilog2_portable(p | (p - 1)));
+		BOOST_REQUIRE_EQUAL(ilog2(p + 1), ilog2_portable(p + 1));
+		if (b < 32) {
+			uint32_t q = static_cast<uint32_t>(p);
+			BOOST_REQUIRE_EQUAL(ilog2(q), static_cast<uint32_t>(b));
+			BOOST_REQUIRE_EQUAL(ilog2(q | (q - 1)), ilog2_portable(q | (q - 1)));
+		}
+	}
+}
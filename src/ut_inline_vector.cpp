@@ -0,0 +1,127 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/inline_vector.hpp>
+#include <sway/bounded_priority_queue.hpp>
+#include <sway/priority_dqueue.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace sway;
+
+BOOST_AUTO_TEST_CASE(TestInlineVector) {
+	inline_vector<std::string, 4> v;
+	BOOST_REQUIRE(v.empty());
+	BOOST_CHECK_EQUAL(v.capacity(), 4u);
+	v.push_back("c");
+	v.push_back("d");
+	std::string ab[] = {"a", "b"};
+	v.insert(v.begin(), ab, ab + 2);
+	BOOST_REQUIRE_EQUAL(v.size(), 4u);
+	BOOST_CHECK_EQUAL(v.front(), "a");
+	BOOST_CHECK_EQUAL(v[1], "b");
+	BOOST_CHECK_EQUAL(v[2], "c");
+	BOOST_CHECK_EQUAL(v.back(), "d");
+	BOOST_CHECK_THROW(v.push_back("e"), std::length_error);
+	BOOST_CHECK_EQUAL(v.size(), 4u);
+
+	inline_vector<std::string, 4> copy(v);
+	v.pop_back();
+	BOOST_CHECK_EQUAL(v.size(), 3u);
+	BOOST_CHECK_EQUAL(copy.size(), 4u);
+	BOOST_CHECK(std::equal(v.begin(), v.end(), copy.begin()));
+
+	inline_vector<std::string, 4> moved(std::move(copy));
+	BOOST_CHECK_EQUAL(moved.back(), "d");
+	v = moved;
+	BOOST_CHECK_EQUAL(v.size(), 4u);
+	v.resize(1);
+	BOOST_CHECK_EQUAL(v.size(), 1u);
+	BOOST_CHECK_EQUAL(v.front(), "a");
+	v.clear();
+	BOOST_CHECK(v.empty());
+
+	// two integers are a count and a value, not a range
+	inline_vector<int, 8> fives(3, 5);
+	BOOST_REQUIRE_EQUAL(fives.size(), 3u);
+	BOOST_CHECK_EQUAL(fives.front(), 5);
+	BOOST_CHECK_EQUAL(fives.back(), 5);
+}
+
+BOOST_AUTO_TEST_CASE(TestBPQInlineVector) {
+	typedef bounded_priority_queue<int, inline_vector<int, 64> > queue_t;
+	std::vector<int> data;
+	for (int i = 0; i < 1000; ++i) {
+		data.push_back(std::rand() % 5000);
+	}
+	queue_t bpq(64);
+	for (std::size_t i = 0; i < data.size(); ++i) {
+		bpq.push(data[i]);
+	}
+	queue_t ranged(64);
+	ranged.push(data.begin(), data.end());
+
+	std::sort(data.begin(), data.end());
+	BOOST_REQUIRE_EQUAL(bpq.size(), 64u);
+	BOOST_REQUIRE_EQUAL(ranged.size(), 64u);
+	BOOST_CHECK_EQUAL(bpq.bottom(), data[63]);
+	for (std::size_t i = 0; i < 64; ++i) {
+		BOOST_CHECK_EQUAL(bpq.top(), data[i]);
+		BOOST_CHECK_EQUAL(ranged.top(), data[i]);
+		bpq.pop_top();
+		ranged.pop_top();
+	}
+	BOOST_CHECK_THROW(queue_t(65), std::length_error);
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQInlineVector) {
+	priority_dqueue<int, inline_vector<int, 16> > pdq;
+	int data[] = {7, 3, 9, 1, 5};
+	pdq.push(data, data + 5);
+	pdq.push(4);
+	BOOST_REQUIRE_EQUAL(pdq.size(), 6u);
+	BOOST_CHECK_EQUAL(pdq.top(), 1);
+	BOOST_CHECK_EQUAL(pdq.bottom(), 9);
+}
+
+BOOST_AUTO_TEST_CASE(TestAdaptersDeque) {
+	bounded_priority_queue<int, std::deque<int>, std::greater<int> > bpq(3);
+	priority_dqueue<int, std::deque<int> > pdq;
+	for (int i = 0; i < 100; ++i) {
+		bpq.push(i);
+		pdq.push(i);
+	}
+	BOOST_REQUIRE_EQUAL(bpq.size(), 3u);
+	BOOST_CHECK_EQUAL(bpq.top(), 99);
+	BOOST_CHECK_EQUAL(bpq.bottom(), 97);
+	BOOST_REQUIRE_EQUAL(pdq.size(), 100u);
+	BOOST_CHECK_EQUAL(pdq.top(), 0);
+	BOOST_CHECK_EQUAL(pdq.bottom(), 99);
+}
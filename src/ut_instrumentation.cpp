@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/instrumentation.hpp>
+#include <sway/priority_dqueue.hpp>
+#include <sway/bounded_priority_queue.hpp>
+#include <sway/dary_minmaxheap.hpp>
+#include <sway/interval_heap.hpp>
+#include <vector>
+
+using namespace sway;
+
+typedef priority_dqueue<int,
+						std::vector<int>,
+						std::less<int>,
+						minmaxheap_backend,
+						counting_instrumentation<> > counted_pdq;
+
+typedef bounded_priority_queue<int,
+							   std::vector<int>,
+							   std::less<int>,
+							   minmaxheap_backend,
+							   counting_instrumentation<true> > counted_bpq;
+
+BOOST_AUTO_TEST_CASE(TestInstrumentationPDQ) {
+
+    counted_pdq pdq;
+    for (int i = 0; i < 100; i++) {
+        pdq.push((i * 37) % 100);
+    }
+    const counting_instrumentation<> & instr = pdq.instrumentation();
+    BOOST_CHECK_EQUAL(instr.stats(op_push).calls, 100u);
+    BOOST_CHECK(instr.stats(op_push).comparisons > 0);
+    BOOST_CHECK(instr.stats(op_push).moves >= 100u);
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_top).calls, 0u);
+
+    BOOST_CHECK_EQUAL(pdq.top(), 0);
+    for (int i = 0; i < 10; i++) {
+        pdq.pop_top();
+    }
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_top).calls, 10u);
+    BOOST_CHECK(instr.stats(op_pop_top).comparisons > 0);
+    BOOST_CHECK(instr.stats(op_pop_top).moves >= 10u);
+    // the trickle down of a pop crosses the levels of the heap
+    BOOST_CHECK(instr.stats(op_pop_top).levels >= 10u);
+    BOOST_CHECK_EQUAL(pdq.size(), 90u);
+    BOOST_CHECK_EQUAL(pdq.top(), 10);
+
+    pdq.pop_bottom();
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_bottom).calls, 1u);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 98);
+
+    std::vector<int> data(50, 7);
+    pdq.push(data.begin(), data.end());
+    BOOST_CHECK_EQUAL(instr.stats(op_push_range).calls, 1u);
+    BOOST_CHECK_EQUAL(instr.stats(op_push).calls, 100u);
+}
+
+BOOST_AUTO_TEST_CASE(TestInstrumentationLevels) {
+
+    // with equal elements a pop writes the last element where the popped
+    // one was and stops: the deep position it came from is not a level
+    // crossed
+    std::vector<int> data(1000, 7);
+    counted_pdq pdq(data.begin(), data.end());
+    const counting_instrumentation<> & instr = pdq.instrumentation();
+    for (int i = 0; i < 10; i++) {
+        pdq.pop_top();
+        pdq.pop_bottom();
+    }
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_top).levels, 0u);
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_bottom).levels, 0u);
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_top).moves, 10u);
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_bottom).moves, 10u);
+}
+
+template<class Backend>
+void CheckBackendTracksMoves() {
+    typedef priority_dqueue<int, std::vector<int>, std::less<int>, Backend,
+                            counting_instrumentation<> > pdq_t;
+    pdq_t pdq;
+    for (int i = 0; i < 100; i++) {
+        pdq.push(99 - i);
+    }
+    const counting_instrumentation<> & instr = pdq.instrumentation();
+    // every push writes at least the new element
+    BOOST_CHECK(instr.stats(op_push).moves >= 100u);
+    for (int i = 0; i < 10; i++) {
+        pdq.pop_top();
+    }
+    BOOST_CHECK(instr.stats(op_pop_top).moves >= 10u);
+    BOOST_CHECK(instr.stats(op_pop_top).levels > 0u);
+
+    // equal elements: a single write per pop, on the level of the root
+    std::vector<int> data(1000, 7);
+    pdq_t equal(data.begin(), data.end());
+    BOOST_CHECK(equal.instrumentation().stats(op_make).moves > 0u);
+    for (int i = 0; i < 10; i++) {
+        equal.pop_top();
+    }
+    BOOST_CHECK_EQUAL(equal.instrumentation().stats(op_pop_top).moves, 10u);
+    BOOST_CHECK_EQUAL(equal.instrumentation().stats(op_pop_top).levels, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestInstrumentationBackends) {
+
+    CheckBackendTracksMoves<dary_minmaxheap_backend<4> >();
+    CheckBackendTracksMoves<interval_heap_backend>();
+}
+
+BOOST_AUTO_TEST_CASE(TestInstrumentationBPQ) {
+
+    counted_bpq bpq(10);
+    for (int i = 0; i < 10; i++) {
+        bpq.push(100 - i);
+    }
+    const counting_instrumentation<true> & instr = bpq.instrumentation();
+    BOOST_CHECK_EQUAL(instr.outcomes(push_inserted), 10u);
+    BOOST_CHECK_EQUAL(instr.outcomes(push_evicted), 0u);
+    BOOST_CHECK_EQUAL(instr.outcomes(push_rejected), 0u);
+
+    // locating the bottom once the queue is full is not counted: the
+    // pushes compare as many times as those of an unbounded queue
+    counted_pdq pdq;
+    for (int i = 0; i < 10; i++) {
+        pdq.push(100 - i);
+    }
+    BOOST_CHECK_EQUAL(instr.stats(op_push).comparisons,
+                      pdq.instrumentation().stats(op_push).comparisons);
+
+    // the queue holds 91..100: smaller elements evict, larger are rejected
+    bpq.push(50);
+    bpq.push(200);
+    bpq.push(201);
+    BOOST_CHECK_EQUAL(instr.outcomes(push_evicted), 1u);
+    BOOST_CHECK_EQUAL(instr.outcomes(push_rejected), 2u);
+    BOOST_CHECK_EQUAL(instr.stats(op_push).calls, 13u);
+    BOOST_CHECK_EQUAL(bpq.top(), 50);
+
+    // every call lands in exactly one latency bucket
+    boost::uint64_t total = 0;
+    for (std::size_t b = 0; b < counting_instrumentation<true>::latency_buckets;
+         b++) {
+        total += instr.stats(op_push).latency[b];
+    }
+    BOOST_CHECK_EQUAL(total, 13u);
+
+    bpq.pop_top();
+    bpq.pop_bottom();
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_top).calls, 1u);
+    BOOST_CHECK_EQUAL(instr.stats(op_pop_bottom).calls, 1u);
+
+    counting_instrumentation<true> copy = instr;
+    copy.reset();
+    BOOST_CHECK_EQUAL(copy.stats(op_push).calls, 0u);
+    BOOST_CHECK_EQUAL(copy.outcomes(push_rejected), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(TestInstrumentationMake) {
+    std::vector<int> data;
+    for (int i = 0; i < 10000; ++i) {
+        data.push_back((i * 7919) % 10000);
+    }
+    counted_pdq pdq(data.begin(), data.end());
+    const counting_instrumentation<> & instr = pdq.instrumentation();
+
+    BOOST_CHECK_EQUAL(instr.stats(op_make).calls, 1u);
+    BOOST_CHECK_EQUAL(instr.stats(op_push).calls, 0u);
+    // linear construction: a few comparisons per element
+    BOOST_CHECK(instr.stats(op_make).comparisons < 4 * data.size());
+    BOOST_CHECK_EQUAL(pdq.top(), 0);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 9999);
+}
@@ -0,0 +1,191 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/interval_heap.hpp>
+#include <sway/bounded_priority_queue.hpp>
+#include <sway/priority_dqueue.hpp>
+#include <vector>
+#include <set>
+#include <string>
+#include <functional>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+template<class T, class Compare>
+void CheckIntervalHeapProperty(const vector<T> & v, Compare comp) {
+	size_t n = v.size();
+	for (size_t k = 0; 2 * k < n; k++) {
+		size_t lo = 2 * k;
+		size_t hi = 2 * k + 1 < n ? 2 * k + 1 : 2 * k;
+		BOOST_REQUIRE(!comp(v[hi], v[lo]));
+		if (k > 0) {
+			// the interval of a node lies within the one of its parent
+			size_t parent = (k - 1) / 2;
+			BOOST_REQUIRE(!comp(v[lo], v[2 * parent]));
+			BOOST_REQUIRE(!comp(v[2 * parent + 1], v[hi]));
+		}
+	}
+}
+
+void CheckIntervalHeapProperty(const vector<int> & v) {
+	CheckIntervalHeapProperty(v, less<int>());
+}
+
+BOOST_AUTO_TEST_CASE(TestIntervalMakeHeap) {
+	srand(7);
+	for (int n = 0; n <= 300; n++) {
+		vector<int> v;
+		for (int i = 0; i < n; i++) {
+			v.push_back(rand() % 1000);
+		}
+		make_interval_heap(v.begin(), v.end());
+		CheckIntervalHeapProperty(v);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestIntervalRandomPushPop) {
+	vector<int> v;
+	multiset<int> reference;
+	srand(42);
+	for (int i = 0; i < 5000; i++) {
+		int op = rand() % 3;
+		if (op == 0 || v.empty()) {
+			int x = rand() % 100;
+			v.push_back(x);
+			push_interval_heap(v.begin(), v.end());
+			reference.insert(x);
+		} else if (op == 1) {
+			BOOST_REQUIRE_EQUAL(*min_interval_heap(v.begin(), v.end()),
+								*reference.begin());
+			popmin_interval_heap(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.begin());
+			v.pop_back();
+			reference.erase(reference.begin());
+		} else {
+			BOOST_REQUIRE_EQUAL(*max_interval_heap(v.begin(), v.end()),
+								*reference.rbegin());
+			popmax_interval_heap(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.rbegin());
+			v.pop_back();
+			reference.erase(--reference.end());
+		}
+		CheckIntervalHeapProperty(v);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestIntervalPushRange) {
+	srand(11);
+	for (int n = 0; n <= 100; n += 3) {
+		for (int added = 0; added <= 150; added += 7) {
+			vector<int> v;
+			for (int i = 0; i < n + added; i++) {
+				v.push_back(rand() % 1000);
+			}
+			make_interval_heap(v.begin(), v.begin() + n);
+			push_range_interval_heap(v.begin(), v.begin() + n, v.end());
+			CheckIntervalHeapProperty(v);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestIntervalReplace) {
+	vector<int> v;
+	multiset<int> reference;
+	srand(46);
+	v.push_back(500);
+	reference.insert(500);
+	for (int i = 0; i < 3000; i++) {
+		int x = rand() % 1000;
+		if (v.size() < 200 && i % 4 == 0) {
+			v.push_back(x);
+			push_interval_heap(v.begin(), v.end());
+		} else if (i % 2 == 0) {
+			replacemin_interval_heap(v.begin(), v.end(), x);
+			reference.erase(reference.begin());
+		} else {
+			replacemax_interval_heap(v.begin(), v.end(), x);
+			reference.erase(--reference.end());
+		}
+		reference.insert(x);
+		CheckIntervalHeapProperty(v);
+		BOOST_REQUIRE_EQUAL(v[0], *reference.begin());
+		BOOST_REQUIRE_EQUAL(*max_interval_heap(v.begin(), v.end()),
+							*reference.rbegin());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestIntervalComp) {
+
+	vector<string> v;
+	for (int i = 0; i < 200; i++) {
+		v.push_back(to_string(1000 + (i * 37) % 200));
+	}
+	make_interval_heap(v.begin(), v.end(), greater<string>());
+	CheckIntervalHeapProperty(v, greater<string>());
+	for (int i = 0; i < 100; i++) {
+		popmin_interval_heap(v.begin(), v.end(), greater<string>());
+		BOOST_REQUIRE_EQUAL(v.back(), to_string(1199 - i));
+		v.pop_back();
+		popmax_interval_heap(v.begin(), v.end(), greater<string>());
+		BOOST_REQUIRE_EQUAL(v.back(), to_string(1000 + i));
+		v.pop_back();
+		CheckIntervalHeapProperty(v, greater<string>());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestIntervalBackend) {
+
+	typedef interval_heap_backend backend;
+	vector<int> data;
+	for (int i = 0; i < 100; i++) {
+		data.push_back((i * 37) % 100);
+	}
+	priority_dqueue<int, vector<int>, less<int>, backend> pdq;
+	bounded_priority_queue<int, vector<int>, less<int>, backend> bpq(10);
+	for (int i = 0; i < 100; i++) {
+		pdq.push(data[i]);
+		bpq.push(data[i]);
+	}
+	bounded_priority_queue<int, vector<int>, less<int>, backend> ranged(10);
+	ranged.push(data.begin(), data.end());
+	BOOST_CHECK_EQUAL(pdq.size(), 100u);
+	BOOST_CHECK_EQUAL(bpq.size(), 10u);
+	BOOST_CHECK_EQUAL(bpq.bottom(), 9);
+	for (int i = 0; i < 10; i++) {
+		BOOST_REQUIRE_EQUAL(bpq.extract_top(), i);
+		BOOST_REQUIRE_EQUAL(ranged.extract_top(), i);
+	}
+	for (int i = 0; i < 50; i++) {
+		BOOST_REQUIRE_EQUAL(pdq.extract_top(), i);
+		BOOST_REQUIRE_EQUAL(pdq.extract_bottom(), 99 - i);
+	}
+	BOOST_CHECK(pdq.empty());
+
+	priority_dqueue<int, vector<int>, less<int>, backend> built(data);
+	BOOST_CHECK_EQUAL(built.top(), 0);
+	BOOST_CHECK_EQUAL(built.bottom(), 99);
+}
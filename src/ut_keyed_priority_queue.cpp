@@ -0,0 +1,168 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/keyed_priority_dqueue.hpp>
+#include <sway/keyed_bounded_priority_queue.hpp>
+#include <sway/interval_heap.hpp>
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+namespace {
+
+struct event {
+	int time;
+	string name;
+	char padding[200];
+	event(int _time, const string & _name) : time(_time), name(_name) {
+	}
+};
+
+struct event_time {
+	int operator()(const event & e) const {
+		return e.time;
+	}
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(TestKeyedPDQ) {
+
+	keyed_priority_dqueue<event, event_time> kpdq;
+	kpdq.push(event(10, "b"));
+	kpdq.emplace(5, "a");
+	event e(20, "d");
+	kpdq.push(std::move(e));
+	kpdq.push(event(15, "c"));
+
+	BOOST_CHECK_EQUAL(kpdq.size(), 4u);
+	BOOST_CHECK_EQUAL(kpdq.top().name, "a");
+	BOOST_CHECK_EQUAL(kpdq.top_key(), 5);
+	BOOST_CHECK_EQUAL(kpdq.bottom().name, "d");
+	BOOST_CHECK_EQUAL(kpdq.bottom_key(), 20);
+
+	kpdq.pop_top();
+	BOOST_CHECK_EQUAL(kpdq.top().name, "b");
+	kpdq.pop_bottom();
+	BOOST_CHECK_EQUAL(kpdq.bottom().name, "c");
+	BOOST_CHECK_EQUAL(kpdq.extract_bottom().name, "c");
+	BOOST_CHECK_EQUAL(kpdq.extract_top().name, "b");
+	BOOST_CHECK(kpdq.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestKeyedPDQRandom) {
+
+	keyed_priority_dqueue<event, event_time, greater<int>,
+						  interval_heap_backend> kpdq;
+	multiset<int> reference;
+	srand(22);
+	for (int i = 0; i < 10000; i++) {
+		int op = rand() % 3;
+		if (op == 0 || reference.empty()) {
+			int x = rand() % 1000;
+			kpdq.emplace(x, to_string(x));
+			reference.insert(x);
+		} else if (op == 1) {
+			event top = kpdq.extract_top();
+			BOOST_REQUIRE_EQUAL(top.time, *reference.rbegin());
+			BOOST_REQUIRE_EQUAL(top.name, to_string(top.time));
+			reference.erase(--reference.end());
+		} else {
+			BOOST_REQUIRE_EQUAL(kpdq.bottom().time, *reference.begin());
+			kpdq.pop_bottom();
+			reference.erase(reference.begin());
+		}
+		BOOST_REQUIRE_EQUAL(kpdq.size(), reference.size());
+		if (!reference.empty()) {
+			BOOST_REQUIRE_EQUAL(kpdq.top_key(), *reference.rbegin());
+			BOOST_REQUIRE_EQUAL(kpdq.bottom_key(), *reference.begin());
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestKeyedPDQRange) {
+
+	vector<event> events;
+	for (int i = 0; i < 100; i++) {
+		int t = (i * 37) % 100;
+		events.push_back(event(t, to_string(t)));
+	}
+	keyed_priority_dqueue<event, event_time> kpdq(events.begin(),
+												  events.begin() + 60);
+	kpdq.push(events.begin() + 60, events.end());
+	BOOST_REQUIRE_EQUAL(kpdq.size(), 100u);
+	for (int i = 0; i < 50; i++) {
+		BOOST_REQUIRE_EQUAL(kpdq.extract_top().name, to_string(i));
+		BOOST_REQUIRE_EQUAL(kpdq.extract_bottom().name, to_string(99 - i));
+	}
+
+	kpdq.push(events.begin(), events.end());
+	keyed_priority_dqueue<event, event_time> moved(std::move(kpdq));
+	BOOST_CHECK(kpdq.empty());
+	BOOST_CHECK_EQUAL(moved.size(), 100u);
+	moved.clear();
+	BOOST_CHECK(moved.empty());
+	BOOST_CHECK((!is_constructible<keyed_priority_dqueue<event, event_time>,
+								   int, int>::value));
+}
+
+BOOST_AUTO_TEST_CASE(TestKeyedBPQ) {
+
+	vector<int> times;
+	keyed_bounded_priority_queue<event, event_time> kbpq(10);
+	BOOST_CHECK_EQUAL(kbpq.max_size(), 10u);
+	srand(23);
+	for (int i = 0; i < 1000; i++) {
+		int t = rand() % 5000;
+		times.push_back(t);
+		if (i % 2 == 0) {
+			kbpq.push(event(t, to_string(t)));
+		} else {
+			kbpq.emplace(t, to_string(t));
+		}
+	}
+	sort(times.begin(), times.end());
+	BOOST_REQUIRE_EQUAL(kbpq.size(), 10u);
+	BOOST_CHECK_EQUAL(kbpq.bottom_key(), times[9]);
+	BOOST_CHECK_EQUAL(kbpq.bottom().name, to_string(times[9]));
+	BOOST_CHECK_EQUAL(kbpq.extract_bottom().time, times[9]);
+	for (int i = 0; i < 9; i++) {
+		BOOST_REQUIRE_EQUAL(kbpq.top_key(), times[i]);
+		BOOST_REQUIRE_EQUAL(kbpq.top().name, to_string(times[i]));
+		kbpq.pop_top();
+	}
+	BOOST_CHECK(kbpq.empty());
+
+	keyed_bounded_priority_queue<event, event_time> empty(0);
+	empty.push(event(1, "1"));
+	BOOST_CHECK(empty.empty());
+}
@@ -0,0 +1,154 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/mergeable_priority_dqueue.hpp>
+#include <functional>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+BOOST_AUTO_TEST_CASE(TestMPDQ) {
+
+	mergeable_priority_dqueue<int> mpdq;
+	BOOST_CHECK(mpdq.empty());
+	mpdq.push(10);
+	mpdq.push(5);
+	mpdq.push(20);
+	mpdq.push(15);
+	BOOST_CHECK_EQUAL(mpdq.size(), 4u);
+	BOOST_CHECK_EQUAL(mpdq.top(), 5);
+	BOOST_CHECK_EQUAL(mpdq.bottom(), 20);
+
+	mpdq.pop_top();
+	BOOST_CHECK_EQUAL(mpdq.top(), 10);
+	mpdq.pop_bottom();
+	BOOST_CHECK_EQUAL(mpdq.bottom(), 15);
+	BOOST_CHECK_EQUAL(mpdq.size(), 2u);
+	BOOST_CHECK_EQUAL(mpdq.extract_top(), 10);
+	BOOST_CHECK_EQUAL(mpdq.extract_bottom(), 15);
+	BOOST_CHECK(mpdq.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestMPDQRandom) {
+
+	// queues and reference multisets, melded into each other at random
+	const int queues = 4;
+	vector<mergeable_priority_dqueue<int, greater<int> > > mpdq(queues);
+	vector<multiset<int> > reference(queues);
+
+	srand(21);
+	for (int i = 0; i < 20000; i++) {
+		int q = rand() % queues;
+		int op = rand() % 8;
+		if (op < 4 || reference[q].empty()) {
+			int x = rand() % 1000;
+			mpdq[q].push(x);
+			reference[q].insert(x);
+		} else if (op == 4) {
+			BOOST_REQUIRE_EQUAL(mpdq[q].extract_top(), *reference[q].rbegin());
+			reference[q].erase(--reference[q].end());
+		} else if (op == 5) {
+			BOOST_REQUIRE_EQUAL(mpdq[q].extract_bottom(),
+								*reference[q].begin());
+			reference[q].erase(reference[q].begin());
+		} else if (op == 6) {
+			int other = rand() % queues;
+			mpdq[q].meld(mpdq[other]);
+			if (other != q) {
+				reference[q].insert(reference[other].begin(),
+									reference[other].end());
+				reference[other].clear();
+				BOOST_REQUIRE(mpdq[other].empty());
+			}
+		} else {
+			mpdq[q].pop_bottom();
+			reference[q].erase(reference[q].begin());
+		}
+		BOOST_REQUIRE_EQUAL(mpdq[q].size(), reference[q].size());
+		if (!reference[q].empty()) {
+			BOOST_REQUIRE_EQUAL(mpdq[q].top(), *reference[q].rbegin());
+			BOOST_REQUIRE_EQUAL(mpdq[q].bottom(), *reference[q].begin());
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestMPDQMeldLarge) {
+
+	mergeable_priority_dqueue<string> a;
+	mergeable_priority_dqueue<string> b;
+	for (int i = 0; i < 1000; i++) {
+		a.push(to_string(10000 + 2 * i));
+		b.emplace(to_string(10001 + 2 * i));
+	}
+	a.meld(b);
+	BOOST_CHECK(b.empty());
+	BOOST_REQUIRE_EQUAL(a.size(), 2000u);
+	// the nodes of b are reused after the meld
+	b.push("x");
+	BOOST_CHECK_EQUAL(b.top(), "x");
+	for (int i = 0; i < 1000; i++) {
+		BOOST_REQUIRE_EQUAL(a.extract_top(), to_string(10000 + i));
+		BOOST_REQUIRE_EQUAL(a.extract_bottom(), to_string(11999 - i));
+	}
+	BOOST_CHECK(a.empty());
+
+	for (int i = 0; i < 100; i++) {
+		a.push(to_string(i));
+	}
+	a.clear();
+	BOOST_CHECK(a.empty());
+	a.push("y");
+	BOOST_CHECK_EQUAL(a.bottom(), "y");
+
+	mergeable_priority_dqueue<string> c(std::move(a));
+	BOOST_CHECK(a.empty());
+	BOOST_CHECK_EQUAL(c.size(), 1u);
+	BOOST_CHECK_EQUAL(c.top(), "y");
+}
+
+struct unique_less {
+	bool operator()(const unique_ptr<int> & a,
+					const unique_ptr<int> & b) const {
+		return *a < *b;
+	}
+};
+
+BOOST_AUTO_TEST_CASE(TestMPDQMoveOnly) {
+
+	mergeable_priority_dqueue<unique_ptr<int>, unique_less> mpdq;
+	for (int i = 0; i < 100; i++) {
+		mpdq.push(unique_ptr<int>(new int((i * 37) % 100)));
+	}
+	BOOST_CHECK_EQUAL(*mpdq.top(), 0);
+	BOOST_CHECK_EQUAL(*mpdq.bottom(), 99);
+	unique_ptr<int> p = mpdq.extract_bottom();
+	BOOST_CHECK_EQUAL(*p, 99);
+	BOOST_CHECK_EQUAL(mpdq.size(), 99u);
+}
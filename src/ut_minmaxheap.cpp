@@ -27,7 +27,11 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <sway/detail/minmaxheap.hpp>
 #include <vector>
 #include <iostream>
+#include <limits>
 #include <stack>
+#include <set>
+#include <cstdlib>
+#include <stdexcept>
 
 using namespace std;
 using namespace sway;
@@ -297,3 +301,447 @@ BOOST_AUTO_TEST_CASE(TestSmallExceed) {
 
 	BOOST_CHECK_EQUAL(a[0], 5);
 }
+
+BOOST_AUTO_TEST_CASE(TestRandomPushPop) {
+
+	vector<int> v;
+	multiset<int> reference;
+
+	srand(42);
+	for (int i = 0; i < 2000; i++) {
+		int op = rand() % 3;
+		if (op == 0 || v.empty()) {
+			int x = rand() % 100;
+			v.push_back(x);
+			push_minmaxheap(v.begin(), v.end());
+			reference.insert(x);
+		} else if (op == 1) {
+			popmin_minmaxheap(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.begin());
+			v.pop_back();
+			reference.erase(reference.begin());
+		} else {
+			popmax_minmaxheap(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.rbegin());
+			v.pop_back();
+			reference.erase(--reference.end());
+		}
+		CheckMinMaxHeapProperty(v);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestMakeHeapSizes) {
+
+	srand(7);
+	for (int n = 0; n <= 300; n++) {
+		vector<int> v;
+		for (int i = 0; i < n; i++) {
+			v.push_back(rand() % 1000);
+		}
+		make_minmaxheap(v.begin(), v.end());
+		CheckMinMaxHeapProperty(v);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestPushRange) {
+
+	srand(11);
+	for (int n = 0; n <= 70; n++) {
+		for (int m = 0; m <= 70; m++) {
+			vector<int> v;
+			for (int i = 0; i < n; i++) {
+				v.push_back(rand() % 100);
+			}
+			make_minmaxheap(v.begin(), v.end());
+			for (int i = 0; i < m; i++) {
+				v.push_back(rand() % 100);
+			}
+			vector<int> sorted(v);
+			sort(sorted.begin(), sorted.end());
+			push_range_minmaxheap(v.begin(), v.begin() + n, v.end());
+			CheckMinMaxHeapProperty(v);
+			vector<int> after(v);
+			sort(after.begin(), after.end());
+			BOOST_REQUIRE(after == sorted);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestPushRangeComp) {
+
+	int a[300];
+	vector<int *> v;
+	for (int i = 0; i < 300; i++) {
+		a[i] = (i * 37) % 300;
+	}
+	for (int i = 0; i < 100; i++) {
+		v.push_back(a + i);
+	}
+	make_minmaxheap(v.begin(), v.end(), IndirectComp<int>());
+	for (int i = 100; i < 300; i++) {
+		v.push_back(a + i);
+	}
+	push_range_minmaxheap(v.begin(), v.begin() + 100, v.end(),
+						  IndirectComp<int>());
+
+	CheckMinMaxHeapPropertyPtr(v);
+}
+
+BOOST_AUTO_TEST_CASE(TestSortHeap) {
+
+	srand(5);
+	for (int n = 0; n <= 100; n++) {
+		vector<int> v;
+		for (int i = 0; i < n; i++) {
+			v.push_back(rand() % 50);
+		}
+		vector<int> sorted(v);
+		sort(sorted.begin(), sorted.end());
+		make_minmaxheap(v.begin(), v.end());
+		sort_minmaxheap(v.begin(), v.end());
+		BOOST_REQUIRE(v == sorted);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestPartialSortBothEnds) {
+
+	srand(9);
+	for (int n = 0; n <= 40; n++) {
+		for (int k_low = 0; k_low <= n; k_low++) {
+			for (int k_high = 0; k_high <= n - k_low + 1; k_high++) {
+				vector<int> v;
+				for (int i = 0; i < n; i++) {
+					v.push_back(rand() % 30);
+				}
+				vector<int> sorted(v);
+				sort(sorted.begin(), sorted.end());
+				partial_sort_both_ends(v.begin(), v.end(), k_low, k_high);
+				int high = min(k_high, n);
+				BOOST_REQUIRE(equal(v.begin(), v.begin() + k_low,
+									sorted.begin()));
+				BOOST_REQUIRE(equal(v.end() - high, v.end(),
+									sorted.end() - high));
+				sort(v.begin(), v.end());
+				BOOST_REQUIRE(v == sorted);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestPartialSortBothEndsComp) {
+
+	int a[50];
+	vector<int *> v;
+	for (int i = 0; i < 50; i++) {
+		a[i] = (i * 13) % 50;
+		v.push_back(a + i);
+	}
+
+	partial_sort_both_ends(v.begin(), v.end(), 5, 3, IndirectComp<int>());
+
+	for (int i = 0; i < 5; i++) {
+		BOOST_CHECK_EQUAL(*v[i], i);
+	}
+	for (int i = 0; i < 3; i++) {
+		BOOST_CHECK_EQUAL(*v[47 + i], 47 + i);
+	}
+}
+
+/* Hides the comparator type, so that the scalar code paths are taken. */
+template<class Compare>
+struct OpaqueComp {
+	Compare comp;
+	template<class T>
+	bool operator()(const T & a, const T & b) {
+		return comp(a, b);
+	}
+};
+
+template<class T, class Compare>
+void CheckSameAsScalar(int range) {
+	srand(13);
+	for (int n = 0; n < 200; n++) {
+		vector<T> v;
+		for (int i = 0; i < n; i++) {
+			v.push_back(static_cast<T>(rand() % range - range / 2));
+		}
+		vector<T> w(v);
+		make_minmaxheap(v.begin(), v.end(), Compare());
+		make_minmaxheap(w.begin(), w.end(), OpaqueComp<Compare>());
+		BOOST_REQUIRE(v == w);
+		for (int i = 0; i < n / 2; i++) {
+			popmin_minmaxheap(v.begin(), v.end() - 2 * i, Compare());
+			popmin_minmaxheap(w.begin(), w.end() - 2 * i, OpaqueComp<Compare>());
+			popmax_minmaxheap(v.begin(), v.end() - 2 * i - 1, Compare());
+			popmax_minmaxheap(w.begin(), w.end() - 2 * i - 1,
+							  OpaqueComp<Compare>());
+			BOOST_REQUIRE(v == w);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestVectorizedSelectionSameAsScalar) {
+	CheckSameAsScalar<int32_t, less<int32_t> >(10);
+	CheckSameAsScalar<int32_t, greater<int32_t> >(1000);
+	CheckSameAsScalar<int64_t, less<int64_t> >(10);
+	CheckSameAsScalar<int64_t, greater<int64_t> >(1000);
+	CheckSameAsScalar<float, less<float> >(10);
+	CheckSameAsScalar<float, greater<float> >(1000);
+	CheckSameAsScalar<double, less<double> >(10);
+	CheckSameAsScalar<double, greater<double> >(1000);
+}
+
+BOOST_AUTO_TEST_CASE(TestVectorizedSelectionPointers) {
+	int32_t a[7] = { 0, 9, 8, 5, 3, 3, 1 };
+	BOOST_CHECK(get_smallest_child_or_grandchild(a, a + 7, a) == a + 6);
+	BOOST_CHECK(get_largest_child_or_grandchild(a, a + 7, a) == a + 1);
+	int32_t b[7] = { 0, 9, 8, 3, 4, 3, 1 };
+	BOOST_CHECK(get_smallest_child_or_grandchild(b, b + 7, b,
+												 greater<int32_t>()) == b + 1);
+	BOOST_CHECK(get_largest_child_or_grandchild(b, b + 7, b,
+												greater<int32_t>()) == b + 6);
+}
+
+template<class T>
+void CheckNaNSelection() {
+	const T nan = numeric_limits<T>::quiet_NaN();
+	// a NaN right child makes the vector reduction NaN, equal to nothing
+	T a[7] = { 0, 5, nan, 7, 2, 6, 4 };
+	BOOST_CHECK(get_smallest_child_or_grandchild(a, a + 7, a, less<T>()) ==
+				get_smallest_child_or_grandchild(a, a + 7, a,
+												 OpaqueComp<less<T> >()));
+	BOOST_CHECK(get_largest_child_or_grandchild(a, a + 7, a, less<T>()) ==
+				get_largest_child_or_grandchild(a, a + 7, a,
+												OpaqueComp<less<T> >()));
+	T b[7] = { 0, nan, nan, nan, nan, nan, nan };
+	BOOST_CHECK(get_smallest_child_or_grandchild(b, b + 7, b,
+												 greater<T>()) == b + 1);
+	BOOST_CHECK(get_largest_child_or_grandchild(b, b + 7, b,
+												greater<T>()) == b + 1);
+	// the heap operations stay within the range and lose no element
+	srand(17);
+	vector<T> v;
+	for (int i = 0; i < 500; i++) {
+		v.push_back(rand() % 7 == 0 ? nan : static_cast<T>(rand() % 100));
+		push_minmaxheap(v.begin(), v.end(), less<T>());
+	}
+	size_t nans = 0;
+	for (size_t i = 0; i < v.size(); i++) {
+		nans += v[i] != v[i];
+	}
+	for (size_t n = v.size(); n > 0; n--) {
+		if (n % 2) {
+			popmin_minmaxheap(v.begin(), v.begin() + n, less<T>());
+		} else {
+			popmax_minmaxheap(v.begin(), v.begin() + n, less<T>());
+		}
+	}
+	size_t after = 0;
+	for (size_t i = 0; i < v.size(); i++) {
+		after += v[i] != v[i];
+	}
+	BOOST_CHECK_EQUAL(after, nans);
+}
+
+BOOST_AUTO_TEST_CASE(TestVectorizedSelectionNaN) {
+	CheckNaNSelection<float>();
+	CheckNaNSelection<double>();
+}
+
+BOOST_AUTO_TEST_CASE(TestBottomUpPushPop) {
+
+	vector<int> v;
+	multiset<int> reference;
+
+	srand(43);
+	for (int i = 0; i < 3000; i++) {
+		int op = rand() % 3;
+		if (op == 0 || v.empty()) {
+			int x = rand() % 100;
+			v.push_back(x);
+			push_minmaxheap(v.begin(), v.end());
+			reference.insert(x);
+		} else if (op == 1) {
+			popmin_bottom_up_minmaxheap(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.begin());
+			v.pop_back();
+			reference.erase(reference.begin());
+		} else {
+			popmax_bottom_up_minmaxheap(v.begin(), v.end());
+			BOOST_REQUIRE_EQUAL(v.back(), *reference.rbegin());
+			v.pop_back();
+			reference.erase(--reference.end());
+		}
+		CheckMinMaxHeapProperty(v);
+	}
+}
+
+struct CountingLess {
+	size_t * count;
+	CountingLess(size_t * _count) : count(_count) {
+	}
+	bool operator()(int a, int b) const {
+		++*count;
+		return a < b;
+	}
+};
+
+BOOST_AUTO_TEST_CASE(TestBottomUpComparisons) {
+
+	vector<int> v;
+	srand(44);
+	for (int i = 0; i < 10000; i++) {
+		v.push_back(rand());
+	}
+	make_minmaxheap(v.begin(), v.end());
+	vector<int> w(v);
+
+	size_t top_down = 0, bottom_up = 0;
+	for (vector<int>::iterator last = v.end(); last != v.begin(); --last) {
+		popmin_minmaxheap(v.begin(), last, CountingLess(&top_down));
+	}
+	for (vector<int>::iterator last = w.end(); last != w.begin(); --last) {
+		popmin_bottom_up_minmaxheap(w.begin(), last, CountingLess(&bottom_up));
+	}
+	BOOST_CHECK(v == w);
+	BOOST_CHECK_LT(bottom_up * 3, top_down * 2);
+}
+
+BOOST_AUTO_TEST_CASE(TestUpdateErase) {
+
+	vector<int> v;
+	multiset<int> reference;
+
+	srand(45);
+	for (int i = 0; i < 500; i++) {
+		int x = rand() % 1000;
+		v.push_back(x);
+		reference.insert(x);
+	}
+	make_minmaxheap(v.begin(), v.end());
+	for (int i = 0; i < 3000; i++) {
+		vector<int>::iterator pos = v.begin() + rand() % v.size();
+		if (i % 3 == 0 && v.size() > 1) {
+			int old = *pos;
+			erase_minmaxheap(v.begin(), v.end(), pos);
+			BOOST_REQUIRE_EQUAL(v.back(), old);
+			v.pop_back();
+			reference.erase(reference.find(old));
+		} else {
+			int x = rand() % 1000;
+			reference.erase(reference.find(*pos));
+			reference.insert(x);
+			*pos = x;
+			update_minmaxheap(v.begin(), v.end(), pos);
+		}
+		CheckMinMaxHeapProperty(v);
+		BOOST_REQUIRE_EQUAL(*min_minmaxheap(v.begin(), v.end()),
+							*reference.begin());
+		BOOST_REQUIRE_EQUAL(*max_minmaxheap(v.begin(), v.end()),
+							*reference.rbegin());
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestReplace) {
+
+	vector<int> v;
+	multiset<int> reference;
+
+	srand(46);
+	v.push_back(500);
+	reference.insert(500);
+	for (int i = 0; i < 3000; i++) {
+		int x = rand() % 1000;
+		if (v.size() < 200 && i % 4 == 0) {
+			v.push_back(x);
+			push_minmaxheap(v.begin(), v.end());
+		} else if (i % 2 == 0) {
+			replacemin_minmaxheap(v.begin(), v.end(), x);
+			reference.erase(reference.begin());
+		} else {
+			replacemax_minmaxheap(v.begin(), v.end(), x);
+			reference.erase(--reference.end());
+		}
+		reference.insert(x);
+		CheckMinMaxHeapProperty(v);
+		BOOST_REQUIRE_EQUAL(*min_minmaxheap(v.begin(), v.end()),
+							*reference.begin());
+		BOOST_REQUIRE_EQUAL(*max_minmaxheap(v.begin(), v.end()),
+							*reference.rbegin());
+	}
+}
+
+// throws on the given comparison, counting from one
+struct CountdownLess {
+	int * left;
+	bool operator()(int a, int b) const {
+		if (--*left == 0) {
+			throw runtime_error("comparison failed");
+		}
+		return a < b;
+	}
+};
+
+enum HeapOperation {
+	op_make, op_push, op_popmin, op_popmax, op_popmin_bottom_up,
+	op_popmax_bottom_up, op_update, op_erase, op_count
+};
+
+void RunHeapOperation(HeapOperation op, vector<int> & v, CountdownLess comp) {
+	vector<int>::iterator heap_end = v.end() - 1;
+	switch (op) {
+	case op_make:
+		make_minmaxheap(v.begin(), v.end(), comp);
+		break;
+	case op_push:
+		push_minmaxheap(v.begin(), v.end(), comp);
+		break;
+	case op_popmin:
+		popmin_minmaxheap(v.begin(), heap_end, comp);
+		break;
+	case op_popmax:
+		popmax_minmaxheap(v.begin(), heap_end, comp);
+		break;
+	case op_popmin_bottom_up:
+		popmin_bottom_up_minmaxheap(v.begin(), heap_end, comp);
+		break;
+	case op_popmax_bottom_up:
+		popmax_bottom_up_minmaxheap(v.begin(), heap_end, comp);
+		break;
+	case op_update:
+		// the smallest value on a max level, below a min level parent
+		swap(v[0], v[40]);
+		update_minmaxheap(v.begin(), heap_end, v.begin() + 40, comp);
+		break;
+	case op_erase:
+		erase_minmaxheap(v.begin(), heap_end, v.begin() + 40, comp);
+		break;
+	default:
+		break;
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestThrowingComparatorKeepsElements) {
+
+	for (int op = 0; op < op_count; op++) {
+		for (int throw_at = 1; throw_at <= 40; throw_at++) {
+			srand(47 + throw_at);
+			vector<int> v;
+			for (int i = 0; i < 100; i++) {
+				v.push_back(rand() % 1000);
+			}
+			make_minmaxheap(v.begin(), v.end() - 1);
+			vector<int> before(v);
+			sort(before.begin(), before.end());
+
+			int left = throw_at;
+			CountdownLess comp = { &left };
+			try {
+				RunHeapOperation(static_cast<HeapOperation>(op), v, comp);
+			} catch (const runtime_error &) {
+			}
+			sort(v.begin(), v.end());
+			BOOST_CHECK(v == before);
+		}
+	}
+}
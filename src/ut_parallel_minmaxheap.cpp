@@ -0,0 +1,125 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/parallel_minmaxheap.hpp>
+#include <sway/detail/minmaxheap.hpp>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+/*
+Checks each element against its parent and grandparent, which implies the
+min-max heap property and takes linear time on the large heaps built here.
+*/
+template<class Compare>
+void CheckMinMaxHeapLocal(vector<int> & v, Compare comp) {
+	for (size_t k = 1; k < v.size(); k++) {
+		vector<int>::iterator i = v.begin() + k;
+		bool min_level = get_level(v.begin(), v.end(), i) % 2 == 0;
+		vector<int>::iterator p = get_parent(v.begin(), v.end(), i);
+		if (min_level) {
+			BOOST_REQUIRE(!comp(*p, *i));
+		} else {
+			BOOST_REQUIRE(!comp(*i, *p));
+		}
+		if (k >= 3) {
+			vector<int>::iterator g = get_parent(v.begin(), v.end(), p);
+			if (min_level) {
+				BOOST_REQUIRE(!comp(*i, *g));
+			} else {
+				BOOST_REQUIRE(!comp(*g, *i));
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelMakeHeap) {
+
+	srand(11);
+	const size_t sizes[] = { 0, 1, 2, 100, 65535, 65536, 100000, 262143,
+							 262144, 300001 };
+	const unsigned threads[] = { 1, 2, 3, 7, 16 };
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		vector<int> input;
+		for (size_t i = 0; i < sizes[s]; i++) {
+			input.push_back(rand());
+		}
+		vector<int> sorted(input);
+		sort(sorted.begin(), sorted.end());
+		for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+			vector<int> v(input);
+			make_parallel_minmaxheap(v.begin(), v.end(), threads[t]);
+			CheckMinMaxHeapLocal(v, less<int>());
+			vector<int> w(v);
+			sort(w.begin(), w.end());
+			BOOST_REQUIRE(w == sorted);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestParallelMakeHeapComp) {
+
+	srand(12);
+	vector<int> v;
+	for (int i = 0; i < 200000; i++) {
+		v.push_back(rand() % 1000);
+	}
+	make_parallel_minmaxheap(v.begin(), v.end(), greater<int>(), 4);
+	CheckMinMaxHeapLocal(v, greater<int>());
+	BOOST_CHECK_EQUAL(v[0], *max_element(v.begin(), v.end()));
+}
+
+struct ThrowingLess {
+	int * count;
+	bool operator()(int a, int b) const {
+		if (__atomic_add_fetch(count, 1, __ATOMIC_RELAXED) == 50000) {
+			throw runtime_error("comparison failed");
+		}
+		return a < b;
+	}
+};
+
+BOOST_AUTO_TEST_CASE(TestParallelMakeHeapThrows) {
+
+	vector<int> v;
+	// a permutation of 0 ... 199999, since 7919 is prime to 200000
+	for (int i = 0; i < 200000; i++) {
+		v.push_back(static_cast<int>(i * 7919LL % 200000));
+	}
+	int count = 0;
+	ThrowingLess comp = { &count };
+	BOOST_CHECK_THROW(make_parallel_minmaxheap(v.begin(), v.end(), comp, 4),
+					  runtime_error);
+	// no element is lost or duplicated by the interrupted trickle downs
+	sort(v.begin(), v.end());
+	for (int i = 0; i < 200000; i++) {
+		BOOST_REQUIRE_EQUAL(v[i], i);
+	}
+}
@@ -24,6 +24,14 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <boost/test/unit_test.hpp>
 
 #include <sway/priority_dqueue.hpp>
+#include <sway/instrumentation.hpp>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 using namespace sway;
 
@@ -43,3 +51,306 @@ BOOST_AUTO_TEST_CASE(TestPDQ) {
     pdq.push(3);
     BOOST_CHECK_EQUAL(pdq.top(), 3);
 }
+
+BOOST_AUTO_TEST_CASE(TestPDQPushRange) {
+
+    priority_dqueue<int> pdq;
+
+    pdq.push(10);
+    pdq.push(5);
+
+    std::vector<int> data;
+    for (int i = 0; i < 50; i++) {
+        data.push_back((i * 7) % 50 + 1);
+    }
+    pdq.push(data.begin(), data.end());
+
+    BOOST_CHECK_EQUAL(pdq.size(), 52u);
+    BOOST_CHECK_EQUAL(pdq.top(), 1);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 50);
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQReplace) {
+
+    priority_dqueue<int> pdq;
+
+    pdq.push(10);
+    pdq.push(5);
+    pdq.push(20);
+    pdq.push(15);
+
+    pdq.replace_top(30);
+    BOOST_CHECK_EQUAL(pdq.size(), 4);
+    BOOST_CHECK_EQUAL(pdq.top(), 10);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 30);
+
+    pdq.replace_bottom(1);
+    BOOST_CHECK_EQUAL(pdq.size(), 4);
+    BOOST_CHECK_EQUAL(pdq.top(), 1);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 20);
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQConstructRange) {
+
+    std::vector<int> data;
+    for (int i = 0; i < 1000; i++) {
+        data.push_back((i * 37) % 1000 + 1);
+    }
+
+    priority_dqueue<int> from_range(data.begin(), data.end());
+    BOOST_CHECK_EQUAL(from_range.size(), 1000u);
+    BOOST_CHECK_EQUAL(from_range.top(), 1);
+    BOOST_CHECK_EQUAL(from_range.bottom(), 1000);
+
+    priority_dqueue<int> from_copy(data);
+    BOOST_CHECK_EQUAL(from_copy.size(), 1000u);
+    BOOST_CHECK_EQUAL(from_copy.top(), 1);
+    BOOST_CHECK_EQUAL(from_copy.bottom(), 1000);
+    BOOST_CHECK_EQUAL(data.size(), 1000u);
+
+    std::vector<int> moved(data);
+    priority_dqueue<int> from_move(std::move(moved));
+    BOOST_CHECK_EQUAL(from_move.size(), 1000u);
+    BOOST_CHECK_EQUAL(from_move.top(), 1);
+    BOOST_CHECK_EQUAL(from_move.bottom(), 1000);
+    BOOST_CHECK(moved.empty());
+
+    // the range constructors do not take integers
+    BOOST_CHECK((!std::is_constructible<priority_dqueue<int>, int, int>::value));
+    BOOST_CHECK((!std::is_constructible<
+                 priority_dqueue<unsigned, std::vector<unsigned>,
+                                 std::less<unsigned>, radix_backend<8> >,
+                 unsigned, unsigned>::value));
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQAssign) {
+
+    priority_dqueue<int> pdq;
+    pdq.push(10);
+    pdq.push(-5);
+
+    std::vector<int> data;
+    for (int i = 0; i < 100; i++) {
+        data.push_back((i * 7) % 100 + 1);
+    }
+    pdq.assign(data.begin(), data.end());
+    BOOST_CHECK_EQUAL(pdq.size(), 100u);
+    BOOST_CHECK_EQUAL(pdq.top(), 1);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 100);
+
+    pdq.assign(std::vector<int>(data.begin(), data.begin() + 10));
+    BOOST_CHECK_EQUAL(pdq.size(), 10u);
+    BOOST_CHECK_EQUAL(pdq.top(), 1);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 64);
+
+    pdq.assign(std::vector<int>());
+    BOOST_CHECK(pdq.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQPop) {
+
+    priority_dqueue<int> pdq;
+    for (int i = 0; i < 100; i++) {
+        pdq.push((i * 37) % 100);
+    }
+
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK_EQUAL(pdq.top(), i);
+        pdq.pop_top();
+        BOOST_CHECK_EQUAL(pdq.bottom(), 99 - i);
+        pdq.pop_bottom();
+    }
+    BOOST_CHECK_EQUAL(pdq.size(), 80u);
+    for (int i = 10; i < 50; i++) {
+        BOOST_CHECK_EQUAL(pdq.extract_top(), i);
+        BOOST_CHECK_EQUAL(pdq.extract_bottom(), 99 - i);
+    }
+    BOOST_CHECK(pdq.empty());
+}
+
+struct unique_less {
+    bool operator()(const std::unique_ptr<int> & a,
+                    const std::unique_ptr<int> & b) const {
+        return *a < *b;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(TestPDQMoveOnly) {
+
+    priority_dqueue<std::unique_ptr<int>,
+                    std::vector<std::unique_ptr<int> >,
+                    unique_less> pdq;
+    for (int i = 0; i < 50; i++) {
+        std::unique_ptr<int> p(new int((i * 7) % 50));
+        pdq.push(std::move(p));
+        BOOST_CHECK(!p);
+        pdq.emplace(new int(100 + i));
+    }
+    BOOST_CHECK_EQUAL(pdq.size(), 100u);
+    BOOST_CHECK_EQUAL(*pdq.top(), 0);
+    BOOST_CHECK_EQUAL(*pdq.bottom(), 149);
+
+    std::unique_ptr<int> top = pdq.extract_top();
+    BOOST_CHECK_EQUAL(*top, 0);
+    std::unique_ptr<int> bottom = pdq.extract_bottom();
+    BOOST_CHECK_EQUAL(*bottom, 149);
+    BOOST_CHECK_EQUAL(pdq.size(), 98u);
+    BOOST_CHECK_EQUAL(*pdq.top(), 1);
+    BOOST_CHECK_EQUAL(*pdq.bottom(), 148);
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQRadixSelection) {
+
+    // the radix specialization is only used when asked for
+    BOOST_CHECK((std::is_same<default_backend<unsigned short,
+                                              std::less<unsigned short> >::type,
+                              minmaxheap_backend>::value));
+    BOOST_CHECK((std::is_same<default_backend<unsigned char,
+                                              std::greater<unsigned char> >::type,
+                              minmaxheap_backend>::value));
+    priority_dqueue<unsigned short> pdq;
+    pdq.push(5);
+    pdq.push(3);
+    const unsigned short & top = pdq.top();
+    BOOST_CHECK_EQUAL(top, 3);
+}
+
+template<class Compare>
+void CheckRadixAgainstMultiset(Compare comp) {
+    typedef priority_dqueue<unsigned, std::vector<unsigned>, Compare,
+                            radix_backend<20> > pdq_t;
+    pdq_t pdq;
+    std::multiset<unsigned, Compare> ref(comp);
+    srand(11);
+    for (int i = 0; i < 20000; i++) {
+        int op = rand() % 8;
+        if (op < 4 || ref.empty()) {
+            // clustered keys, to exercise the duplicates and the summary words
+            unsigned key = rand() % 2 ? rand() % 300 : rand() % (1 << 20);
+            pdq.push(key);
+            ref.insert(key);
+        } else if (op == 4) {
+            BOOST_REQUIRE_EQUAL(pdq.extract_top(), *ref.begin());
+            ref.erase(ref.begin());
+        } else if (op == 5) {
+            BOOST_REQUIRE_EQUAL(pdq.extract_bottom(), *ref.rbegin());
+            ref.erase(std::prev(ref.end()));
+        } else if (op == 6) {
+            unsigned key = rand() % 1000;
+            pdq.replace_top(key);
+            ref.erase(ref.begin());
+            ref.insert(key);
+        } else {
+            unsigned key = rand() % 1000;
+            pdq.replace_bottom(key);
+            ref.erase(std::prev(ref.end()));
+            ref.insert(key);
+        }
+        BOOST_REQUIRE_EQUAL(pdq.size(), ref.size());
+        if (!ref.empty()) {
+            BOOST_REQUIRE_EQUAL(pdq.top(), *ref.begin());
+            BOOST_REQUIRE_EQUAL(pdq.bottom(), *ref.rbegin());
+        }
+    }
+    while (!ref.empty()) {
+        BOOST_REQUIRE_EQUAL(pdq.top(), *ref.begin());
+        pdq.pop_top();
+        ref.erase(ref.begin());
+    }
+    BOOST_CHECK(pdq.empty());
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQRadix) {
+
+    CheckRadixAgainstMultiset(std::less<unsigned>());
+    CheckRadixAgainstMultiset(std::greater<unsigned>());
+
+    priority_dqueue<unsigned, std::vector<unsigned>, std::less<unsigned>,
+                    radix_backend<10> > pdq;
+    BOOST_CHECK_THROW(pdq.push(1024), std::out_of_range);
+    BOOST_CHECK(pdq.empty());
+    pdq.push(1023);
+    BOOST_CHECK_EQUAL(pdq.top(), 1023u);
+
+    // a window of timestamps far from 0
+    const unsigned long long base = 1700000000000ull;
+    priority_dqueue<unsigned long long, std::vector<unsigned long long>,
+                    std::greater<unsigned long long>,
+                    radix_backend<12> > window(base);
+    BOOST_CHECK_EQUAL(window.base(), base);
+    BOOST_CHECK_THROW(window.push(base - 1), std::out_of_range);
+    BOOST_CHECK_THROW(window.push(base + 4096), std::out_of_range);
+    window.push(base + 4095);
+    window.push(base);
+    window.push(base + 17);
+    BOOST_CHECK_EQUAL(window.top(), base + 4095);
+    BOOST_CHECK_EQUAL(window.bottom(), base);
+    window.replace_top(base + 3);
+    BOOST_CHECK_EQUAL(window.extract_top(), base + 17);
+    BOOST_CHECK_EQUAL(window.extract_bottom(), base);
+    BOOST_CHECK_EQUAL(window.top(), base + 3);
+    BOOST_CHECK_EQUAL(window.size(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(TestPDQRadixConstructAssign) {
+
+    std::vector<unsigned short> data;
+    for (int i = 0; i < 5000; i++) {
+        data.push_back(static_cast<unsigned short>((i * 7919) % 65536));
+    }
+    typedef priority_dqueue<unsigned short, std::vector<unsigned short>,
+                            std::less<unsigned short>,
+                            radix_backend<16> > radix_pdq;
+    radix_pdq pdq(data.begin(), data.end());
+    BOOST_CHECK_EQUAL(pdq.size(), 5000u);
+    BOOST_CHECK_EQUAL(pdq.top(), 0);
+
+    // few elements, then many: both ways of clearing the buckets
+    std::vector<unsigned short> few(data.begin(), data.begin() + 3);
+    pdq.assign(few);
+    BOOST_CHECK_EQUAL(pdq.size(), 3u);
+    BOOST_CHECK_EQUAL(pdq.bottom(), 2 * 7919);
+    pdq.push(data.begin(), data.end());
+    pdq.assign(data);
+    BOOST_CHECK_EQUAL(pdq.size(), 5000u);
+
+    priority_dqueue<unsigned short, std::vector<unsigned short>,
+                    std::less<unsigned short>, radix_backend<16>,
+                    counting_instrumentation<> > counted(data);
+    counted.emplace(7);
+    counted.pop_top();
+    BOOST_CHECK_EQUAL(counted.instrumentation().stats(op_make).calls, 1u);
+    BOOST_CHECK_EQUAL(counted.instrumentation().stats(op_push).calls, 1u);
+    BOOST_CHECK_EQUAL(counted.instrumentation().stats(op_pop_top).calls, 1u);
+
+    // moved containers, and a base with the container and range constructors
+    std::vector<unsigned short> owned(few);
+    radix_pdq moved(std::move(owned));
+    BOOST_CHECK_EQUAL(moved.size(), 3u);
+    owned = data;
+    moved.assign(std::move(owned));
+    BOOST_CHECK_EQUAL(moved.size(), 5000u);
+    BOOST_CHECK_EQUAL(moved.top(), 0);
+
+    typedef priority_dqueue<unsigned, std::vector<unsigned>,
+                            std::greater<unsigned>,
+                            radix_backend<8> > window_pdq;
+    const unsigned base = 1000000;
+    std::vector<unsigned> keys;
+    keys.push_back(base + 3);
+    keys.push_back(base + 255);
+    keys.push_back(base);
+    window_pdq from_container(keys, base);
+    BOOST_CHECK_EQUAL(from_container.base(), base);
+    BOOST_CHECK_EQUAL(from_container.top(), base + 255);
+    BOOST_CHECK_EQUAL(from_container.bottom(), base);
+    std::vector<unsigned> owned_keys(keys);
+    window_pdq from_moved(std::move(owned_keys), base,
+                          std::greater<unsigned>());
+    BOOST_CHECK_EQUAL(from_moved.size(), 3u);
+    window_pdq from_range(keys.begin(), keys.end(), base);
+    BOOST_CHECK_EQUAL(from_range.size(), 3u);
+    BOOST_CHECK_EQUAL(from_range.extract_top(), base + 255);
+    BOOST_CHECK_EQUAL(from_range.top(), base + 3);
+    BOOST_CHECK_THROW(window_pdq out_of_window(keys), std::out_of_range);
+}
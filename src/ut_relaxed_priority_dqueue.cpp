@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/relaxed_priority_dqueue.hpp>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <cstdlib>
+
+using namespace std;
+using namespace sway;
+
+BOOST_AUTO_TEST_CASE(TestRelaxedSingleShard) {
+
+	// with a single shard the order is exact
+	relaxed_priority_dqueue<int> q(1);
+	srand(15);
+	vector<int> data;
+	for (int i = 0; i < 1000; i++) {
+		data.push_back(rand() % 100);
+		q.push(data.back());
+	}
+	BOOST_CHECK_EQUAL(q.size(), 1000u);
+	sort(data.begin(), data.end());
+	int value;
+	for (int i = 0; i < 500; i++) {
+		BOOST_REQUIRE(q.try_pop_top(value));
+		BOOST_REQUIRE_EQUAL(value, data[i]);
+	}
+	for (int i = 999; i >= 500; i--) {
+		BOOST_REQUIRE(q.try_pop_bottom(value));
+		BOOST_REQUIRE_EQUAL(value, data[i]);
+	}
+	BOOST_CHECK(q.empty());
+	value = -1;
+	BOOST_CHECK(!q.try_pop_top(value));
+	BOOST_CHECK(!q.try_pop_bottom(value));
+	BOOST_CHECK_EQUAL(value, -1);
+}
+
+BOOST_AUTO_TEST_CASE(TestRelaxedPeek) {
+
+	// at rest the peeks are exact, whatever the number of shards
+	relaxed_priority_dqueue<int, greater<int> > q(8);
+	int value = -1;
+	BOOST_CHECK(!q.try_peek_top(value));
+	BOOST_CHECK(!q.try_peek_bottom(value));
+	BOOST_CHECK_EQUAL(value, -1);
+	srand(16);
+	vector<int> data;
+	for (int i = 0; i < 1000; i++) {
+		data.push_back(rand() % 10000);
+		q.push(data.back());
+	}
+	sort(data.begin(), data.end());
+	while (!data.empty()) {
+		BOOST_REQUIRE(q.try_peek_top(value));
+		BOOST_REQUIRE_EQUAL(value, data.back());
+		BOOST_REQUIRE(q.try_peek_bottom(value));
+		BOOST_REQUIRE_EQUAL(value, data.front());
+		BOOST_REQUIRE(q.try_pop_bottom(value));
+		data.erase(find(data.begin(), data.end(), value));
+	}
+	BOOST_CHECK(!q.try_peek_top(value));
+}
+
+BOOST_AUTO_TEST_CASE(TestRelaxedPeekThreads) {
+
+	// the peeks never see an element that was not pushed, nor the default
+	// value cached by a shard before its first push
+	const int threads = 4;
+	const int per_thread = 20000;
+	relaxed_priority_dqueue<int> q(threads * 4);
+	atomic<bool> done(false);
+	atomic<int> bad(0);
+	vector<thread> pool;
+	for (int t = 0; t < threads; t++) {
+		pool.push_back(thread([&q, t]() {
+			int value;
+			for (int i = 0; i < per_thread; i++) {
+				q.push(1 + t * per_thread + i);
+				if (i % 2 == 0) {
+					q.try_pop_top(value);
+				}
+			}
+		}));
+	}
+	thread peeker([&q, &done, &bad]() {
+		while (!done.load()) {
+			int top, bottom;
+			if (q.try_peek_top(top) &&
+				(top < 1 || top > threads * per_thread)) {
+				++bad;
+			}
+			if (q.try_peek_bottom(bottom) &&
+				(bottom < 1 || bottom > threads * per_thread)) {
+				++bad;
+			}
+		}
+	});
+	for (int t = 0; t < threads; t++) {
+		pool[t].join();
+	}
+	done.store(true);
+	peeker.join();
+	BOOST_CHECK_EQUAL(bad.load(), 0);
+	int top, bottom, value;
+	BOOST_REQUIRE(q.try_peek_top(top));
+	BOOST_REQUIRE(q.try_peek_bottom(bottom));
+	BOOST_REQUIRE(q.try_pop_top(value));
+	BOOST_CHECK(value >= top);
+	BOOST_CHECK(value <= bottom);
+}
+
+BOOST_AUTO_TEST_CASE(TestRelaxedShards) {
+
+	relaxed_priority_dqueue<int, greater<int> > q(8);
+	vector<int> data;
+	for (int i = 0; i < 5000; i++) {
+		data.push_back(i);
+		q.push(i);
+	}
+	vector<int> popped;
+	int value;
+	size_t rank_error = 0;
+	while (q.try_pop_top(value)) {
+		popped.push_back(value);
+		// with greater, the highest priority element left is 4999 - popped
+		rank_error += 4999 - (popped.size() - 1) - value;
+	}
+	BOOST_CHECK(q.empty());
+	sort(popped.begin(), popped.end());
+	BOOST_CHECK(popped == data);
+	// the ranks are not exact, but far from those of a random order
+	BOOST_CHECK(rank_error < 5000u * 100);
+}
+
+BOOST_AUTO_TEST_CASE(TestRelaxedStrings) {
+
+	relaxed_priority_dqueue<string> q(4);
+	vector<string> data;
+	for (int i = 0; i < 200; i++) {
+		data.push_back(string(1, 'a' + i % 26) + string(i / 26, 'z'));
+		q.push(data.back());
+	}
+	vector<string> popped;
+	string value;
+	while (q.try_pop_bottom(value)) {
+		popped.push_back(value);
+	}
+	sort(popped.begin(), popped.end());
+	sort(data.begin(), data.end());
+	BOOST_CHECK(popped == data);
+}
+
+BOOST_AUTO_TEST_CASE(TestRelaxedThreads) {
+
+	const int threads = 4;
+	const int per_thread = 20000;
+	relaxed_priority_dqueue<int> q(threads * 2);
+	vector<vector<int> > popped(threads);
+	vector<thread> pool;
+	for (int t = 0; t < threads; t++) {
+		pool.push_back(thread([&q, &popped, t]() {
+			int value;
+			for (int i = 0; i < per_thread; i++) {
+				q.push(t * per_thread + i);
+				if (i % 3 == 0 && q.try_pop_top(value)) {
+					popped[t].push_back(value);
+				}
+				if (i % 5 == 0 && q.try_pop_bottom(value)) {
+					popped[t].push_back(value);
+				}
+			}
+		}));
+	}
+	for (int t = 0; t < threads; t++) {
+		pool[t].join();
+	}
+	vector<int> all;
+	for (int t = 0; t < threads; t++) {
+		all.insert(all.end(), popped[t].begin(), popped[t].end());
+	}
+	int value;
+	while (q.try_pop_top(value)) {
+		all.push_back(value);
+	}
+	sort(all.begin(), all.end());
+	BOOST_REQUIRE_EQUAL(all.size(), size_t(threads * per_thread));
+	for (int i = 0; i < threads * per_thread; i++) {
+		BOOST_REQUIRE_EQUAL(all[i], i);
+	}
+}
@@ -0,0 +1,283 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/bounded_priority_queue.hpp>
+#include <sway/inline_vector.hpp>
+#include <sway/mapped_vector.hpp>
+#include <sway/priority_dqueue.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+using namespace sway;
+
+namespace {
+
+string SnapshotPath(const char * name) {
+	return "/tmp/sway_ut_" + to_string(::getpid()) + "_" + name;
+}
+
+struct order {
+	int price;
+	int id;
+	double quantity;
+};
+
+bool operator<(const order & a, const order & b) {
+	return a.price < b.price || (a.price == b.price && a.id < b.id);
+}
+
+/*
+Rewrites the count and capacity in the header of the snapshot at path,
+with a valid header checksum if resealed.
+*/
+void RewriteHeader(const string & path, boost::uint64_t count,
+				   boost::uint64_t capacity, bool resealed) {
+	FILE * f = fopen(path.c_str(), "r+b");
+	BOOST_REQUIRE(f);
+	detail::snapshot_header header;
+	BOOST_REQUIRE_EQUAL(fread(&header, sizeof(header), 1, f), 1u);
+	header.count = count;
+	header.capacity = capacity;
+	if (resealed) {
+		header.header_checksum = detail::snapshot_header_checksum(header);
+	}
+	fseek(f, 0, SEEK_SET);
+	BOOST_REQUIRE_EQUAL(fwrite(&header, sizeof(header), 1, f), 1u);
+	fclose(f);
+}
+
+order MakeOrder(int i) {
+	order o;
+	o.price = rand() % 1000;
+	o.id = i;
+	o.quantity = i * 0.5;
+	return o;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotPDQ) {
+	string path = SnapshotPath("pdq");
+	priority_dqueue<int> pdq;
+	srand(1);
+	for (int i = 0; i < 10000; i++) {
+		pdq.push(rand() % 100000);
+	}
+	pdq.save(path);
+
+	priority_dqueue<int> copied;
+	copied.push(42);
+	copied.load(path);
+	priority_dqueue<int, mapped_vector<int> > mapped;
+	mapped.load(path);
+	priority_dqueue<int, deque<int> > generic;
+	generic.load(path);
+	BOOST_CHECK_EQUAL(copied.size(), pdq.size());
+	BOOST_CHECK_EQUAL(mapped.size(), pdq.size());
+	BOOST_CHECK_EQUAL(generic.size(), pdq.size());
+
+	// the restored queues keep working, the mapped one growing in place
+	// and then out of the mapping
+	for (int i = 0; i < 30000; i++) {
+		int value = rand() % 100000;
+		pdq.push(value);
+		copied.push(value);
+		mapped.push(value);
+		generic.push(value);
+	}
+	while (!pdq.empty()) {
+		BOOST_REQUIRE_EQUAL(copied.top(), pdq.top());
+		BOOST_REQUIRE_EQUAL(mapped.top(), pdq.top());
+		BOOST_REQUIRE_EQUAL(mapped.bottom(), pdq.bottom());
+		BOOST_REQUIRE_EQUAL(generic.bottom(), pdq.bottom());
+		pdq.pop_top();
+		copied.pop_top();
+		mapped.pop_top();
+		generic.pop_top();
+	}
+	BOOST_CHECK(mapped.empty());
+
+	// the file is left unchanged by the writes to the mapping
+	priority_dqueue<int, mapped_vector<int> > again;
+	again.load(path);
+	BOOST_CHECK_EQUAL(again.size(), 10000u);
+	std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotBPQ) {
+	string path = SnapshotPath("bpq");
+	srand(2);
+	for (size_t pushed = 50; pushed <= 500; pushed += 450) {
+		// not full and full
+		bounded_priority_queue<order> bpq(100);
+		for (size_t i = 0; i < pushed; i++) {
+			bpq.push(MakeOrder(static_cast<int>(i)));
+		}
+		bpq.save(path);
+
+		bounded_priority_queue<order> copied(1);
+		copied.load(path);
+		bounded_priority_queue<order, mapped_vector<order> > mapped(1);
+		mapped.load(path);
+		bounded_priority_queue<order, deque<order> > generic(1);
+		generic.load(path);
+		BOOST_CHECK_EQUAL(copied.max_size(), 100u);
+		BOOST_CHECK_EQUAL(mapped.max_size(), 100u);
+		BOOST_CHECK_EQUAL(generic.max_size(), 100u);
+		BOOST_CHECK_EQUAL(generic.size(), bpq.size());
+		BOOST_CHECK_EQUAL(copied.size(), bpq.size());
+		BOOST_CHECK_EQUAL(mapped.size(), bpq.size());
+
+		for (int i = 0; i < 1000; i++) {
+			order o = MakeOrder(1000 + i);
+			bpq.push(o);
+			copied.push(o);
+			mapped.push(o);
+			generic.push(o);
+			BOOST_REQUIRE_EQUAL(mapped.bottom().id, bpq.bottom().id);
+			BOOST_REQUIRE_EQUAL(generic.bottom().id, bpq.bottom().id);
+		}
+		while (!bpq.empty()) {
+			BOOST_REQUIRE_EQUAL(copied.top().id, bpq.top().id);
+			BOOST_REQUIRE_EQUAL(generic.top().id, bpq.top().id);
+			BOOST_REQUIRE_EQUAL(mapped.top().id, bpq.top().id);
+			BOOST_REQUIRE_EQUAL(mapped.top().quantity, bpq.top().quantity);
+			bpq.pop_top();
+			copied.pop_top();
+			mapped.pop_top();
+			generic.pop_top();
+		}
+	}
+	std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotErrors) {
+	string path = SnapshotPath("errors");
+	priority_dqueue<int> pdq;
+	BOOST_CHECK_THROW(pdq.load(path), snapshot_error);
+
+	for (int i = 0; i < 1000; i++) {
+		pdq.push(i);
+	}
+	pdq.save(path);
+	priority_dqueue<double> wrong_size;
+	BOOST_CHECK_THROW(wrong_size.load(path), snapshot_error);
+
+	// a flipped byte in the elements
+	FILE * f = fopen(path.c_str(), "r+b");
+	BOOST_REQUIRE(f);
+	fseek(f, 100, SEEK_SET);
+	int c = fgetc(f);
+	fseek(f, 100, SEEK_SET);
+	fputc(c ^ 1, f);
+	fclose(f);
+	priority_dqueue<int> corrupted;
+	BOOST_CHECK_THROW(corrupted.load(path), snapshot_error);
+	priority_dqueue<int, deque<int> > corrupted_generic;
+	corrupted_generic.push(3);
+	BOOST_CHECK_THROW(corrupted_generic.load(path), snapshot_error);
+	BOOST_CHECK_EQUAL(corrupted_generic.size(), 1u);
+	priority_dqueue<int, mapped_vector<int> > corrupted_mapped;
+	BOOST_CHECK_THROW(corrupted_mapped.load(path), snapshot_error);
+
+	// a truncated file
+	pdq.save(path);
+	BOOST_REQUIRE_EQUAL(::truncate(path.c_str(), 1000), 0);
+	BOOST_CHECK_THROW(corrupted.load(path), snapshot_error);
+	BOOST_CHECK(corrupted.empty());
+	std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestSnapshotCorruptHeader) {
+	string path = SnapshotPath("header");
+	priority_dqueue<int> pdq;
+	for (int i = 0; i < 1000; i++) {
+		pdq.push(i);
+	}
+	bounded_priority_queue<int> bpq(100);
+	bounded_priority_queue<int, mapped_vector<int> > mapped_bpq(1);
+	priority_dqueue<int, mapped_vector<int> > mapped;
+	priority_dqueue<int> copied;
+
+	// a changed capacity is caught by the header checksum
+	pdq.save(path);
+	RewriteHeader(path, 1000, boost::uint64_t(1) << 60, false);
+	BOOST_CHECK_THROW(bpq.load(path), snapshot_error);
+	BOOST_CHECK_THROW(mapped_bpq.load(path), snapshot_error);
+
+	// a capacity whose byte length overflows, or a count that does not
+	// match the file, are rejected even with a valid header checksum,
+	// before anything is allocated or mapped
+	RewriteHeader(path, 1000, boost::uint64_t(1) << 62, true);
+	BOOST_CHECK_THROW(bpq.load(path), snapshot_error);
+	BOOST_CHECK_THROW(mapped_bpq.load(path), snapshot_error);
+	RewriteHeader(path, 1000000, 1000000, true);
+	BOOST_CHECK_THROW(copied.load(path), snapshot_error);
+	BOOST_CHECK_THROW(mapped.load(path), snapshot_error);
+	BOOST_CHECK(copied.empty());
+	BOOST_CHECK_EQUAL(bpq.max_size(), 100u);
+
+	// a snapshot larger than a fixed capacity container
+	pdq.save(path);
+	priority_dqueue<int, inline_vector<int, 8> > small;
+	BOOST_CHECK_THROW(small.load(path), snapshot_error);
+	bounded_priority_queue<int, inline_vector<int, 8> > small_bpq(8);
+	BOOST_CHECK_THROW(small_bpq.load(path), snapshot_error);
+	std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(TestMappedVector) {
+	mapped_vector<int> v;
+	BOOST_CHECK(v.empty());
+	for (int i = 0; i < 100; i++) {
+		v.push_back(i);
+		v.push_back(v[0]);
+	}
+	BOOST_CHECK_EQUAL(v.size(), 200u);
+	BOOST_CHECK_EQUAL(v.back(), 0);
+	BOOST_CHECK_EQUAL(v[198], 99);
+	vector<int> data(5, 7);
+	v.insert(v.begin(), data.begin(), data.end());
+	BOOST_CHECK_EQUAL(v.size(), 205u);
+	BOOST_CHECK_EQUAL(v[4], 7);
+	BOOST_CHECK_EQUAL(v[5], 0);
+	mapped_vector<int> copy(v);
+	mapped_vector<int> moved(std::move(v));
+	BOOST_CHECK_EQUAL(copy.size(), 205u);
+	BOOST_CHECK_EQUAL(moved[204], 0);
+	copy.resize(300);
+	BOOST_CHECK_EQUAL(copy[299], 0);
+	copy.pop_back();
+	BOOST_CHECK_EQUAL(copy.size(), 299u);
+	copy = moved;
+	BOOST_CHECK_EQUAL(copy.size(), 205u);
+	copy.clear();
+	BOOST_CHECK(copy.empty());
+}
@@ -0,0 +1,185 @@
+/*
+Copyright (c) 2011, Andrea Sansottera
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+ - Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+ - Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <boost/test/unit_test.hpp>
+
+#include <sway/top_k.hpp>
+#include <vector>
+#include <list>
+#include <sstream>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <cstdlib>
+#include <limits>
+
+using namespace std;
+using namespace sway;
+
+vector<int> RandomVector(size_t n, unsigned seed) {
+	srand(seed);
+	vector<int> v;
+	for (size_t i = 0; i < n; i++) {
+		v.push_back(rand() % 1000);
+	}
+	return v;
+}
+
+BOOST_AUTO_TEST_CASE(TestTopK) {
+
+	// k below and above the selection threshold, and larger than n
+	const size_t ks[] = { 0, 1, 5, 60, 999, 1000, 1500 };
+	vector<int> data = RandomVector(1000, 16);
+	vector<int> sorted(data);
+	sort(sorted.begin(), sorted.end());
+	for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+		size_t k = min(ks[i], data.size());
+		vector<int> expected(sorted.begin(), sorted.begin() + k);
+
+		vector<int> result;
+		top_k(data.begin(), data.end(), ks[i], back_inserter(result));
+		BOOST_CHECK(result == expected);
+
+		// from a list, streamed through the heap
+		list<int> l(data.begin(), data.end());
+		result.clear();
+		top_k(l.begin(), l.end(), ks[i], back_inserter(result));
+		BOOST_CHECK(result == expected);
+
+		result.clear();
+		top_k(data.begin(), data.end(), ks[i], back_inserter(result),
+			  unsorted_result);
+		sort(result.begin(), result.end());
+		BOOST_CHECK(result == expected);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestBottomK) {
+
+	const size_t ks[] = { 0, 1, 7, 100, 1000, 2000 };
+	vector<int> data = RandomVector(1000, 17);
+	vector<int> sorted(data);
+	sort(sorted.begin(), sorted.end(), greater<int>());
+	for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+		size_t k = min(ks[i], data.size());
+		vector<int> expected(sorted.begin(), sorted.begin() + k);
+
+		vector<int> result(k);
+		vector<int>::iterator end =
+			bottom_k(data.begin(), data.end(), ks[i], result.begin());
+		BOOST_CHECK(end == result.end());
+		BOOST_CHECK(result == expected);
+
+		// with greater, the bottom elements are the smallest ones
+		result.clear();
+		bottom_k(data.begin(), data.end(), ks[i], back_inserter(result),
+				 greater<int>(), unsorted_result);
+		sort(result.begin(), result.end());
+		vector<int> smallest(sorted.rbegin(), sorted.rbegin() + k);
+		BOOST_CHECK(result == smallest);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestExtremesK) {
+
+	const size_t ks[] = { 0, 3, 40, 400, 500, 700, 2000 };
+	vector<int> data = RandomVector(1000, 18);
+	vector<int> sorted(data);
+	sort(sorted.begin(), sorted.end());
+	for (size_t i = 0; i < sizeof(ks) / sizeof(ks[0]); i++) {
+		size_t k = min(ks[i], data.size());
+		vector<int> expected_top(sorted.begin(), sorted.begin() + k);
+		vector<int> expected_bottom(sorted.rbegin(), sorted.rbegin() + k);
+
+		vector<int> top, bottom;
+		extremes_k(data.begin(), data.end(), ks[i], back_inserter(top),
+				   back_inserter(bottom));
+		BOOST_CHECK(top == expected_top);
+		BOOST_CHECK(bottom == expected_bottom);
+
+		list<int> l(data.begin(), data.end());
+		top.clear();
+		bottom.clear();
+		extremes_k(l.begin(), l.end(), ks[i], back_inserter(top),
+				   back_inserter(bottom), less<int>(), unsorted_result);
+		sort(top.begin(), top.end());
+		sort(bottom.begin(), bottom.end(), greater<int>());
+		BOOST_CHECK(top == expected_top);
+		BOOST_CHECK(bottom == expected_bottom);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(TestTopKInputIterator) {
+
+	istringstream in("5 3 9 1 7 3 8");
+	vector<int> result;
+	top_k(istream_iterator<int>(in), istream_iterator<int>(), 3,
+		  back_inserter(result));
+	BOOST_REQUIRE_EQUAL(result.size(), 3u);
+	BOOST_CHECK_EQUAL(result[0], 1);
+	BOOST_CHECK_EQUAL(result[1], 3);
+	BOOST_CHECK_EQUAL(result[2], 3);
+}
+
+BOOST_AUTO_TEST_CASE(TestTopKHugeK) {
+
+	// k far beyond the input must neither allocate k elements nor overflow
+	// the selection threshold
+	const size_t huge[] = { size_t(1) << (numeric_limits<size_t>::digits - 5),
+							numeric_limits<size_t>::max() };
+	vector<int> data = RandomVector(100, 19);
+	vector<int> sorted(data);
+	sort(sorted.begin(), sorted.end());
+	vector<int> reversed(sorted.rbegin(), sorted.rend());
+	for (size_t i = 0; i < sizeof(huge) / sizeof(huge[0]); i++) {
+		vector<int> result;
+		top_k(data.begin(), data.end(), huge[i], back_inserter(result));
+		BOOST_CHECK(result == sorted);
+
+		list<int> l(data.begin(), data.end());
+		result.clear();
+		top_k(l.begin(), l.end(), huge[i], back_inserter(result));
+		BOOST_CHECK(result == sorted);
+
+		istringstream in("5 3 9 1");
+		result.clear();
+		top_k(istream_iterator<int>(in), istream_iterator<int>(), huge[i],
+			  back_inserter(result));
+		BOOST_REQUIRE_EQUAL(result.size(), 4u);
+		BOOST_CHECK_EQUAL(result[0], 1);
+		BOOST_CHECK_EQUAL(result[3], 9);
+
+		vector<int> top, bottom;
+		extremes_k(data.begin(), data.end(), huge[i], back_inserter(top),
+				   back_inserter(bottom));
+		BOOST_CHECK(top == sorted);
+		BOOST_CHECK(bottom == reversed);
+
+		top.clear();
+		bottom.clear();
+		extremes_k(l.begin(), l.end(), huge[i], back_inserter(top),
+				   back_inserter(bottom));
+		BOOST_CHECK(top == sorted);
+		BOOST_CHECK(bottom == reversed);
+	}
+}